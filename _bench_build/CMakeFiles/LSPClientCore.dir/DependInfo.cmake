@@ -0,0 +1,35 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/LSP.cpp" "CMakeFiles/LSPClientCore.dir/src/LSP.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSP.cpp.o.d"
+  "/root/repo/src/LSPClientCore.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPClientCore.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPClientCore.cpp.o.d"
+  "/root/repo/src/LSPDiagnostics.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPDiagnostics.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPDiagnostics.cpp.o.d"
+  "/root/repo/src/LSPEdits.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPEdits.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPEdits.cpp.o.d"
+  "/root/repo/src/LSPEventLoop.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPEventLoop.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPEventLoop.cpp.o.d"
+  "/root/repo/src/LSPFileWatcher.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPFileWatcher.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPFileWatcher.cpp.o.d"
+  "/root/repo/src/LSPFramer.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPFramer.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPFramer.cpp.o.d"
+  "/root/repo/src/LSPJson.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPJson.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPJson.cpp.o.d"
+  "/root/repo/src/LSPMetrics.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPMetrics.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPMetrics.cpp.o.d"
+  "/root/repo/src/LSPProgress.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPProgress.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPProgress.cpp.o.d"
+  "/root/repo/src/LSPReactor.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPReactor.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPReactor.cpp.o.d"
+  "/root/repo/src/LSPScheduler.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPScheduler.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPScheduler.cpp.o.d"
+  "/root/repo/src/LSPServerProcess.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPServerProcess.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPServerProcess.cpp.o.d"
+  "/root/repo/src/LSPSpans.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPSpans.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPSpans.cpp.o.d"
+  "/root/repo/src/LSPStderr.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPStderr.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPStderr.cpp.o.d"
+  "/root/repo/src/LSPSymbolCache.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPSymbolCache.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPSymbolCache.cpp.o.d"
+  "/root/repo/src/LSPTrace.cpp" "CMakeFiles/LSPClientCore.dir/src/LSPTrace.cpp.o" "gcc" "CMakeFiles/LSPClientCore.dir/src/LSPTrace.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
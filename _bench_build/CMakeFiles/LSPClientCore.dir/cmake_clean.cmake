@@ -0,0 +1,43 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/LSPClientCore.dir/src/LSP.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSP.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPClientCore.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPClientCore.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPDiagnostics.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPDiagnostics.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPEdits.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPEdits.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPEventLoop.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPEventLoop.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPFileWatcher.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPFileWatcher.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPFramer.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPFramer.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPJson.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPJson.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPMetrics.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPMetrics.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPProgress.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPProgress.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPReactor.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPReactor.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPScheduler.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPScheduler.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPServerProcess.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPServerProcess.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPSpans.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPSpans.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPStderr.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPStderr.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPSymbolCache.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPSymbolCache.cpp.o.d"
+  "CMakeFiles/LSPClientCore.dir/src/LSPTrace.cpp.o"
+  "CMakeFiles/LSPClientCore.dir/src/LSPTrace.cpp.o.d"
+  "libLSPClientCore.a"
+  "libLSPClientCore.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/LSPClientCore.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
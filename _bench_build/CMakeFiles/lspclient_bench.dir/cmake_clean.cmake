@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lspclient_bench.dir/bench/ProtocolBench.cpp.o"
+  "CMakeFiles/lspclient_bench.dir/bench/ProtocolBench.cpp.o.d"
+  "lspclient_bench"
+  "lspclient_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lspclient_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
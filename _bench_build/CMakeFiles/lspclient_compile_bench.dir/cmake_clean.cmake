@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lspclient_compile_bench.dir/bench/CompileBench.cpp.o"
+  "CMakeFiles/lspclient_compile_bench.dir/bench/CompileBench.cpp.o.d"
+  "lspclient_compile_bench"
+  "lspclient_compile_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lspclient_compile_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
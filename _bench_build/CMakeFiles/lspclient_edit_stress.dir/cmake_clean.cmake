@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lspclient_edit_stress.dir/bench/EditStress.cpp.o"
+  "CMakeFiles/lspclient_edit_stress.dir/bench/EditStress.cpp.o.d"
+  "lspclient_edit_stress"
+  "lspclient_edit_stress.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lspclient_edit_stress.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
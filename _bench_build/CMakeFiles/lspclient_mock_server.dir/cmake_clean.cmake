@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lspclient_mock_server.dir/bench/MockServer.cpp.o"
+  "CMakeFiles/lspclient_mock_server.dir/bench/MockServer.cpp.o.d"
+  "lspclient_mock_server"
+  "lspclient_mock_server.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lspclient_mock_server.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
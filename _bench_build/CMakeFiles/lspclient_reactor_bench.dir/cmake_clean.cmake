@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lspclient_reactor_bench.dir/bench/ReactorBench.cpp.o"
+  "CMakeFiles/lspclient_reactor_bench.dir/bench/ReactorBench.cpp.o.d"
+  "lspclient_reactor_bench"
+  "lspclient_reactor_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lspclient_reactor_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,9 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lspclient_sample_consumer.dir/bench/SampleConsumer.cpp.o"
+  "CMakeFiles/lspclient_sample_consumer.dir/bench/SampleConsumer.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lspclient_sample_consumer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
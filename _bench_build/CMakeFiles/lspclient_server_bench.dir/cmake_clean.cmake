@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lspclient_server_bench.dir/bench/ServerBench.cpp.o"
+  "CMakeFiles/lspclient_server_bench.dir/bench/ServerBench.cpp.o.d"
+  "lspclient_server_bench"
+  "lspclient_server_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lspclient_server_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lspclient_trace_replay.dir/bench/TraceReplay.cpp.o"
+  "CMakeFiles/lspclient_trace_replay.dir/bench/TraceReplay.cpp.o.d"
+  "lspclient_trace_replay"
+  "lspclient_trace_replay.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lspclient_trace_replay.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
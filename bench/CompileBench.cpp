@@ -0,0 +1,144 @@
+// Compile-time benchmark: runs the compiler the library was built with over
+// bench/SampleConsumer.cpp, a translation unit of an editor that uses the
+// protocol types, once per way of including them:
+//
+//   baseline   only the standard headers LSPTypes.hpp pulls in
+//   types      LSPTypes.hpp, the structs without their serializers
+//   protocol   LSP.hpp, converting the structs to and from json
+//
+// The difference between the modes is what a consumer pays for each header.
+// Results are written as one JSON document, like lspclient_bench:
+//
+//   {"suite": "lspclient_compile_bench", "version": "1.0.0", "compiler": "/usr/bin/c++",
+//    "flags": "-O0", "results": [{"name": "types", "runs": 5, "minSec": 0.48, "medianSec": 0.5}, ...]}
+//
+//   lspclient_compile_bench [--runs=N] [--flags="-O2 ..."] [--output=file]
+
+#include <LSPJson.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#ifndef LSPCLIENT_VERSION
+#define LSPCLIENT_VERSION "unknown"
+#endif
+#ifndef LSPCLIENT_CXX
+#define LSPCLIENT_CXX "c++"
+#endif
+#ifndef LSPCLIENT_CXX_STANDARD
+#define LSPCLIENT_CXX_STANDARD "14"
+#endif
+#ifndef LSPCLIENT_SOURCE_DIR
+#define LSPCLIENT_SOURCE_DIR "."
+#endif
+
+namespace
+{
+
+struct Options
+{
+    int runs = 5;
+    std::string flags = "-O0";
+    std::string output;
+};
+
+struct Mode
+{
+    const char *name;
+    const char *define;
+};
+
+const Mode modes[] = {
+    {"baseline", "-DLSPCLIENT_SAMPLE_BASELINE"},
+    {"types", "-DLSPCLIENT_SAMPLE_TYPES_ONLY"},
+    {"protocol", ""},
+};
+
+std::string quoted(const std::string &text)
+{
+    return "\"" + text + "\"";
+}
+
+// Seconds one compilation took, negative if the compiler failed
+double compileOnce(const Options &options, const Mode &mode, const std::string &object)
+{
+    std::string source = LSPCLIENT_SOURCE_DIR;
+    std::string command = quoted(LSPCLIENT_CXX) + " -std=c++" LSPCLIENT_CXX_STANDARD " " + options.flags + " " +
+                          mode.define + " -I" + quoted(source + "/include") + " -I" +
+                          quoted(source + "/third_party") + " -c " + quoted(source + "/bench/SampleConsumer.cpp") +
+                          " -o " + quoted(object);
+    auto start = std::chrono::steady_clock::now();
+    int status = std::system(command.c_str());
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::remove(object.c_str());
+    return status == 0 ? seconds : -1;
+}
+
+bool parseArguments(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        auto value = [&argument](const char *prefix) { return argument.substr(std::strlen(prefix)); };
+        if (argument.compare(0, 7, "--runs=") == 0)
+            options.runs = std::atoi(value("--runs=").c_str());
+        else if (argument.compare(0, 8, "--flags=") == 0)
+            options.flags = value("--flags=");
+        else if (argument.compare(0, 9, "--output=") == 0)
+            options.output = value("--output=");
+        else
+            return false;
+    }
+    return options.runs > 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseArguments(argc, argv, options))
+    {
+        std::fprintf(stderr, "usage: %s [--runs=N] [--flags=\"-O2 ...\"] [--output=file]\n", argv[0]);
+        return 2;
+    }
+
+    json results = json::array();
+    for (auto &mode : modes)
+    {
+        std::vector<double> times;
+        for (int run = 0; run < options.runs; ++run)
+        {
+            double seconds = compileOnce(options, mode, "lspclient_compile_bench.o");
+            if (seconds < 0)
+            {
+                std::fprintf(stderr, "compiling the %s sample failed\n", mode.name);
+                return 1;
+            }
+            times.push_back(seconds);
+        }
+        std::sort(times.begin(), times.end());
+        results.push_back({{"name", mode.name},
+                           {"runs", options.runs},
+                           {"minSec", times.front()},
+                           {"medianSec", times[times.size() / 2]}});
+    }
+
+    json report = {{"suite", "lspclient_compile_bench"},
+                   {"version", LSPCLIENT_VERSION},
+                   {"compiler", LSPCLIENT_CXX},
+                   {"flags", options.flags},
+                   {"results", results}};
+    std::string text = report.dump(2) + "\n";
+    if (options.output.empty())
+    {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        return 0;
+    }
+    std::ofstream file(options.output, std::ios::binary);
+    file << text;
+    return file.good() ? 0 : 1;
+}
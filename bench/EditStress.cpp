@@ -0,0 +1,427 @@
+// Drives randomized incremental didChange edits into a server at a set rate,
+// like a fast paste or a macro replayed in the editor, and checks that the
+// server's copy of the document still matches the client's.
+//
+// Against lspclient_mock_server (the default) the $/mock/checksum extension is
+// asked every --check-every notifications for the server's version, length and
+// hash of the text, which must equal what the harness got by applying the same
+// edits with plain string operations. With a real server ("-- clangd ...") there
+// is nothing to ask, and only rates and costs are reported.
+//
+// --kills=N kills the server with SIGKILL N times, evenly spread over the run,
+// with restarts enabled: the client has to bring the new server to its current
+// copy of the document, so the checks after each recovery must still match.
+// Checks are not sent while the client is recovering, and the ones the crash
+// cut off are counted as lost rather than as mismatches.
+//
+// Reported: didChange notifications and edits per second actually sustained,
+// CPU time per edit of this process and of the server, wall time per didChange
+// call, and how much the resident memory of this process grew.
+//
+//   lspclient_edit_stress [--rate=notifications/s] [--seconds=N] [--batch=edits] [--size=bytes]
+//                         [--check-every=N] [--seed=N] [--track-text] [--kills=N] [--output=file]
+//                         [--server=path | -- server arguments...]
+
+#include <LSPClientCore.hpp>
+#include <LSPEventLoop.hpp>
+#include <LSPServerProcess.hpp>
+#include <LSPSymbolCache.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <signal.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifndef LSPCLIENT_VERSION
+#define LSPCLIENT_VERSION "unknown"
+#endif
+#ifndef LSPCLIENT_MOCK_SERVER
+#define LSPCLIENT_MOCK_SERVER "lspclient_mock_server"
+#endif
+
+namespace
+{
+
+using Clock = LSPEventLoop::Clock;
+
+const char *const documentUri = "file:///stress/edited.cpp";
+// Stop writing while this much is still waiting for the server's stdin
+const int64_t maxBytesToWrite = 4 << 20;
+
+double msecSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double cpuMsec()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto msec = [](const timeval &time) { return time.tv_sec * 1000.0 + time.tv_usec / 1000.0; };
+    return msec(usage.ru_utime) + msec(usage.ru_stime);
+}
+
+// User and system time of another process, -1 if it can't be read
+double processCpuMsec(pid_t pid)
+{
+    std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+    std::string stat((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t name = stat.rfind(')');
+    if (name == std::string::npos)
+        return -1;
+    // utime and stime are the 14th and 15th field, the 12th and 13th after the command name
+    std::istringstream fields(stat.substr(name + 1));
+    std::string skipped;
+    for (int field = 1; field < 12; ++field)
+        fields >> skipped;
+    double utime = 0, stime = 0;
+    if (!(fields >> utime >> stime))
+        return -1;
+    return (utime + stime) * 1000.0 / static_cast<double>(sysconf(_SC_CLK_TCK));
+}
+
+int64_t residentKiB()
+{
+    std::ifstream file("/proc/self/statm");
+    int64_t size = 0, resident = 0;
+    file >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+// The document and random edits to it, applied with plain string operations so they
+// don't share any code with how the server applies them
+class EditGenerator
+{
+  public:
+    EditGenerator(uint64_t seed, size_t size) : random(seed), targetSize(size)
+    {
+        static const char *const lines[] = {
+            "int value = compute(first, second);\n", "    return std::max(lhs, rhs); // größer\n",
+            "struct Point { double x, y; };\n", "// 🚀 fast path\n", "\n", "for (auto &item : items) {}\n"};
+        while (text.size() < size)
+            text += lines[random() % (sizeof(lines) / sizeof(lines[0]))];
+    }
+
+    const std::string &content() const
+    {
+        return text;
+    }
+
+    TextDocumentContentChangeEvent next()
+    {
+        static const char *const pieces[] = {"a", "x", "_", " ", "\n", "(", ")", "{}", ";", "é", "😀", "foo", "42"};
+        size_t start = boundary(random() % (text.size() + 1));
+        size_t length = 0;
+        // Deletes win out once the document grew too large, inserts once it shrank
+        unsigned kind = random() % 3;
+        if (text.size() > targetSize * 2)
+            kind = 1;
+        else if (text.size() < targetSize / 2)
+            kind = 0;
+        if (kind != 0)
+            length = boundary(std::min(text.size(), start + 1 + random() % 24)) - start;
+        std::string inserted;
+        if (kind != 1)
+        {
+            for (size_t count = 1 + random() % 16; count > 0; --count)
+                inserted += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+        }
+
+        TextDocumentContentChangeEvent change;
+        change.range = Range{positionOf(start), positionOf(start + length)};
+        change.text = inserted;
+        text.replace(start, length, inserted);
+        return change;
+    }
+
+  private:
+    std::mt19937_64 random;
+    size_t targetSize;
+    std::string text;
+
+    // Moves back to the first byte of a UTF-8 sequence
+    size_t boundary(size_t offset) const
+    {
+        while (offset > 0 && offset < text.size() && (static_cast<unsigned char>(text[offset]) & 0xC0) == 0x80)
+            --offset;
+        return offset;
+    }
+
+    // Line and UTF-8 column, the offsetEncoding the client negotiates
+    Position positionOf(size_t offset) const
+    {
+        Position position;
+        size_t lineStart = 0;
+        for (const char *newline = static_cast<const char *>(std::memchr(text.data(), '\n', offset));
+             newline != nullptr;
+             newline = static_cast<const char *>(std::memchr(newline + 1, '\n', offset - lineStart)))
+        {
+            ++position.line;
+            lineStart = static_cast<size_t>(newline - text.data()) + 1;
+        }
+        position.character = static_cast<int>(offset - lineStart);
+        return position;
+    }
+};
+
+class Stress : public LSPClientCore::Listener
+{
+  public:
+    double rate = 1000;
+    double seconds = 5;
+    int batch = 1;
+    size_t size = 20000;
+    int checkEvery = 100;
+    uint64_t seed = 1;
+    bool trackText = false;
+    int kills = 0;
+    bool useMock = true;
+
+    json run(const std::string &program, const std::vector<std::string> &arguments)
+    {
+        LSPServerProcess process(loop, program, arguments);
+        LSPClientCore client(process, this);
+        if (trackText || kills > 0)
+        {
+            // Text is only tracked for replay while restarts are enabled
+            RestartPolicy policy;
+            policy.enabled = true;
+            policy.initialDelayMsec = 50;
+            policy.maxAttempts = kills + 5;
+            client.setRestartPolicy(policy);
+            // Asked again after the replay, a check would see edits made after it was sent
+            client.setRetryOnRestart("$/mock/checksum", false);
+        }
+        if (!process.start())
+            return {{"error", "cannot start " + program + ": " + process.errorString()}};
+
+        bool initialized = false;
+        client.setResponseCallback(client.initialize(),
+                                   [&initialized](const json &, const json *) { initialized = true; });
+        client.initialized();
+        if (!waitUntil([&initialized]() { return initialized; }, 30000))
+            return {{"error", "the server did not answer initialize"}};
+
+        EditGenerator generator(seed, size);
+        client.didOpen(documentUri, generator.content(), "cpp");
+        int version = 0;
+
+        int64_t residentBefore = residentKiB();
+        double cpuBefore = cpuMsec();
+        double serverCpuBefore = processCpuMsec(process.pid());
+        double callMsec = 0;
+        uint64_t notifications = 0, edits = 0;
+        int killed = 0;
+        auto start = Clock::now();
+        while (!finished && msecSince(start) < seconds * 1000)
+        {
+            if (killed < kills && msecSince(start) >= seconds * 1000 * (killed + 1) / (kills + 1))
+            {
+                ::kill(process.pid(), SIGKILL);
+                ++killed;
+            }
+            // Without a rate, notifications go out in bursts between looking at the pipes
+            uint64_t due = rate > 0 ? static_cast<uint64_t>(rate * msecSince(start) / 1000) : notifications + 64;
+            while (notifications < due && process.bytesToWrite() < maxBytesToWrite)
+            {
+                std::vector<TextDocumentContentChangeEvent> changes;
+                for (int i = 0; i < batch; ++i)
+                    changes.push_back(generator.next());
+                auto callStart = Clock::now();
+                client.didChange(documentUri, changes);
+                callMsec += msecSince(callStart);
+                ++version;
+                ++notifications;
+                edits += static_cast<uint64_t>(batch);
+                if (useMock && checkEvery > 0 && notifications % static_cast<uint64_t>(checkEvery) == 0 &&
+                    !client.isRecovering())
+                    check(client, version, generator.content());
+            }
+            bool idle = (rate > 0 && notifications >= due) || process.bytesToWrite() >= maxBytesToWrite;
+            loop.processEvents(idle ? 1 : 0);
+        }
+        double elapsedMsec = msecSince(start);
+        double cpu = cpuMsec() - cpuBefore;
+        int64_t residentAfter = residentKiB();
+
+        // Everything sent has to be applied before the last check is answered
+        waitUntil([&client]() { return !client.isRecovering(); }, 30000);
+        if (useMock)
+            check(client, version, generator.content());
+        waitUntil([this]() { return checksPending == 0; }, 30000);
+        double serverCpu = processCpuMsec(process.pid());
+        if (serverCpuBefore >= 0 && serverCpu >= 0)
+            serverCpu -= serverCpuBefore;
+
+        client.shutdown();
+        client.exit();
+        waitUntil([this]() { return finished; }, 5000);
+        if (!finished)
+            process.kill();
+
+        json result = {{"notifications", notifications},
+                       {"edits", edits},
+                       {"elapsedMsec", elapsedMsec},
+                       {"notificationsPerSec", notifications / elapsedMsec * 1000},
+                       {"editsPerSec", edits / elapsedMsec * 1000},
+                       {"cpuMicrosPerEdit", edits > 0 ? cpu * 1000 / edits : 0},
+                       {"didChangeMicros", notifications > 0 ? callMsec * 1000 / notifications : 0},
+                       {"residentKiBBefore", residentBefore},
+                       {"residentKiBAfter", residentAfter},
+                       {"residentGrowthKiB", residentAfter - residentBefore},
+                       {"finalLength", generator.content().size()}};
+        if (serverCpu >= 0)
+            result["serverCpuMicrosPerEdit"] = edits > 0 ? serverCpu * 1000 / edits : 0;
+        if (kills > 0)
+        {
+            result["kills"] = killed;
+            result["recoveries"] = client.recoveryStats().restarts;
+        }
+        if (useMock)
+        {
+            result["checks"] = checksDone;
+            result["checksUnanswered"] = checksPending;
+            result["checksLost"] = checksLost;
+            result["mismatches"] = mismatches;
+            if (!firstMismatch.empty())
+                result["firstMismatch"] = firstMismatch;
+        }
+        return result;
+    }
+
+    bool failed() const
+    {
+        return mismatches > 0 || checksPending > 0;
+    }
+
+  private:
+    LSPEventLoop loop;
+    bool finished = false;
+    int checksPending = 0;
+    int checksDone = 0;
+    int checksLost = 0;
+    int mismatches = 0;
+    std::string firstMismatch;
+
+    void check(LSPClientCore &client, int version, const std::string &text)
+    {
+        json expected = {{"version", version},
+                         {"length", text.size()},
+                         {"checksum", SymbolCache::contentHash(text)}};
+        ++checksPending;
+        LSPClientCore::RequestID id = client.sendRequest("$/mock/checksum", {{"textDocument", {{"uri", documentUri}}}});
+        client.setResponseCallback(id, [this, expected](const json &result, const json *error) {
+            --checksPending;
+            if (error != nullptr && error->value("code", 0) == static_cast<int>(ErrorCode::RequestCancelled))
+            {
+                ++checksLost;
+                return;
+            }
+            ++checksDone;
+            if (error == nullptr && result == expected)
+                return;
+            if (++mismatches == 1)
+                firstMismatch = "expected " + expected.dump() + ", server has " +
+                                (error != nullptr ? error->dump() : result.dump());
+        });
+    }
+
+    bool waitUntil(const std::function<bool()> &condition, int timeoutMsec)
+    {
+        auto start = Clock::now();
+        while (!condition() && !finished && msecSince(start) < timeoutMsec)
+            loop.processEvents(50);
+        return condition();
+    }
+
+    void serverFinished(int exitCode, bool crashed) override
+    {
+        finished = true;
+    }
+
+    // A killed server is reported finished first; with restarts it is not the end of the run
+    void serverRestarting(int attempt, int delayMsec) override
+    {
+        finished = false;
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Stress stress;
+    std::string program = LSPCLIENT_MOCK_SERVER, output;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        auto value = [&argument](size_t prefix) { return argument.c_str() + prefix; };
+        if (argument.compare(0, 7, "--rate=") == 0)
+            stress.rate = std::atof(value(7));
+        else if (argument.compare(0, 10, "--seconds=") == 0)
+            stress.seconds = std::atof(value(10));
+        else if (argument.compare(0, 8, "--batch=") == 0)
+            stress.batch = std::max(1, std::atoi(value(8)));
+        else if (argument.compare(0, 7, "--size=") == 0)
+            stress.size = std::max<size_t>(1, std::strtoull(value(7), nullptr, 10));
+        else if (argument.compare(0, 14, "--check-every=") == 0)
+            stress.checkEvery = std::atoi(value(14));
+        else if (argument.compare(0, 7, "--seed=") == 0)
+            stress.seed = std::strtoull(value(7), nullptr, 10);
+        else if (argument == "--track-text")
+            stress.trackText = true;
+        else if (argument.compare(0, 8, "--kills=") == 0)
+            stress.kills = std::max(0, std::atoi(value(8)));
+        else if (argument.compare(0, 9, "--server=") == 0)
+            program = argument.substr(9);
+        else if (argument.compare(0, 9, "--output=") == 0)
+            output = argument.substr(9);
+        else if (argument == "--" && i + 1 < argc)
+        {
+            program = argv[i + 1];
+            arguments.assign(argv + i + 2, argv + argc);
+            stress.useMock = false;
+            break;
+        }
+        else
+        {
+            std::fprintf(stderr,
+                         "usage: %s [--rate=notifications/s] [--seconds=N] [--batch=edits] [--size=bytes]\n"
+                         "       [--check-every=N] [--seed=N] [--track-text] [--kills=N] [--output=file]\n"
+                         "       [--server=path | -- server arguments...]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+
+    json result = stress.run(program, arguments);
+    json report = {{"suite", "lspclient_edit_stress"},
+                   {"version", LSPCLIENT_VERSION},
+                   {"config",
+                    {{"server", program},
+                     {"rate", stress.rate},
+                     {"seconds", stress.seconds},
+                     {"batch", stress.batch},
+                     {"size", stress.size},
+                     {"checkEvery", stress.checkEvery},
+                     {"seed", stress.seed},
+                     {"trackText", stress.trackText},
+                     {"kills", stress.kills}}},
+                   {"result", result}};
+    std::string text = report.dump(2) + "\n";
+    if (output.empty())
+    {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+    }
+    else
+    {
+        std::ofstream file(output, std::ios::binary);
+        file << text;
+    }
+    return result.contains("error") || stress.failed() ? 1 : 0;
+}
@@ -0,0 +1,606 @@
+// A scriptable stand-in for a language server, for load tests that must not
+// depend on clangd's timing.
+//
+// It speaks Content-Length framed JSON-RPC on stdin/stdout like a real server.
+// What it answers, how late, in how many pieces, and what it sends unasked is
+// set by a JSON script:
+//
+//   {
+//     "seed": 1,
+//     "defaults": {"latency": {"distribution": "fixed", "msec": 0}},
+//     "fragmentation": {"chunkBytes": 0, "delayMsec": 0},
+//     "methods": {
+//       "textDocument/completion": {
+//         "latency": {"distribution": "lognormal", "medianMsec": 20, "sigma": 0.6},
+//         "result": {"$generate": "completion", "items": 50000},
+//         "chunkBytes": 4096
+//       },
+//       "textDocument/hover": {"result": {"contents": {"kind": "plaintext", "value": "int"}}},
+//       "textDocument/definition": {"error": {"code": -32603, "message": "boom"}},
+//       "textDocument/references": {"crash": true}
+//     },
+//     "floods": [
+//       {"after": "initialized", "method": "textDocument/publishDiagnostics", "count": 1000,
+//        "intervalMsec": 0, "params": {"$generate": "diagnostics", "count": 20}}
+//     ]
+//   }
+//
+// Latency distributions:
+//   fixed {msec}, uniform {minMsec, maxMsec}, normal {meanMsec, stddevMsec},
+//   lognormal {medianMsec, sigma}, exponential {meanMsec}
+// Generated payloads ("$generate" in a result or params):
+//   completion {items, labelBytes}, diagnostics {count, uri}, blob {bytes}
+// Per method: "echo": true answers with the request's params; "crash": true
+// kills the server with SIGKILL when the request arrives.
+// Floods fire when a message with the "after" method arrives ("" = at start);
+// "request": true sends them as server-to-client requests instead of notifications.
+//
+// Replies are sent when their latency has passed, not in request order, and
+// fragmented replies are written in chunkBytes pieces delayMsec apart.
+//
+// Open documents are tracked by applying didOpen/didChange like a real server
+// would (positions in UTF-8, as the client negotiates). The $/mock/checksum
+// request {"textDocument": {"uri"}} is answered right away, bypassing the
+// script, with {"version", "length", "checksum"} of the server's copy
+// (SymbolCache::contentHash), or {"error"} once a change could not be applied.
+//
+//   lspclient_mock_server [--script=file.json] [--script-json='{...}'] [--seed=N] [--verbose]
+
+#include <LSP.hpp>
+#include <LSPEdits.hpp>
+#include <LSPFramer.hpp>
+#include <LSPSymbolCache.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <errno.h>
+#include <fstream>
+#include <map>
+#include <poll.h>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Latency
+{
+    enum Kind
+    {
+        Fixed,
+        Uniform,
+        Normal,
+        LogNormal,
+        Exponential,
+    };
+    Kind kind = Fixed;
+    double first = 0;
+    double second = 0;
+
+    double sampleMsec(std::mt19937_64 &random) const
+    {
+        double msec = first;
+        switch (kind)
+        {
+        case Fixed:
+            break;
+        case Uniform:
+            msec = std::uniform_real_distribution<double>(first, second)(random);
+            break;
+        case Normal:
+            msec = std::normal_distribution<double>(first, second)(random);
+            break;
+        case LogNormal:
+            msec = first * std::exp(std::normal_distribution<double>(0, second)(random));
+            break;
+        case Exponential:
+            msec = first > 0 ? std::exponential_distribution<double>(1 / first)(random) : 0;
+            break;
+        }
+        return std::max(0.0, msec);
+    }
+};
+
+struct Behaviour
+{
+    Latency latency;
+    /// Dumped once when the script is loaded, replies only splice in the id
+    std::string result = "null";
+    std::string error;
+    bool echo = false;
+    bool crash = false;
+    size_t chunkBytes = 0;
+    int chunkDelayMsec = 0;
+};
+
+struct Flood
+{
+    std::string after;
+    std::string method;
+    std::string params = "null";
+    size_t count = 1;
+    double intervalMsec = 0;
+    bool request = false;
+};
+
+struct Outgoing
+{
+    Clock::time_point due;
+    uint64_t sequence = 0;
+    std::string payload;
+    size_t chunkBytes = 0;
+    int chunkDelayMsec = 0;
+
+    bool operator>(const Outgoing &other) const
+    {
+        return due != other.due ? due > other.due : sequence > other.sequence;
+    }
+};
+
+struct Chunk
+{
+    std::string bytes;
+    Clock::time_point notBefore;
+};
+
+bool verbose = false;
+
+void log(const std::string &text)
+{
+    if (verbose)
+        std::fprintf(stderr, "mock: %s\n", text.c_str());
+}
+
+json generate(const json &spec)
+{
+    std::string kind = spec.value("$generate", std::string());
+    if (kind == "completion")
+    {
+        size_t count = spec.value("items", size_t(100));
+        size_t labelBytes = spec.value("labelBytes", size_t(0));
+        json items = json::array();
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string name = "candidate" + std::to_string(i);
+            if (name.size() < labelBytes)
+                name.append(labelBytes - name.size(), 'x');
+            json range = {{"start", {{"line", 0}, {"character", 0}}}, {"end", {{"line", 0}, {"character", 4}}}};
+            items.push_back({{"label", " " + name + "(int a)"},
+                             {"kind", 3},
+                             {"detail", "void"},
+                             {"sortText", std::to_string(i)},
+                             {"filterText", name},
+                             {"insertText", name},
+                             {"insertTextFormat", 2},
+                             {"textEdit", {{"range", range}, {"newText", name + "(${1:int a})"}}}});
+        }
+        return {{"isIncomplete", false}, {"items", std::move(items)}};
+    }
+    if (kind == "diagnostics")
+    {
+        size_t count = spec.value("count", size_t(10));
+        json diagnostics = json::array();
+        for (size_t i = 0; i < count; ++i)
+        {
+            int line = static_cast<int>(i);
+            json range = {{"start", {{"line", line}, {"character", 0}}}, {"end", {{"line", line}, {"character", 8}}}};
+            diagnostics.push_back({{"range", range},
+                                   {"severity", 2},
+                                   {"source", "mock"},
+                                   {"message", "Generated diagnostic " + std::to_string(i)}});
+        }
+        return {{"uri", spec.value("uri", std::string("file:///mock.cpp"))}, {"diagnostics", std::move(diagnostics)}};
+    }
+    if (kind == "blob")
+        return std::string(spec.value("bytes", size_t(1024)), 'x');
+    return spec;
+}
+
+std::string payloadText(const json &value)
+{
+    if (value.is_object() && value.contains("$generate"))
+        return generate(value).dump();
+    return value.dump();
+}
+
+Latency parseLatency(const json &spec, Latency fallback)
+{
+    if (!spec.is_object())
+        return fallback;
+    Latency latency;
+    std::string distribution = spec.value("distribution", std::string("fixed"));
+    if (distribution == "uniform")
+    {
+        latency.kind = Latency::Uniform;
+        latency.first = spec.value("minMsec", 0.0);
+        latency.second = spec.value("maxMsec", latency.first);
+    }
+    else if (distribution == "normal")
+    {
+        latency.kind = Latency::Normal;
+        latency.first = spec.value("meanMsec", 0.0);
+        latency.second = spec.value("stddevMsec", 0.0);
+    }
+    else if (distribution == "lognormal")
+    {
+        latency.kind = Latency::LogNormal;
+        latency.first = spec.value("medianMsec", 0.0);
+        latency.second = spec.value("sigma", 0.5);
+    }
+    else if (distribution == "exponential")
+    {
+        latency.kind = Latency::Exponential;
+        latency.first = spec.value("meanMsec", 0.0);
+    }
+    else
+    {
+        latency.first = spec.value("msec", 0.0);
+    }
+    return latency;
+}
+
+class MockServer
+{
+  public:
+    explicit MockServer(const json &script, uint64_t seed)
+    {
+        random.seed(script.value("seed", seed));
+        json defaults = script.value("defaults", json::object());
+        json fragmentation = script.value("fragmentation", json::object());
+        fallback.latency = parseLatency(defaults.value("latency", json()), Latency());
+        fallback.chunkBytes = fragmentation.value("chunkBytes", size_t(0));
+        fallback.chunkDelayMsec = fragmentation.value("delayMsec", 0);
+
+        behaviours["initialize"].result =
+            json{{"capabilities",
+                  {{"textDocumentSync", 2}, {"completionProvider", json::object()}, {"hoverProvider", true}}},
+                 {"serverInfo", {{"name", "lspclient_mock_server"}}}}
+                .dump();
+        json methods = script.value("methods", json::object());
+        for (auto &entry : methods.items())
+        {
+            const json &spec = entry.value();
+            Behaviour &behaviour = behaviours[entry.key()];
+            behaviour.latency = parseLatency(spec.value("latency", json()), fallback.latency);
+            if (spec.contains("result"))
+                behaviour.result = payloadText(spec["result"]);
+            if (spec.contains("error"))
+                behaviour.error = spec["error"].dump();
+            behaviour.echo = spec.value("echo", false);
+            behaviour.crash = spec.value("crash", false);
+            behaviour.chunkBytes = spec.value("chunkBytes", fallback.chunkBytes);
+            behaviour.chunkDelayMsec = spec.value("chunkDelayMsec", fallback.chunkDelayMsec);
+        }
+        for (auto &spec : script.value("floods", json::array()))
+        {
+            Flood flood;
+            flood.after = spec.value("after", std::string());
+            flood.method = spec.value("method", std::string("$/mock/flood"));
+            if (spec.contains("params"))
+                flood.params = payloadText(spec["params"]);
+            flood.count = spec.value("count", size_t(1));
+            flood.intervalMsec = spec.value("intervalMsec", 0.0);
+            flood.request = spec.value("request", false);
+            floods.push_back(std::move(flood));
+        }
+    }
+
+    int run()
+    {
+        startFloods(std::string());
+        char buffer[64 * 1024];
+        bool inputOpen = true;
+        while (true)
+        {
+            Clock::time_point now = Clock::now();
+            while (!scheduled.empty() && scheduled.top().due <= now)
+            {
+                enqueueChunks(scheduled.top(), now);
+                scheduled.pop();
+            }
+            if (!writeDueChunks(now))
+                return 1;
+            if (exitRequested && stream.empty())
+                return shutdownReceived ? 0 : 1;
+            if (!inputOpen && stream.empty() && scheduled.empty())
+                return 0;
+
+            // ppoll() rather than poll(), scripted latencies below a millisecond must not round up
+            bool wakeUp = !stream.empty() || !scheduled.empty();
+            Clock::time_point next = Clock::time_point::max();
+            if (!stream.empty())
+                next = stream.front().notBefore;
+            if (!scheduled.empty())
+                next = std::min(next, scheduled.top().due);
+            timespec timeout = wakeUp ? untilTime(next, now) : timespec{};
+            pollfd input{STDIN_FILENO, POLLIN, 0};
+            bool watchInput = inputOpen && !exitRequested;
+            int ready = ::ppoll(watchInput ? &input : nullptr, watchInput ? 1 : 0, wakeUp ? &timeout : nullptr,
+                                nullptr);
+            if (!watchInput)
+                continue;
+            if (ready < 0 && errno != EINTR)
+                return 1;
+            if (ready <= 0)
+                continue;
+            ssize_t length = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (length < 0 && errno == EINTR)
+                continue;
+            if (length <= 0)
+            {
+                inputOpen = false;
+                continue;
+            }
+            framer.append(buffer, static_cast<size_t>(length));
+            std::string payload;
+            while (framer.next(payload))
+                handle(payload);
+        }
+    }
+
+  private:
+    std::mt19937_64 random;
+    Behaviour fallback;
+    std::map<std::string, Behaviour> behaviours;
+    std::vector<Flood> floods;
+
+    MessageFramer framer;
+    std::priority_queue<Outgoing, std::vector<Outgoing>, std::greater<Outgoing>> scheduled;
+    std::deque<Chunk> stream;
+    uint64_t sequence = 0;
+    uint64_t serverRequests = 0;
+    bool shutdownReceived = false;
+    bool exitRequested = false;
+
+    struct Document
+    {
+        std::string text;
+        int version = 0;
+        // Why a change could not be applied; the text is stale from then on
+        std::string error;
+    };
+    std::unordered_map<std::string, Document> documents;
+
+    static timespec untilTime(Clock::time_point when, Clock::time_point now)
+    {
+        if (when <= now)
+            return timespec{};
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(when - now).count();
+        timespec result;
+        result.tv_sec = static_cast<time_t>(nanos / 1000000000);
+        result.tv_nsec = static_cast<long>(nanos % 1000000000);
+        return result;
+    }
+
+    void handle(const std::string &payload)
+    {
+        json message = json::parse(payload, nullptr, false);
+        if (!message.is_object() || !message.contains("method") || !message["method"].is_string())
+            return; // replies to our own requests are not interesting
+        std::string method = message["method"].get<std::string>();
+        log("<- " + method);
+
+        if (method == "exit")
+        {
+            exitRequested = true;
+            return;
+        }
+        if (method == "textDocument/didOpen" || method == "textDocument/didChange" ||
+            method == "textDocument/didClose")
+            trackDocument(method, message.value("params", json()));
+        if (message.contains("id"))
+        {
+            if (method == "$/mock/checksum")
+            {
+                std::string reply = "{\"id\":" + message["id"].dump() + ",\"jsonrpc\":\"2.0\",\"result\":";
+                schedule(reply + checksum(message.value("params", json())).dump() + "}", 0, 0, 0);
+                return;
+            }
+            if (method == "shutdown")
+                shutdownReceived = true;
+            auto found = behaviours.find(method);
+            const Behaviour &behaviour = found != behaviours.end() ? found->second : fallback;
+            if (behaviour.crash)
+            {
+                log("crashing on " + method);
+                std::raise(SIGKILL);
+            }
+            std::string reply = "{\"id\":" + message["id"].dump() + ",\"jsonrpc\":\"2.0\",";
+            if (!behaviour.error.empty())
+                reply += "\"error\":" + behaviour.error + "}";
+            else if (behaviour.echo)
+                reply += "\"result\":" + message.value("params", json()).dump() + "}";
+            else
+                reply += "\"result\":" + behaviour.result + "}";
+            double delay = behaviour.latency.sampleMsec(random);
+            schedule(std::move(reply), delay, behaviour.chunkBytes, behaviour.chunkDelayMsec);
+        }
+        startFloods(method);
+    }
+
+    void trackDocument(const std::string &method, const json &params)
+    {
+        if (!params.is_object() || !params.contains("textDocument"))
+            return;
+        const json &textDocument = params["textDocument"];
+        std::string uri = textDocument.value("uri", std::string());
+        if (method == "textDocument/didClose")
+        {
+            documents.erase(uri);
+            return;
+        }
+        Document &document = documents[uri];
+        document.version = textDocument.value("version", 0);
+        if (method == "textDocument/didOpen")
+        {
+            document.text = textDocument.value("text", std::string());
+            document.error.clear();
+            return;
+        }
+        if (!document.error.empty() || !params.contains("contentChanges"))
+            return;
+        for (auto &change : params["contentChanges"])
+        {
+            if (!change.contains("range"))
+            {
+                document.text = change.value("text", std::string());
+                continue;
+            }
+            std::vector<TextEdit> edits(1);
+            edits[0].range = change["range"].get<Range>();
+            edits[0].newText = change.value("text", std::string());
+            std::string error;
+            if (!applyTextEdits(document.text, std::move(edits), &error))
+            {
+                document.error = "version " + std::to_string(document.version) + ": " + error;
+                log("cannot apply didChange to " + uri + ", " + document.error);
+                return;
+            }
+        }
+    }
+
+    json checksum(const json &params) const
+    {
+        std::string uri;
+        if (params.is_object() && params.contains("textDocument"))
+            uri = params["textDocument"].value("uri", std::string());
+        auto document = documents.find(uri);
+        if (document == documents.end())
+            return {{"error", "not open: " + uri}};
+        if (!document->second.error.empty())
+            return {{"version", document->second.version}, {"error", document->second.error}};
+        return {{"version", document->second.version},
+                {"length", document->second.text.size()},
+                {"checksum", SymbolCache::contentHash(document->second.text)}};
+    }
+
+    void startFloods(const std::string &trigger)
+    {
+        for (auto &flood : floods)
+        {
+            if (flood.after != trigger)
+                continue;
+            for (size_t i = 0; i < flood.count; ++i)
+            {
+                std::string message = "{";
+                if (flood.request)
+                    message += "\"id\":\"mock#" + std::to_string(++serverRequests) + "\",";
+                message += "\"jsonrpc\":\"2.0\",\"method\":" + json(flood.method).dump();
+                message += ",\"params\":" + flood.params + "}";
+                schedule(std::move(message), flood.intervalMsec * static_cast<double>(i), fallback.chunkBytes,
+                         fallback.chunkDelayMsec);
+            }
+        }
+    }
+
+    void schedule(std::string payload, double delayMsec, size_t chunkBytes, int chunkDelayMsec)
+    {
+        Outgoing outgoing;
+        outgoing.due = Clock::now() + std::chrono::microseconds(static_cast<int64_t>(delayMsec * 1000));
+        outgoing.sequence = ++sequence;
+        outgoing.payload = MessageFramer::frame(payload);
+        outgoing.chunkBytes = chunkBytes;
+        outgoing.chunkDelayMsec = chunkDelayMsec;
+        scheduled.push(std::move(outgoing));
+    }
+
+    // A message's chunks are appended as a whole, so chunks of different messages never interleave
+    void enqueueChunks(const Outgoing &outgoing, Clock::time_point now)
+    {
+        Clock::time_point notBefore = stream.empty() ? now : std::max(now, stream.back().notBefore);
+        size_t size = outgoing.chunkBytes > 0 ? outgoing.chunkBytes : outgoing.payload.size();
+        for (size_t offset = 0; offset < outgoing.payload.size(); offset += size)
+        {
+            stream.push_back({outgoing.payload.substr(offset, size), notBefore});
+            notBefore += std::chrono::milliseconds(outgoing.chunkDelayMsec);
+        }
+    }
+
+    bool writeDueChunks(Clock::time_point now)
+    {
+        while (!stream.empty() && stream.front().notBefore <= now)
+        {
+            const std::string &bytes = stream.front().bytes;
+            size_t written = 0;
+            while (written < bytes.size())
+            {
+                ssize_t result = ::write(STDOUT_FILENO, bytes.data() + written, bytes.size() - written);
+                if (result < 0 && errno == EINTR)
+                    continue;
+                if (result <= 0)
+                    return false;
+                written += static_cast<size_t>(result);
+            }
+            stream.pop_front();
+        }
+        return true;
+    }
+};
+
+bool readFile(const std::string &path, std::string &content)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string scriptText = "{}";
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument.compare(0, 9, "--script=") == 0)
+        {
+            if (!readFile(argument.substr(9), scriptText))
+            {
+                std::fprintf(stderr, "mock: cannot read %s\n", argument.c_str() + 9);
+                return 2;
+            }
+        }
+        else if (argument.compare(0, 14, "--script-json=") == 0)
+        {
+            scriptText = argument.substr(14);
+        }
+        else if (argument.compare(0, 7, "--seed=") == 0)
+        {
+            seed = std::strtoull(argument.c_str() + 7, nullptr, 10);
+        }
+        else if (argument == "--verbose")
+        {
+            verbose = true;
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--script=file.json] [--script-json='{...}'] [--seed=N] [--verbose]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+
+    json script = json::parse(scriptText, nullptr, false);
+    if (!script.is_object())
+    {
+        std::fprintf(stderr, "mock: the script is not a JSON object\n");
+        return 2;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    MockServer server(script, seed);
+    return server.run();
+}
@@ -0,0 +1,510 @@
+// Micro benchmarks for the protocol hot paths: framing, serialization of the
+// outgoing LSP.hpp structs, decoding of server replies, UriEncode, and request
+// round trips through LSPClientCore over an in-process loopback transport.
+//
+// Results are written as one JSON document so runs can be compared between
+// releases:
+//
+//   {"suite": "lspclient_bench", "version": "1.0.0", "minTimeMsec": 200,
+//    "results": [{"name": "framing/frame/4096", "iterations": 123456,
+//                 "nsPerOp": 812.5, "bytesPerOp": 4096, "mbPerSec": 5041.3}, ...]}
+//
+//   lspclient_bench [--filter=substring] [--min-time=msec] [--output=file] [recorded.json...]
+//
+// Every recorded.json is the body of one message captured from a server's
+// stdout; it is decoded into the matching typed struct where there is one. Without recordings the decode
+// benchmarks use generated payloads shaped like clangd's replies.
+
+#include <LSPClientCore.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifndef LSPCLIENT_VERSION
+#define LSPCLIENT_VERSION "unknown"
+#endif
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Results are summed in here so the compiler can't drop the measured work
+volatile size_t sink = 0;
+
+struct Options
+{
+    std::string filter;
+    double minTimeMsec = 200;
+    std::string output;
+    std::vector<std::string> recordings;
+};
+
+class Runner
+{
+  public:
+    explicit Runner(const Options &options) : options(options), results(json::array())
+    {
+    }
+
+    // `op` is run until the batch takes at least minTimeMsec, it returns a value to keep alive
+    template <typename Op> void run(const std::string &name, size_t bytesPerOp, Op op)
+    {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+            return;
+        sink = sink + op();
+
+        uint64_t iterations = 1;
+        double elapsedNs = 0;
+        while (true)
+        {
+            auto start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i)
+                sink = sink + op();
+            elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            if (elapsedNs >= options.minTimeMsec * 1e6 || iterations >= (uint64_t(1) << 32))
+                break;
+            // Aim a bit past the target so the next batch is usually the last one
+            double scale = elapsedNs > 0 ? options.minTimeMsec * 1e6 * 1.2 / elapsedNs : 10;
+            iterations = static_cast<uint64_t>(iterations * std::min(std::max(scale, 2.0), 100.0));
+        }
+
+        double nsPerOp = elapsedNs / static_cast<double>(iterations);
+        json result = {{"name", name}, {"iterations", iterations}, {"nsPerOp", nsPerOp}};
+        if (bytesPerOp > 0)
+        {
+            result["bytesPerOp"] = bytesPerOp;
+            result["mbPerSec"] = static_cast<double>(bytesPerOp) / nsPerOp * 1e9 / (1024 * 1024);
+        }
+        results.push_back(std::move(result));
+        std::fprintf(stderr, "%-48s %14.1f ns/op\n", name.c_str(), nsPerOp);
+    }
+
+    json report() const
+    {
+        return {{"suite", "lspclient_bench"},
+                {"version", LSPCLIENT_VERSION},
+                {"minTimeMsec", options.minTimeMsec},
+                {"results", results}};
+    }
+
+  private:
+    const Options &options;
+    json results;
+};
+
+// Answers every request with a canned result. The id is cut out of the request
+// text instead of parsing it, so the numbers are about the client side only.
+class LoopbackTransport : public LSPTransport
+{
+  public:
+    std::string result = "null";
+
+    bool isOpen() const override
+    {
+        return true;
+    }
+    void write(const std::string &data) override
+    {
+        incoming.append(data.data(), data.size());
+        std::string payload;
+        while (incoming.next(payload))
+        {
+            size_t key = payload.find("\"id\":");
+            if (key == std::string::npos)
+                continue;
+            size_t begin = key + 5;
+            size_t end = payload.find('"', begin + 1) + 1;
+            std::string reply = "{\"id\":" + payload.substr(begin, end - begin) + ",\"jsonrpc\":\"2.0\",\"result\":";
+            reply += result;
+            reply += '}';
+            replies += MessageFramer::frame(reply);
+        }
+    }
+    int64_t bytesToWrite() const override
+    {
+        return 0;
+    }
+    void deliver()
+    {
+        std::string batch;
+        batch.swap(replies);
+        if (receiver != nullptr)
+            receiver->transportData(batch.data(), batch.size());
+    }
+
+  private:
+    MessageFramer incoming;
+    std::string replies;
+};
+
+std::string sourceText(size_t bytes)
+{
+    static const char line[] = "    int value = compute(first, second) + offset; // some trailing comment\n";
+    std::string text;
+    while (text.size() < bytes)
+        text += line;
+    text.resize(bytes);
+    return text;
+}
+
+Range makeRange(int line, int from, int to)
+{
+    Range range;
+    range.start.line = line;
+    range.start.character = from;
+    range.end.line = line;
+    range.end.character = to;
+    return range;
+}
+
+json rangeJson(int line, int from, int to)
+{
+    return {{"start", {{"line", line}, {"character", from}}}, {"end", {{"line", line}, {"character", to}}}};
+}
+
+json completionResult(size_t count)
+{
+    json items = json::array();
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string name = "completionCandidate" + std::to_string(i);
+        items.push_back({{"label", " " + name + "(int a, const std::string &b)"},
+                         {"kind", 3},
+                         {"detail", "void"},
+                         {"documentation", "Does something useful with a and b."},
+                         {"sortText", "3f8ccccd" + name},
+                         {"filterText", name},
+                         {"insertText", name},
+                         {"insertTextFormat", 2},
+                         {"textEdit", {{"range", rangeJson(41, 8, 12)}, {"newText", name + "(${1:int a}, ${2:b})"}}},
+                         {"score", 0.52}});
+    }
+    return {{"isIncomplete", count >= 100}, {"items", items}};
+}
+
+json diagnosticsParams(size_t count)
+{
+    json diagnostics = json::array();
+    for (size_t i = 0; i < count; ++i)
+    {
+        int line = static_cast<int>(i * 3);
+        json location = {{"uri", "file:///home/user/project/src/main.cpp"}, {"range", rangeJson(line - 1, 8, 13)}};
+        json related = {{"location", location}, {"message", "'value' declared here"}};
+        diagnostics.push_back(
+            {{"range", rangeJson(line, 4, 17)},
+             {"severity", 1},
+             {"code", "undeclared_var_use"},
+             {"source", "clang"},
+             {"message", "Use of undeclared identifier 'valu'; did you mean 'value'?"},
+             {"category", "Semantic Issue"},
+             {"relatedInformation", json::array({related})}});
+    }
+    return {{"uri", "file:///home/user/project/src/main.cpp"}, {"version", 7}, {"diagnostics", diagnostics}};
+}
+
+json codeActionsResult(size_t count)
+{
+    json actions = json::array();
+    for (size_t i = 0; i < count; ++i)
+    {
+        int line = static_cast<int>(i * 3);
+        json edit = {{"range", rangeJson(line, 4, 8)}, {"newText", "value"}};
+        json diagnostic = {{"range", rangeJson(line, 4, 8)},
+                           {"severity", 1},
+                           {"code", "undeclared_var_use_suggest"},
+                           {"source", "clang"},
+                           {"message", "Use of undeclared identifier 'valu'; did you mean 'value'?"}};
+        actions.push_back({{"title", "change 'valu' to 'value'"},
+                           {"kind", "quickfix"},
+                           {"diagnostics", json::array({diagnostic})},
+                           {"edit", {{"changes", {{"file:///home/user/project/src/main.cpp", json::array({edit})}}}}}});
+    }
+    return actions;
+}
+
+json hoverResult()
+{
+    std::string markdown = "### function `compute`  \n\n---\n→ `int`  \nParameters:  \n- `int first`  \n"
+                           "- `int second`  \n\nAdds both and clamps the result.  \n\n---\n```cpp\n"
+                           "// In namespace detail\nint compute(int first, int second)\n```";
+    return {{"contents", {{"kind", "markdown"}, {"value", markdown}}}, {"range", rangeJson(12, 16, 23)}};
+}
+
+std::string message(const json &result)
+{
+    return json{{"jsonrpc", "2.0"}, {"id", "textDocument/completion#42"}, {"result", result}}.dump();
+}
+
+// Decodes a message body into the typed struct for its shape, returns something size-like
+size_t decode(const std::string &payload)
+{
+    json message = json::parse(payload, nullptr, false);
+    if (!message.is_object())
+        return 0;
+    if (message.value("method", std::string()) == "textDocument/publishDiagnostics" && message.contains("params"))
+        return message["params"].get<PublishDiagnosticsParams>().diagnostics.size();
+    auto result = message.find("result");
+    if (result == message.end() || !result->is_object())
+        return message.size();
+    if (result->contains("items"))
+        return result->get<CompletionList>().items.size();
+    if (result->contains("contents") && (*result)["contents"].is_object())
+        return result->get<Hover>().contents.value.size();
+    return result->size();
+}
+
+void benchFraming(Runner &runner)
+{
+    for (size_t size : {64, 4096, 256 * 1024})
+    {
+        std::string payload = sourceText(size);
+        runner.run("framing/frame/" + std::to_string(size), size,
+                   [&payload]() { return MessageFramer::frame(payload).size(); });
+
+        // 16 messages per read, then the same stream split into small reads
+        std::string stream;
+        for (int i = 0; i < 16; ++i)
+            stream += MessageFramer::frame(payload);
+        for (size_t chunk : {stream.size(), size_t(4096), size_t(61)})
+        {
+            // Millions of tiny appends for the big payload add minutes and nothing new
+            if (chunk == 61 && size > 4096)
+                continue;
+            std::string name = "framing/parse/" + std::to_string(size) + "x16/";
+            name += chunk == stream.size() ? std::string("whole") : "chunk" + std::to_string(chunk);
+            runner.run(name, stream.size(), [&stream, chunk]() {
+                MessageFramer framer;
+                std::string next;
+                size_t total = 0;
+                for (size_t offset = 0; offset < stream.size(); offset += chunk)
+                {
+                    framer.append(stream.data() + offset, std::min(chunk, stream.size() - offset));
+                    while (framer.next(next))
+                        total += next.size();
+                }
+                return total;
+            });
+        }
+    }
+}
+
+void benchSerialization(Runner &runner)
+{
+    static const std::string uri = "file:///home/user/project/src/main.cpp";
+    std::string text = sourceText(64 * 1024);
+
+    InitializeParams initialize;
+    initialize.processId = 4242;
+    initialize.rootUri = DocumentUri(uri);
+    runner.run("serialize/InitializeParams", 0, [&initialize]() { return json(initialize).dump().size(); });
+
+    DidOpenTextDocumentParams didOpen;
+    didOpen.textDocument.uri = uri;
+    didOpen.textDocument.languageId = "cpp";
+    didOpen.textDocument.text = text;
+    runner.run("serialize/DidOpenTextDocumentParams/64KiB", text.size(),
+               [&didOpen]() { return json(didOpen).dump().size(); });
+
+    DidChangeTextDocumentParams didChange;
+    didChange.textDocument.uri = uri;
+    didChange.textDocument.version = 12;
+    TextDocumentContentChangeEvent change;
+    change.range = makeRange(120, 8, 8);
+    change.text = "x";
+    didChange.contentChanges.push_back(change);
+    runner.run("serialize/DidChangeTextDocumentParams/keystroke", 0,
+               [&didChange]() { return json(didChange).dump().size(); });
+
+    DidChangeTextDocumentParams fullChange = didChange;
+    fullChange.contentChanges[0].range = option<Range>();
+    fullChange.contentChanges[0].text = text;
+    runner.run("serialize/DidChangeTextDocumentParams/full64KiB", text.size(),
+               [&fullChange]() { return json(fullChange).dump().size(); });
+
+    CompletionParams completion;
+    completion.textDocument.uri = uri;
+    completion.position.line = 120;
+    completion.position.character = 9;
+    CompletionContext context;
+    context.triggerKind = CompletionTriggerKind::TriggerCharacter;
+    context.triggerCharacter = ".";
+    completion.context = context;
+    runner.run("serialize/CompletionParams", 0, [&completion]() { return json(completion).dump().size(); });
+
+    CodeActionParams codeAction;
+    codeAction.textDocument.uri = uri;
+    codeAction.range = makeRange(12, 0, 40);
+    json diagnostics = diagnosticsParams(20)["diagnostics"];
+    for (auto &diagnostic : diagnostics)
+        codeAction.context.diagnostics.push_back(diagnostic.get<Diagnostic>());
+    runner.run("serialize/CodeActionParams/20diagnostics", 0,
+               [&codeAction]() { return json(codeAction).dump().size(); });
+
+    RenameParams rename;
+    rename.textDocument.uri = uri;
+    rename.position.line = 3;
+    rename.newName = "renamedSymbol";
+    runner.run("serialize/RenameParams", 0, [&rename]() { return json(rename).dump().size(); });
+
+    DidChangeWatchedFilesParams watched;
+    for (int i = 0; i < 100; ++i)
+    {
+        FileEvent event;
+        event.uri.from("/home/user/project/src/file" + std::to_string(i) + ".cpp");
+        event.type = FileChangeType::Changed;
+        watched.changes.push_back(event);
+    }
+    runner.run("serialize/DidChangeWatchedFilesParams/100", 0, [&watched]() { return json(watched).dump().size(); });
+}
+
+void benchDecode(Runner &runner, const Options &options)
+{
+    if (!options.recordings.empty())
+    {
+        for (auto &path : options.recordings)
+        {
+            std::ifstream file(path, std::ios::binary);
+            std::stringstream content;
+            content << file.rdbuf();
+            std::string payload = content.str();
+            std::string name = path.substr(path.find_last_of("/\\") + 1);
+            runner.run("decode/recorded/" + name, payload.size(), [&payload]() { return decode(payload); });
+        }
+        return;
+    }
+
+    std::string hover = message(hoverResult());
+    runner.run("decode/hover", hover.size(), [&hover]() { return decode(hover); });
+    for (size_t count : {100, 10000})
+    {
+        std::string completion = message(completionResult(count));
+        runner.run("decode/completion/" + std::to_string(count), completion.size(),
+                   [&completion]() { return decode(completion); });
+    }
+    std::string diagnostics =
+        json{{"jsonrpc", "2.0"}, {"method", "textDocument/publishDiagnostics"}, {"params", diagnosticsParams(200)}}
+            .dump();
+    runner.run("decode/publishDiagnostics/200", diagnostics.size(), [&diagnostics]() { return decode(diagnostics); });
+
+    // Only the conversion of already parsed JSON into the structs, without json::parse
+    json completionTree = completionResult(10000);
+    runner.run("decode/typed/completion/10000", 0,
+               [&completionTree]() { return completionTree.get<CompletionList>().items.size(); });
+    json diagnosticsTree = diagnosticsParams(200);
+    runner.run("decode/typed/publishDiagnostics/200", 0,
+               [&diagnosticsTree]() { return diagnosticsTree.get<PublishDiagnosticsParams>().diagnostics.size(); });
+    json actionsTree = codeActionsResult(200);
+    runner.run("decode/typed/codeActions/200", 0,
+               [&actionsTree]() { return actionsTree.get<std::vector<CodeAction>>().size(); });
+}
+
+void benchUri(Runner &runner)
+{
+    std::string plain = "/home/user/project/src/module/implementation_file.cpp";
+    std::string spaced = "/home/user/My Projects/Überprojekt (copy)/src/main file.cpp";
+    std::string windows = "C:\\Users\\user\\source\\repos\\project\\src\\main.cpp";
+    runner.run("uri/encode/plain", plain.size(), [&plain]() { return URIForFile::UriEncode(plain).size(); });
+    runner.run("uri/encode/escaped", spaced.size(), [&spaced]() { return URIForFile::UriEncode(spaced).size(); });
+    runner.run("uri/encode/windows", windows.size(), [&windows]() { return URIForFile::UriEncode(windows).size(); });
+}
+
+void benchRoundTrip(Runner &runner)
+{
+    std::string uri = "file:///home/user/project/src/main.cpp";
+    struct Case
+    {
+        const char *name;
+        json result;
+    };
+    std::vector<Case> cases = {{"roundtrip/hover", hoverResult()},
+                               {"roundtrip/completion/1000", completionResult(1000)}};
+    for (auto &entry : cases)
+    {
+        LoopbackTransport transport;
+        transport.result = entry.result.dump();
+        LSPClientCore client(transport);
+        runner.run(entry.name, transport.result.size(), [&]() {
+            Position position;
+            position.line = 12;
+            position.character = 18;
+            auto id = entry.result.contains("items") ? client.completion(uri, position) : client.hover(uri, position);
+            size_t decoded = 0;
+            client.setResponseCallback(id, [&decoded](const json &result, const json *error) {
+                decoded = result.contains("items") ? result.get<CompletionList>().items.size()
+                                                   : result.get<Hover>().contents.value.size();
+            });
+            transport.deliver();
+            return decoded;
+        });
+    }
+
+    // Many requests in flight: 64 writes, then all replies in one read
+    LoopbackTransport transport;
+    transport.result = hoverResult().dump();
+    LSPClientCore client(transport);
+    runner.run("roundtrip/hover/pipelined64", 64 * transport.result.size(), [&]() {
+        size_t answered = 0;
+        for (int i = 0; i < 64; ++i)
+        {
+            Position position;
+            position.line = i;
+            auto id = client.hover(uri, position);
+            client.setResponseCallback(id, [&answered](const json &, const json *) { ++answered; });
+        }
+        transport.deliver();
+        return answered;
+    });
+}
+
+bool parseArguments(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        auto value = [&argument](const char *prefix) { return argument.substr(std::strlen(prefix)); };
+        if (argument.compare(0, 9, "--filter=") == 0)
+            options.filter = value("--filter=");
+        else if (argument.compare(0, 11, "--min-time=") == 0)
+            options.minTimeMsec = std::atof(value("--min-time=").c_str());
+        else if (argument.compare(0, 9, "--output=") == 0)
+            options.output = value("--output=");
+        else if (argument.compare(0, 2, "--") == 0)
+            return false;
+        else
+            options.recordings.push_back(argument);
+    }
+    return options.minTimeMsec > 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseArguments(argc, argv, options))
+    {
+        std::fprintf(stderr, "usage: %s [--filter=substring] [--min-time=msec] [--output=file] [recorded.json...]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    Runner runner(options);
+    benchFraming(runner);
+    benchSerialization(runner);
+    benchDecode(runner, options);
+    benchUri(runner);
+    benchRoundTrip(runner);
+
+    std::string report = runner.report().dump(2) + "\n";
+    if (options.output.empty())
+    {
+        std::fwrite(report.data(), 1, report.size(), stdout);
+        return 0;
+    }
+    std::ofstream file(options.output, std::ios::binary);
+    file << report;
+    return file.good() ? 0 : 1;
+}
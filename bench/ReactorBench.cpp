@@ -0,0 +1,103 @@
+// Throughput of one LSPReactor thread driving 1 to 512 server connections.
+//
+// Every connection runs `cat`, which echoes the framed notifications the client
+// writes back as incoming notifications, so the numbers cover spawning, pipe
+// I/O, framing and decode without depending on a real server's timing.
+//
+//   lspclient_reactor_bench [messages per connection] [payload bytes] [max connections]
+
+#include <LSPReactor.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+
+namespace
+{
+
+struct Counter : LSPClientCore::Listener
+{
+    LSPReactor *reactor = nullptr;
+    size_t expected = 0;
+    size_t received = 0;
+    size_t *pendingConnections = nullptr;
+    LSPEventLoop::Clock::time_point finished;
+
+    void notification(const std::string &method, const json &params) override
+    {
+        if (++received != expected)
+            return;
+        finished = LSPEventLoop::Clock::now();
+        if (--*pendingConnections == 0)
+            reactor->quit();
+    }
+};
+
+void raiseFileLimit()
+{
+    // Three pipes per connection quickly exceed the usual soft limit of 1024
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+double msecSince(LSPEventLoop::Clock::time_point start, LSPEventLoop::Clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t messages = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    size_t size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 512;
+    size_t maxConnections = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 512;
+    raiseFileLimit();
+
+    json params = {{"payload", std::string(size, 'x')}};
+    std::printf("%11s %12s %10s %14s %12s %12s\n", "connections", "messages", "seconds", "msgs/s", "p50 done ms",
+                "max done ms");
+    for (size_t count = 1; count <= maxConnections; count *= 2)
+    {
+        LSPReactor reactor;
+        std::vector<Counter> counters(count);
+        size_t pending = count;
+        std::vector<LSPClientCore *> clients;
+        for (auto &counter : counters)
+        {
+            counter.reactor = &reactor;
+            counter.expected = messages;
+            counter.pendingConnections = &pending;
+            LSPReactor::Connection *connection = reactor.addServer("cat", {}, &counter);
+            if (connection == nullptr)
+            {
+                std::fprintf(stderr, "could not start cat\n");
+                return 1;
+            }
+            clients.push_back(&connection->client);
+        }
+
+        auto start = LSPEventLoop::Clock::now();
+        for (size_t i = 0; i < messages; ++i)
+        {
+            for (auto *client : clients)
+                client->sendNotification("bench/echo", params);
+        }
+        reactor.run();
+        auto end = LSPEventLoop::Clock::now();
+
+        std::vector<double> done;
+        for (auto &counter : counters)
+            done.push_back(msecSince(start, counter.finished));
+        std::sort(done.begin(), done.end());
+        double seconds = msecSince(start, end) / 1000;
+        size_t total = messages * count;
+        std::printf("%11zu %12zu %10.3f %14.0f %12.1f %12.1f\n", count, total, seconds, total / seconds,
+                    done[done.size() / 2], done.back());
+    }
+    return 0;
+}
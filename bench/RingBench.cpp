@@ -0,0 +1,103 @@
+// Messages per second handed from an I/O thread to the Qt thread, once through a
+// queued invokeMethod per message and once through an SpscChannel that posts one
+// event per batch.
+//
+//   lspclient_ring_bench [messages] [payload bytes]
+
+#include <LSPRing.hpp>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QObject>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace
+{
+
+struct Result
+{
+    double seconds = 0;
+    size_t received = 0;
+    size_t wakeups = 0;
+    size_t bytes = 0;
+};
+
+Result runQueued(QCoreApplication &app, size_t count, const std::string &payload)
+{
+    QObject receiver;
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+    std::thread producer([&]() {
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string message = payload;
+            QMetaObject::invokeMethod(
+                &receiver,
+                [&result, &app, count, message]() {
+                    ++result.wakeups;
+                    result.bytes += message.size();
+                    if (++result.received == count)
+                        app.quit();
+                },
+                Qt::QueuedConnection);
+        }
+    });
+    app.exec();
+    producer.join();
+    result.seconds = timer.nsecsElapsed() / 1e9;
+    return result;
+}
+
+Result runRing(QCoreApplication &app, size_t count, const std::string &payload)
+{
+    QObject receiver;
+    Result result;
+    SpscChannel<std::string> channel(4096);
+    channel.setWakeFunction([&]() {
+        QMetaObject::invokeMethod(
+            &receiver,
+            [&]() {
+                ++result.wakeups;
+                result.received += channel.receive([&](std::string &&m) { result.bytes += m.size(); });
+                if (result.received == count)
+                    app.quit();
+            },
+            Qt::QueuedConnection);
+    });
+    QElapsedTimer timer;
+    timer.start();
+    std::thread producer([&]() {
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string message = payload;
+            while (!channel.send(std::move(message)))
+                std::this_thread::yield();
+        }
+    });
+    app.exec();
+    producer.join();
+    result.seconds = timer.nsecsElapsed() / 1e9;
+    return result;
+}
+
+void print(const char *name, const Result &result)
+{
+    std::printf("%-14s %10zu msgs %8.3f s %12.0f msgs/s %10zu wakeups\n", name, result.received, result.seconds,
+                result.received / result.seconds, result.wakeups);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+    std::string payload(size, 'x');
+
+    print("queued signal", runQueued(app, count, payload));
+    print("spsc ring", runRing(app, count, payload));
+    return 0;
+}
@@ -0,0 +1,106 @@
+// A translation unit of an editor using the protocol types, compiled by
+// lspclient_compile_bench to measure what including them costs:
+//
+//   LSPCLIENT_SAMPLE_BASELINE    only the standard headers LSPTypes.hpp pulls in
+//   LSPCLIENT_SAMPLE_TYPES_ONLY  LSPTypes.hpp, filling in and reading the structs
+//   (neither)                    LSP.hpp, also converting them to and from json
+//
+// It is also built as part of the benchmarks so it keeps compiling.
+
+#if defined(LSPCLIENT_SAMPLE_BASELINE)
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#elif defined(LSPCLIENT_SAMPLE_TYPES_ONLY)
+#include <LSPTypes.hpp>
+#else
+#include <LSP.hpp>
+#endif
+
+#include <algorithm>
+
+#if !defined(LSPCLIENT_SAMPLE_BASELINE)
+
+namespace
+{
+
+// What a diagnostics panel does with a publishDiagnostics notification
+std::vector<std::string> errorLines(const PublishDiagnosticsParams &params, const Range &visible)
+{
+    std::vector<std::string> lines;
+    for (auto &diagnostic : params.diagnostics)
+    {
+        if (diagnostic.severity != 1 || !visible.contains(diagnostic.range.start))
+            continue;
+        std::string line = std::to_string(diagnostic.range.start.line + 1) + ": " + diagnostic.message;
+        if (diagnostic.category.has())
+            line += " [" + diagnostic.category.value() + "]";
+        lines.push_back(std::move(line));
+    }
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+// What an edit buffer does before sending didChange
+TextDocumentContentChangeEvent replace(const Range &range, std::string text)
+{
+    TextDocumentContentChangeEvent change;
+    change.range = range;
+    change.text = std::move(text);
+    return change;
+}
+
+size_t completionWidth(const CompletionList &list)
+{
+    size_t width = 0;
+    for (auto &item : list.items)
+        width = std::max(width, item.label.size() + item.detail.size());
+    return width;
+}
+
+} // namespace
+
+#if !defined(LSPCLIENT_SAMPLE_TYPES_ONLY)
+
+// The same, starting from the JSON the client hands out
+size_t sampleConsumerDecode(const json &diagnostics, const json &completion)
+{
+    Range visible;
+    visible.end.line = 100;
+    auto params = diagnostics.get<PublishDiagnosticsParams>();
+    auto list = completion.get<CompletionList>();
+    return errorLines(params, visible).size() + completionWidth(list);
+}
+
+json sampleConsumerEncode(const Range &range)
+{
+    DidChangeTextDocumentParams params;
+    params.textDocument.uri = "file:///sample.cpp";
+    params.textDocument.version = 2;
+    params.contentChanges.push_back(replace(range, "text"));
+    return params;
+}
+
+#else
+
+size_t sampleConsumer(const PublishDiagnosticsParams &params, const CompletionList &list, const Range &range)
+{
+    return errorLines(params, range).size() + completionWidth(list) + replace(range, "text").text.size();
+}
+
+#endif
+
+#else
+
+size_t sampleConsumer(const std::map<std::string, std::vector<std::string>> &lines)
+{
+    size_t count = 0;
+    for (auto &entry : lines)
+        count += std::count_if(entry.second.begin(), entry.second.end(),
+                               [](const std::string &line) { return !line.empty(); });
+    return count;
+}
+
+#endif
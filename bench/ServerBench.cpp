@@ -0,0 +1,283 @@
+// End-to-end numbers against lspclient_mock_server, so they can be taken
+// offline and repeat from run to run: LSPClientCore on top of LSPServerProcess
+// and LSPEventLoop, with the server's behaviour scripted per scenario.
+//
+//   hover/sequential          one request at a time, lognormal server latency
+//   hover/pipelined           many requests in flight, no server latency
+//   completion/50000          huge replies decoded into CompletionList
+//   hover/fragmented7         every reply arrives in 7 byte pieces
+//   flood/publishDiagnostics  unsolicited notifications as fast as the server can write
+//
+// Results are one JSON document like lspclient_bench's.
+//
+//   lspclient_server_bench [--server=path/to/lspclient_mock_server] [--filter=substring] [--output=file]
+
+#include <LSPClientCore.hpp>
+#include <LSPEventLoop.hpp>
+#include <LSPServerProcess.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifndef LSPCLIENT_VERSION
+#define LSPCLIENT_VERSION "unknown"
+#endif
+#ifndef LSPCLIENT_MOCK_SERVER
+#define LSPCLIENT_MOCK_SERVER "lspclient_mock_server"
+#endif
+
+namespace
+{
+
+using Clock = LSPEventLoop::Clock;
+
+double msecSince(Clock::time_point start, Clock::time_point end = Clock::now())
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+// One mock server run by its own event loop
+class Session : public LSPClientCore::Listener
+{
+  public:
+    size_t notifications = 0;
+
+    Session(const std::string &server, const json &script)
+        : process(loop, server, {"--script-json=" + script.dump()}), client(process, this)
+    {
+    }
+
+    ~Session() override
+    {
+        if (!finished)
+        {
+            client.shutdown();
+            client.exit();
+            waitUntil([this]() { return finished; }, 2000);
+        }
+    }
+
+    bool start()
+    {
+        if (!process.start())
+        {
+            std::fprintf(stderr, "cannot start the mock server: %s\n", process.errorString().c_str());
+            return false;
+        }
+        bool initialized = false;
+        expect(client.initialize(), [&initialized](const json &) { initialized = true; });
+        client.initialized();
+        return waitUntil([&initialized]() { return initialized; });
+    }
+
+    LSPClientCore &core()
+    {
+        return client;
+    }
+
+    // Registers `done` for the reply to `id`
+    void expect(const LSPClientCore::RequestID &id, std::function<void(const json &)> done)
+    {
+        client.setResponseCallback(id, [done](const json &result, const json *error) { done(result); });
+    }
+
+    bool waitUntil(const std::function<bool()> &condition, int timeoutMsec = 60000)
+    {
+        auto start = Clock::now();
+        while (!condition())
+        {
+            if (finished || msecSince(start) > timeoutMsec)
+                return condition();
+            loop.processEvents(50);
+        }
+        return true;
+    }
+
+  private:
+    LSPEventLoop loop;
+    LSPServerProcess process;
+    LSPClientCore client;
+    bool finished = false;
+
+    void notification(const std::string &method, const json &params) override
+    {
+        ++notifications;
+    }
+    void serverFinished(int exitCode, bool crashed) override
+    {
+        finished = true;
+    }
+};
+
+class Bench
+{
+  public:
+    std::string server = LSPCLIENT_MOCK_SERVER;
+    std::string filter;
+    json results = json::array();
+
+    bool wanted(const std::string &name) const
+    {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    void add(json result)
+    {
+        std::fprintf(stderr, "%s\n", result.dump().c_str());
+        results.push_back(std::move(result));
+    }
+
+    void hoverSequential()
+    {
+        const char *name = "hover/sequential";
+        if (!wanted(name))
+            return;
+        json script;
+        json &hover = script["methods"]["textDocument/hover"];
+        hover["latency"] = {{"distribution", "lognormal"}, {"medianMsec", 2}, {"sigma", 0.5}};
+        hover["result"] = {{"contents", {{"kind", "plaintext"}, {"value", "int value"}}}};
+        Session session(server, script);
+        if (!session.start())
+            return;
+        std::vector<double> latencies;
+        for (int i = 0; i < 300; ++i)
+        {
+            bool answered = false;
+            auto start = Clock::now();
+            session.expect(session.core().hover("file:///mock.cpp", Position()),
+                           [&answered](const json &) { answered = true; });
+            if (!session.waitUntil([&answered]() { return answered; }))
+                return;
+            latencies.push_back(msecSince(start));
+        }
+        add({{"name", name},
+             {"requests", latencies.size()},
+             {"p50Msec", percentile(latencies, 0.5)},
+             {"p99Msec", percentile(latencies, 0.99)},
+             {"maxMsec", percentile(latencies, 1)}});
+    }
+
+    void hoverPipelined(const char *name, const json &script, size_t count)
+    {
+        if (!wanted(name))
+            return;
+        Session session(server, script);
+        if (!session.start())
+            return;
+        size_t answered = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; ++i)
+            session.expect(session.core().hover("file:///mock.cpp", Position()),
+                           [&answered](const json &) { ++answered; });
+        if (!session.waitUntil([&]() { return answered == count; }))
+            return;
+        double msec = msecSince(start);
+        add({{"name", name}, {"requests", count}, {"totalMsec", msec}, {"requestsPerSec", count / msec * 1000}});
+    }
+
+    void completion()
+    {
+        const char *name = "completion/50000";
+        if (!wanted(name))
+            return;
+        json script;
+        script["methods"]["textDocument/completion"]["result"] = {{"$generate", "completion"}, {"items", 50000}};
+        Session session(server, script);
+        if (!session.start())
+            return;
+        std::vector<double> times;
+        size_t bytes = 0;
+        for (int i = 0; i < 5; ++i)
+        {
+            bool answered = false;
+            auto start = Clock::now();
+            session.expect(session.core().completion("file:///mock.cpp", Position()), [&](const json &result) {
+                bytes = result.dump().size();
+                answered = result.get<CompletionList>().items.size() == 50000;
+            });
+            if (!session.waitUntil([&answered]() { return answered; }))
+                return;
+            times.push_back(msecSince(start));
+        }
+        add({{"name", name},
+             {"replyBytes", bytes},
+             {"p50Msec", percentile(times, 0.5)},
+             {"maxMsec", percentile(times, 1)}});
+    }
+
+    void flood()
+    {
+        const char *name = "flood/publishDiagnostics";
+        if (!wanted(name))
+            return;
+        const size_t count = 50000;
+        json flood = {{"after", "initialized"},
+                      {"method", "textDocument/publishDiagnostics"},
+                      {"count", count},
+                      {"params", {{"$generate", "diagnostics"}, {"count", 5}}}};
+        json script = {{"floods", json::array({flood})}};
+        Session session(server, script);
+        auto start = Clock::now();
+        if (!session.start() || !session.waitUntil([&]() { return session.notifications >= count; }))
+            return;
+        double msec = msecSince(start);
+        add({{"name", name},
+             {"notifications", count},
+             {"totalMsec", msec},
+             {"notificationsPerSec", count / msec * 1000}});
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Bench bench;
+    std::string output;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument.compare(0, 9, "--server=") == 0)
+            bench.server = argument.substr(9);
+        else if (argument.compare(0, 9, "--filter=") == 0)
+            bench.filter = argument.substr(9);
+        else if (argument.compare(0, 9, "--output=") == 0)
+            output = argument.substr(9);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--server=path] [--filter=substring] [--output=file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    json pipelined, fragmented;
+    pipelined["methods"]["textDocument/hover"]["result"] = {{"contents", {{"kind", "plaintext"}, {"value", "int"}}}};
+    fragmented = pipelined;
+    fragmented["methods"]["textDocument/hover"]["chunkBytes"] = 7;
+    bench.hoverSequential();
+    bench.hoverPipelined("hover/pipelined", pipelined, 20000);
+    bench.hoverPipelined("hover/fragmented7", fragmented, 2000);
+    bench.completion();
+    bench.flood();
+
+    json report = {{"suite", "lspclient_server_bench"}, {"version", LSPCLIENT_VERSION}, {"results", bench.results}};
+    std::string text = report.dump(2) + "\n";
+    if (output.empty())
+    {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        return 0;
+    }
+    std::ofstream file(output, std::ios::binary);
+    file << text;
+    return file.good() ? 0 : 1;
+}
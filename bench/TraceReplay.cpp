@@ -0,0 +1,346 @@
+// Plays back a trace recorded with LSPClientCore::startTrace, to reproduce a
+// slow session without the editor, project or user that produced it.
+//
+//   --to-client   feeds the server's side of the trace (replies, notifications,
+//                 server requests, stderr) to an LSPClientCore and reports how
+//                 long it took to decode and dispatch, with the client's metrics.
+//                 The client's own ids differ from the recorded ones, so replies
+//                 show up as repliesDiscarded, but they are decoded all the same.
+//   --to-server   starts the server given after "--" and writes the client's side
+//                 of the trace to it, matching replies to the recorded request ids
+//                 for per-method latencies.
+//   --dump        lists the records, one line each.
+//
+// Records are sent at their recorded time divided by --speed (1 is the original
+// pace, 10 ten times faster, 0 as fast as possible). Results are one JSON document.
+//
+//   lspclient_trace_replay --to-client [--speed=N] trace
+//   lspclient_trace_replay --to-server [--speed=N] [--wait=msec] trace -- server [arguments...]
+//   lspclient_trace_replay --dump trace
+
+#include <LSPClientCore.hpp>
+#include <LSPEventLoop.hpp>
+#include <LSPServerProcess.hpp>
+#include <LSPTrace.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double msecSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+uint64_t micros(Clock::duration duration)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+// When a record recorded at `micros` is due
+Clock::time_point dueAt(Clock::time_point start, uint64_t micros, double speed)
+{
+    if (speed <= 0)
+        return start;
+    return start + std::chrono::microseconds(static_cast<int64_t>(static_cast<double>(micros) / speed));
+}
+
+const char *directionName(TraceDirection direction)
+{
+    switch (direction)
+    {
+    case TraceDirection::ToServer:
+        return "->";
+    case TraceDirection::FromServer:
+        return "<-";
+    case TraceDirection::ServerStderr:
+        return "!!";
+    }
+    return "??";
+}
+
+int dump(TraceReader &reader)
+{
+    TraceRecord record;
+    while (reader.next(record))
+    {
+        std::string summary;
+        if (record.direction != TraceDirection::ServerStderr)
+        {
+            json message = json::parse(record.data, nullptr, false);
+            if (message.is_object())
+            {
+                if (message.contains("method"))
+                    summary += message["method"].get<std::string>();
+                if (message.contains("id"))
+                    summary += " #" + message["id"].dump();
+            }
+        }
+        std::printf("%12.3f %s %8zu %s\n", static_cast<double>(record.micros) / 1000,
+                    directionName(record.direction), record.data.size(), summary.c_str());
+    }
+    return 0;
+}
+
+// Stands in for the server's pipes, the client's writes go nowhere
+class ReplayTransport : public LSPTransport
+{
+  public:
+    uint64_t bytesWritten = 0;
+
+    bool isOpen() const override
+    {
+        return true;
+    }
+    void write(const std::string &data) override
+    {
+        bytesWritten += data.size();
+    }
+    int64_t bytesToWrite() const override
+    {
+        return 0;
+    }
+
+    void open()
+    {
+        receiver->transportOpened();
+    }
+    void feed(const TraceRecord &record)
+    {
+        if (record.direction == TraceDirection::ServerStderr)
+        {
+            receiver->transportStderr(record.data.data(), record.data.size());
+            return;
+        }
+        std::string frame = MessageFramer::frame(record.data);
+        receiver->transportData(frame.data(), frame.size());
+    }
+};
+
+json toClient(TraceReader &reader, double speed)
+{
+    ReplayTransport transport;
+    LSPClientCore client(transport);
+    transport.open();
+
+    TraceRecord record;
+    uint64_t records = 0, recordedMicros = 0;
+    double maxLagMsec = 0, dispatchMsec = 0;
+    auto start = Clock::now();
+    while (reader.next(record))
+    {
+        recordedMicros = record.micros;
+        if (record.direction == TraceDirection::ToServer)
+            continue;
+        auto due = dueAt(start, record.micros, speed);
+        if (due > Clock::now())
+            std::this_thread::sleep_until(due);
+        else if (speed > 0)
+            maxLagMsec = std::max(maxLagMsec, msecSince(due));
+        auto dispatchStart = Clock::now();
+        transport.feed(record);
+        dispatchMsec += msecSince(dispatchStart);
+        ++records;
+    }
+    return {{"mode", "to-client"},
+            {"records", records},
+            {"recordedMsec", static_cast<double>(recordedMicros) / 1000},
+            {"wallMsec", msecSince(start)},
+            {"dispatchMsec", dispatchMsec},
+            {"maxLagMsec", maxLagMsec},
+            {"bytesAnswered", transport.bytesWritten},
+            {"metrics", client.metrics().toJson()}};
+}
+
+// Writes the client's side of a trace to a real server and times its replies
+class ServerReplay : public LSPTransport::Receiver
+{
+  public:
+    ServerReplay(LSPEventLoop &loop, LSPServerProcess &process) : loop(loop), process(process)
+    {
+        process.setReceiver(this);
+    }
+    ~ServerReplay() override
+    {
+        process.setReceiver(nullptr);
+    }
+
+    json run(TraceReader &reader, double speed, int waitMsec)
+    {
+        if (!process.start())
+            return {{"mode", "to-server"}, {"error", process.errorString()}};
+
+        TraceRecord record;
+        uint64_t records = 0, recordedMicros = 0;
+        double maxLagMsec = 0;
+        auto start = Clock::now();
+        while (!finished && reader.next(record))
+        {
+            recordedMicros = record.micros;
+            if (record.direction != TraceDirection::ToServer)
+                continue;
+            auto due = dueAt(start, record.micros, speed);
+            while (!finished && due > Clock::now())
+            {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(due - Clock::now()).count();
+                loop.processEvents(static_cast<int>(std::max<int64_t>(left, 0)));
+            }
+            if (speed > 0)
+                maxLagMsec = std::max(maxLagMsec, msecSince(due));
+            send(record.data);
+            ++records;
+            loop.processEvents(0);
+        }
+        double sentMsec = msecSince(start);
+
+        // Replies still in flight when the trace ended
+        auto waitStart = Clock::now();
+        while (!finished && !pending.empty() && msecSince(waitStart) < waitMsec)
+            loop.processEvents(50);
+        size_t unanswered = pending.size();
+        if (!finished)
+            process.kill();
+        while (!finished && msecSince(waitStart) < waitMsec + 2000)
+            loop.processEvents(50);
+
+        return {{"mode", "to-server"},
+                {"records", records},
+                {"recordedMsec", static_cast<double>(recordedMicros) / 1000},
+                {"sentMsec", sentMsec},
+                {"wallMsec", msecSince(start)},
+                {"maxLagMsec", maxLagMsec},
+                {"unanswered", unanswered},
+                {"metrics", metrics.snapshot().toJson()}};
+    }
+
+  private:
+    struct Pending
+    {
+        std::string method;
+        Clock::time_point sentAt;
+    };
+
+    LSPEventLoop &loop;
+    LSPServerProcess &process;
+    MessageFramer framer;
+    MetricsRecorder metrics;
+    std::unordered_map<std::string, Pending> pending;
+    bool finished = false;
+
+    void send(const std::string &payload)
+    {
+        if (!process.isOpen())
+            return;
+        json message = json::parse(payload, nullptr, false);
+        if (message.is_object() && message.contains("method") && message.contains("id"))
+        {
+            std::string method = message["method"].get<std::string>();
+            pending[message["id"].dump()] = {method, Clock::now()};
+            metrics.requestSent(method);
+        }
+        metrics.messageOut(payload.size());
+        process.write(MessageFramer::frame(payload));
+    }
+
+    void transportOpened() override
+    {
+    }
+    void transportData(const char *data, size_t size) override
+    {
+        framer.append(data, size);
+        std::string payload;
+        while (framer.next(payload))
+        {
+            auto decodeStart = Clock::now();
+            json message = json::parse(payload, nullptr, false);
+            metrics.messageIn(payload.size(), micros(Clock::now() - decodeStart));
+            if (!message.is_object() || message.contains("method") || !message.contains("id"))
+                continue;
+            auto request = pending.find(message["id"].dump());
+            if (request == pending.end())
+            {
+                metrics.replyDiscarded();
+                continue;
+            }
+            metrics.requestAnswered(request->second.method, micros(Clock::now() - request->second.sentAt),
+                                    message.contains("error"));
+            pending.erase(request);
+        }
+    }
+    void transportClosed(int exitCode, bool crashed) override
+    {
+        finished = true;
+    }
+};
+
+int usage(const char *program)
+{
+    std::fprintf(stderr,
+                 "usage: %s --to-client [--speed=N] trace\n"
+                 "       %s --to-server [--speed=N] [--wait=msec] trace -- server [arguments...]\n"
+                 "       %s --dump trace\n",
+                 program, program, program);
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string mode, tracePath;
+    double speed = 1;
+    int waitMsec = 10000;
+    std::vector<std::string> server;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--to-client" || argument == "--to-server" || argument == "--dump")
+            mode = argument.substr(2);
+        else if (argument.compare(0, 8, "--speed=") == 0)
+            speed = std::atof(argument.c_str() + 8);
+        else if (argument.compare(0, 7, "--wait=") == 0)
+            waitMsec = std::atoi(argument.c_str() + 7);
+        else if (argument == "--")
+        {
+            server.assign(argv + i + 1, argv + argc);
+            break;
+        }
+        else if (tracePath.empty() && argument.compare(0, 2, "--") != 0)
+            tracePath = argument;
+        else
+            return usage(argv[0]);
+    }
+    if (mode.empty() || tracePath.empty() || (mode == "to-server") == server.empty())
+        return usage(argv[0]);
+
+    TraceReader reader;
+    if (!reader.open(tracePath))
+    {
+        std::fprintf(stderr, "%s\n", reader.errorString().c_str());
+        return 1;
+    }
+    if (mode == "dump")
+        return dump(reader);
+
+    json report;
+    if (mode == "to-client")
+    {
+        report = toClient(reader, speed);
+    }
+    else
+    {
+        LSPEventLoop loop;
+        LSPServerProcess process(loop, server[0], std::vector<std::string>(server.begin() + 1, server.end()));
+        ServerReplay replay(loop, process);
+        report = replay.run(reader, speed, waitMsec);
+    }
+    report["trace"] = tracePath;
+    report["speed"] = speed;
+    std::string text = report.dump(2) + "\n";
+    std::fwrite(text.data(), 1, text.size(), stdout);
+    return report.contains("error") ? 1 : 0;
+}
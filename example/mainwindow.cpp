@@ -102,9 +102,11 @@ void Mainwindow::OnNotify(QString method, QJsonObject param)
     // diagonistic notifiacation arrives here!
 }
 
-void Mainwindow::OnRequest(QString method, QJsonObject param, QJsonObject id)
+void Mainwindow::OnRequest(QString method, QJsonObject param, QJsonValue id)
 {
-    info->appendPlainText("Request[" + method + "]: " + jsonObjectToString(param) + "id: " + jsonObjectToString(id));
+    info->appendPlainText("Request[" + method + "]: " + jsonObjectToString(param) + "id: " + id.toVariant().toString());
+    // The server waits for an answer, tell it we can't help
+    lsp->sendErrorResponse(id, ErrorCode::MethodNotFound, "Not supported by the example client");
 }
 
 void Mainwindow::OnResponse(QJsonObject id, QJsonObject response)
@@ -16,7 +16,7 @@ public:
 public slots:
     void OnNotify(QString method, QJsonObject param);
     void OnResponse(QJsonObject id, QJsonObject response);
-    void OnRequest(QString method, QJsonObject param, QJsonObject id);
+    void OnRequest(QString method, QJsonObject param, QJsonValue id);
     void OnError(QJsonObject id, QJsonObject error);
     void OnServerError(QProcess::ProcessError error);
     void OnServerFinished(int exitCode, QProcess::ExitStatus status);
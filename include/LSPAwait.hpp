@@ -0,0 +1,226 @@
+#ifndef LSPAWAIT_HPP
+#define LSPAWAIT_HPP
+
+#include "LSPClient.hpp"
+#include <QPointer>
+#include <future>
+
+// Typed access to replies without matching RequestIDs against onResponse by hand.
+//
+//   LSPTask showHover(LSPClient &client, DocumentUri uri, Position pos)
+//   {
+//       Response<Hover> hover = co_await awaitResponse<Hover>(client, client.hover(uri, pos));
+//       if (hover.ok() && hover.result)
+//           ...
+//   }
+//
+// Replies are delivered through LSPClient::setResponseCallback from the Qt event
+// loop, so a coroutine always resumes on the client's thread. Destroying the
+// LSPTask of a suspended coroutine cancels the request it is waiting for.
+//
+// Without coroutine support (C++14/17 builds) futureResponse<T>() returns a
+// std::future instead. It is fulfilled by the event loop, so only wait on it
+// from another thread, or poll it with wait_for(0).
+
+template <typename T> struct Response
+{
+    /// The decoded result, empty on error or if the server answered null.
+    option<T> result;
+    /// The error object of the reply, null on success.
+    json error;
+
+    bool ok() const
+    {
+        return error.is_null();
+    }
+};
+
+namespace detail
+{
+template <typename T> Response<T> decodeResponse(const json &result, const json *error)
+{
+    Response<T> response;
+    if (error != nullptr)
+    {
+        response.error = *error;
+        return response;
+    }
+    if (!result.is_null())
+    {
+        try
+        {
+            response.result = result.get<T>();
+        }
+        catch (const json::exception &e)
+        {
+            response.error = {{"code", ErrorCode::ParseError}, {"message", e.what()}};
+        }
+    }
+    return response;
+}
+
+inline json rejectedError()
+{
+    return {{"code", ErrorCode::RequestCancelled}, {"message", "The request was rejected by backpressure"}};
+}
+
+// The id was never sent or has been answered already, so no reply is coming
+inline json notPendingError()
+{
+    return {{"code", ErrorCode::InvalidRequest}, {"message", "The request is not waiting for a reply"}};
+}
+} // namespace detail
+
+template <typename T> std::future<Response<T>> futureResponse(LSPClient &client, const LSPClient::RequestID &id)
+{
+    auto promise = std::make_shared<std::promise<Response<T>>>();
+    std::future<Response<T>> future = promise->get_future();
+    if (id.empty())
+    {
+        Response<T> rejected;
+        rejected.error = detail::rejectedError();
+        promise->set_value(std::move(rejected));
+        return future;
+    }
+    bool pending = client.setResponseCallback(id, [promise](const json &result, const json *error) {
+        promise->set_value(detail::decodeResponse<T>(result, error));
+    });
+    if (!pending)
+    {
+        Response<T> lost;
+        lost.error = detail::notPendingError();
+        promise->set_value(std::move(lost));
+    }
+    return future;
+}
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+
+#define LSPCLIENT_HAS_COROUTINES 1
+
+template <typename T> class ResponseAwaiter
+{
+  public:
+    ResponseAwaiter(LSPClient &client, LSPClient::RequestID id) : client(&client), id(std::move(id))
+    {
+    }
+
+    ResponseAwaiter(const ResponseAwaiter &) = delete;
+    ResponseAwaiter &operator=(const ResponseAwaiter &) = delete;
+
+    ~ResponseAwaiter()
+    {
+        // Still waiting means the coroutine was destroyed while suspended on us
+        if (waiting && client)
+            client->cancelRequest(id);
+    }
+
+    bool await_ready()
+    {
+        if (!id.empty())
+            return false;
+        response.error = detail::rejectedError();
+        return true;
+    }
+
+    // Returning false resumes the coroutine right away
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        waiting = client && client->setResponseCallback(id, [this, handle](const json &result, const json *error) {
+            waiting = false;
+            response = detail::decodeResponse<T>(result, error);
+            handle.resume();
+        });
+        if (!waiting)
+            response.error = detail::notPendingError();
+        return waiting;
+    }
+
+    Response<T> await_resume()
+    {
+        return std::move(response);
+    }
+
+  private:
+    QPointer<LSPClient> client;
+    LSPClient::RequestID id;
+    Response<T> response;
+    bool waiting = false;
+};
+
+template <typename T> ResponseAwaiter<T> awaitResponse(LSPClient &client, LSPClient::RequestID id)
+{
+    return ResponseAwaiter<T>(client, std::move(id));
+}
+
+// Owning handle of a coroutine that starts right away. Destroying it destroys
+// the coroutine frame, cancelling whatever request it is suspended on.
+class LSPTask
+{
+  public:
+    struct promise_type
+    {
+        LSPTask get_return_object()
+        {
+            return LSPTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void()
+        {
+        }
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+
+    LSPTask() = default;
+    LSPTask(LSPTask &&other) noexcept : handle(other.handle)
+    {
+        other.handle = nullptr;
+    }
+    LSPTask &operator=(LSPTask &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            handle = other.handle;
+            other.handle = nullptr;
+        }
+        return *this;
+    }
+    ~LSPTask()
+    {
+        reset();
+    }
+
+    bool done() const
+    {
+        return !handle || handle.done();
+    }
+
+    void reset()
+    {
+        if (handle)
+            handle.destroy();
+        handle = nullptr;
+    }
+
+  private:
+    explicit LSPTask(std::coroutine_handle<promise_type> handle) : handle(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+#endif
+
+#endif
@@ -1,20 +1,27 @@
 #ifndef LSPCLIENT_HPP
 #define LSPCLIENT_HPP
 
-#include "LSP.hpp"
-#include "LSPUri.hpp"
+#include "LSPClientCore.hpp"
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QJsonValue>
 #include <QObject>
 #include <QProcess>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <memory>
 
-class LSPClient : public QObject
+// Qt front end of LSPClientCore: runs the server in a QProcess and turns the
+// core's events into signals. All protocol state lives in the core.
+class LSPClient : public QObject, private LSPTransport, private LSPClientCore::Listener
 {
     Q_OBJECT
 
-    using RequestID = std::string;
-
   public:
+    using RequestID = LSPClientCore::RequestID;
+    using ResponseCallback = LSPClientCore::ResponseCallback;
+
     explicit LSPClient(QString processPath, QStringList args);
 
     LSPClient(LSPClient &&) = delete;
@@ -27,6 +34,10 @@ class LSPClient : public QObject
 
     // LSP methods Requests to send to server
     RequestID initialize(option<DocumentUri> rootUri = {});
+    // Sends initialize and initialized back to back without waiting for the reply,
+    // so a standby server is ready by the time the first document is opened.
+    // Anything sent afterwards (e.g. the first didOpen) is pipelined behind them.
+    RequestID prewarm(option<DocumentUri> rootUri = {});
     RequestID shutdown();
     RequestID sync();
     RequestID registerCapability();
@@ -55,14 +66,13 @@ class LSPClient : public QObject
     RequestID executeCommand(string_ref cmd, option<TweakArgs> tweakArgs = {},
                              option<WorkspaceEdit> workspaceEdit = {});
 
-    RequestID didChangeWatchedFiles(std::vector<FileEvent> &changes);
-    RequestID didChangeConfiguration(ConfigurationSettings &settings);
-
     // LSP methods notifications to Send to server
+    void didChangeConfiguration(ConfigurationSettings &settings);
     void exit();
     void initialized();
     void didOpen(DocumentUri uri, string_ref code, string_ref lang);
     void didClose(DocumentUri uri);
+    void didChangeWatchedFiles(std::vector<FileEvent> &changes);
     void didChange(DocumentUri uri, std::vector<TextDocumentContentChangeEvent> &changes,
                    option<bool> wantDiagnostics = {});
 
@@ -70,16 +80,124 @@ class LSPClient : public QObject
     void sendNotification(string_ref method, QJsonDocument &jsonDoc);
     RequestID sendRequest(string_ref method, QJsonDocument &jsonDoc);
 
+    // Replies to onRequest; workspace/configuration, window/workDoneProgress/create and
+    // client/(un)registerCapability are answered by the core and never emitted.
+    void sendResponse(const QJsonValue &id, const QJsonValue &result);
+    void sendErrorResponse(const QJsonValue &id, ErrorCode code, string_ref message);
+    // See LSPClientCore::setConfigurationSection
+    void setConfigurationSection(string_ref section, const QJsonValue &value);
+
+    // Number of requests that have been sent and not been answered yet
+    int inFlightRequests() const;
+
+    // Calls `callback` once when the reply to `id` arrives, without any signal/slot connection.
+    // If the server exits first, it gets a RequestCancelled error instead.
+    // Returns false if `id` isn't waiting for a reply, see LSPClientCore::setResponseCallback.
+    bool setResponseCallback(const RequestID &id, ResponseCallback callback);
+    // Forgets the callback of `id`; the request is dequeued if it was not written yet,
+    // otherwise the server is sent $/cancelRequest.
+    void cancelRequest(const RequestID &id);
+
+    const StartupTimeline &startupTimeline() const;
+
+    // See LSPClientCore::metrics(), metrics().toJson() for dashboards
+    MetricsSnapshot metrics() const;
+    void resetMetrics();
+
+    // Binary wire trace for lspclient_trace_replay, see LSPClientCore::startTrace
+    bool startTrace(const std::string &path, TraceOptions options = TraceOptions());
+    void stopTrace();
+    bool isTracing() const;
+    // Per-request spans for ui.perfetto.dev, see LSPClientCore::enableSpans
+    void enableSpans(size_t maxEvents = 100000);
+    void disableSpans();
+    SpanTracer *spans() const;
+    // Bytes per subsystem and a budget the caches are evicted to, see LSPClientCore::memoryUsage
+    MemoryUsage memoryUsage() const;
+    void setMemoryBudget(size_t bytes);
+    size_t memoryBudget() const;
+    void addMemoryCache(string_ref name, std::function<size_t()> usage, std::function<void(size_t bytes)> evict);
+
+    // Outgoing requests are queued per priority class, see RequestScheduler.
+    // By default every method is Interactive except outline/folding/colors/pulled diagnostics
+    // (Viewport) and workspace diagnostics (Background).
+    void setMethodPriority(string_ref method, RequestPriority priority);
+    void setInFlightLimit(RequestPriority priority, int limit);
+    SchedulerStats schedulerStats(RequestPriority priority) const;
+
+    // Bounds the requests in flight and the bytes waiting to be written. When a limit is hit,
+    // new requests are queued, replace an older queued request of the same method, or are
+    // rejected (an empty RequestID is returned) depending on the policy.
+    void setBackpressure(BackpressureLimits limits);
+    BackpressureLimits backpressure() const;
+    SendStatus lastSendStatus() const;
+    bool isCongested() const;
+    qint64 queuedBytes() const;
+
+    // Watches rootPath with inotify (Linux only) and reports changes matching the globs the
+    // server registers for workspace/didChangeWatchedFiles, one notification per batch.
+    // Must be called before initialize(), which then announces dynamic registration support.
+    bool watchFiles(const std::string &rootPath, int windowMsec = 200);
+    void setFileWatchers(const std::vector<FileSystemWatcher> &watchers);
+
+    // $/progress state and throughput, e.g. of background indexing; see ProgressTracker
+    ProgressTracker &progress();
+
+    // Pull diagnostics for visible and recently edited documents, see LSPClientCore::pullDiagnostics.
+    // enablePullDiagnostics() must be called before initialize(); results arrive as onDiagnosticsPulled.
+    void enablePullDiagnostics(DiagnosticPullOptions options = DiagnosticPullOptions());
+    void setDocumentVisible(DocumentUri uri, bool visible);
+    size_t pullDiagnostics();
+    RequestID documentDiagnostic(DocumentUri uri);
+    RequestID workspaceDiagnostic();
+
+    // Recent server output for crash reports and the batching of newStderr, see LSPClientCore::stderrLog
+    StderrLog &stderrLog();
+
+    // Restarts a crashed server and replays the open documents, see LSPClientCore::setRestartPolicy.
+    // onServerFinished is still emitted for the crash, followed by onServerRestarting.
+    void setRestartPolicy(RestartPolicy policy);
+    const RecoveryStats &recoveryStats() const;
+
+    // Requests sent while a PriorityScope is alive get its priority, e.g.
+    //   LSPClient::PriorityScope background(client, RequestPriority::Background);
+    //   for (auto &file : files) client.documentSymbol(file);
+    class PriorityScope : public LSPClientCore::PriorityScope
+    {
+      public:
+        PriorityScope(LSPClient &client, RequestPriority priority)
+            : LSPClientCore::PriorityScope(client.clientCore, priority)
+        {
+        }
+    };
+
+    // The Qt-free client underneath, for anything the adapter doesn't forward
+    LSPClientCore &core();
+
   signals:
     void onNotify(QString method, QJsonObject param);
-    void onResponse(QJsonObject id, QJsonObject response);
-    void onRequest(QString method, QJsonObject param, QJsonObject id);
-    void onError(QJsonObject id, QJsonObject error);
+    void onResponse(QJsonValue id, QJsonObject response);
+    void onRequest(QString method, QJsonObject param, QJsonValue id);
+    void onError(QJsonValue id, QJsonObject error);
     void onServerError(QProcess::ProcessError error);
     void onServerFinished(int exitCode, QProcess::ExitStatus status);
+    // Complete lines of server output, at most one batch per StderrOptions::batchMsec
     void newStderr(const QString &content);
+    void onStartupComplete(); // first diagnostics have arrived, startupTimeline() is complete
+    void onCongested();       // a backpressure limit has been hit
+    void onDecongested();     // back under half of every limit
+    void onRequestDropped(QString id, QString method);
+    void onServerRestarting(int attempt, int delayMsec);
+    void onServerRecovered(qint64 recoveryMsec); // the restarted server has the replayed state
+    // New diagnostics from textDocument/diagnostic or workspace/diagnostic, not sent for "unchanged"
+    void onDiagnosticsPulled(QString uri, QJsonArray diagnostics);
 
   private slots:
+    void onClientStarted();
+    void onClientBytesWritten(qint64 bytes);
+    void onFileWatcherActivated();
+    void onFileEventTimeout();
+    void onStderrTimeout();
     void onClientReadyReadStdout();
     void onClientReadyReadStderr();
     void onClientError(QProcess::ProcessError error);
@@ -87,19 +205,39 @@ class LSPClient : public QObject
 
   private:
     QProcess *clientProcess = nullptr;
-    std::vector<std::string> writeToServerBuffer;
-    bool hasInitialized = false;
-
-    void writeToServer(std::string &in);
+    LSPClientCore clientCore;
+    QProcess::ExitStatus lastExitStatus = QProcess::NormalExit;
+    bool restarting = false;
+
+    std::unique_ptr<QSocketNotifier> fileWatcherNotifier;
+    QTimer fileEventTimer;
+    QTimer stderrTimer;
+
+    // LSPTransport
+    bool isOpen() const override;
+    void write(const std::string &data) override;
+    int64_t bytesToWrite() const override;
+    bool restart(int delayMsec) override;
+
+    // LSPClientCore::Listener
+    void notification(const std::string &method, const json &params) override;
+    void response(const json &id, const json &result) override;
+    void error(const json &id, const json &error) override;
+    void request(const std::string &method, const json &params, const json &id) override;
+    void serverLog(const std::vector<LogLine> &lines, uint64_t skipped) override;
+    void serverFinished(int exitCode, bool crashed) override;
+    void startupComplete() override;
+    void congestionChanged(bool congested) override;
+    void requestDropped(const RequestID &id, const std::string &method) override;
+    void serverRestarting(int attempt, int delayMsec) override;
+    void serverRecovered(const RecoveryStats &stats) override;
+    void diagnosticsPulled(const std::string &uri, const json &diagnostics) override;
+
+    void scheduleFileEvents();
+    void scheduleStderr();
 
     QJsonDocument toJSONDoc(json &nlohman);
     json toNlohmann(QJsonDocument &doc);
-
-    void notify(string_ref method, json value);
-    void request(string_ref mthod, json param, RequestID id);
-
-    void SendNotification(string_ref method, json jsonDoc);
-    RequestID SendRequest(string_ref method, json jsonDoc);
 };
 
 #endif
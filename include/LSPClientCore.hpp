@@ -0,0 +1,499 @@
+#ifndef LSPCLIENTCORE_HPP
+#define LSPCLIENTCORE_HPP
+
+#include "LSP.hpp"
+#include "LSPDiagnostics.hpp"
+#include "LSPFileWatcher.hpp"
+#include "LSPFramer.hpp"
+#include "LSPMetrics.hpp"
+#include "LSPProgress.hpp"
+#include "LSPScheduler.hpp"
+#include "LSPSpans.hpp"
+#include "LSPStderr.hpp"
+#include "LSPSymbolCache.hpp"
+#include "LSPTrace.hpp"
+#include "LSPTransport.hpp"
+#include "LSPUri.hpp"
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+// Milliseconds since the client was constructed, -1 until the step has happened
+struct StartupTimeline
+{
+    int64_t processStarted = -1;
+    int64_t initializeSent = -1;
+    int64_t initializeReplied = -1;
+    int64_t firstDiagnostics = -1;
+};
+
+// Restarting the server after it exited without being asked to
+struct RestartPolicy
+{
+    bool enabled = false;
+    /// Consecutive attempts; the count starts over once a server stayed up for stableMsec.
+    int maxAttempts = 5;
+    /// Delay before the first attempt, doubled for each further one up to maxDelayMsec.
+    int initialDelayMsec = 200;
+    int maxDelayMsec = 10000;
+    int stableMsec = 60000;
+};
+
+struct RecoveryStats
+{
+    int restarts = 0;
+    /// From noticing the crash to the new server's reply to initialize, -1 before the first recovery.
+    int64_t lastRecoveryMsec = -1;
+    /// Size of the replay burst written to the new server.
+    size_t lastReplayBytes = 0;
+    size_t documentsReplayed = 0;
+    size_t requestsRetried = 0;
+    size_t requestsFailed = 0;
+};
+
+// The protocol side of a language server client, without any I/O or Qt.
+//
+// Builds JSON-RPC messages for the typed protocol methods, keeps the request
+// table, scheduler and backpressure state, and decodes whatever the transport
+// reads. Events are reported to a Listener on the thread driving the transport,
+// so it can sit on top of LSPServerProcess and an LSPEventLoop, or under the Qt
+// LSPClient adapter.
+class LSPClientCore : private LSPTransport::Receiver
+{
+  public:
+    using RequestID = std::string;
+    // Gets the decoded "result" of a reply, or its "error" object (then result is null)
+    using ResponseCallback = std::function<void(const json &result, const json *error)>;
+    // Answers a request the server sent by filling in `result`. Returning false hands the request
+    // to Listener::request instead, which then has to reply with sendResponse()/sendErrorResponse().
+    using RequestResponder = std::function<bool(const json &params, json &result)>;
+
+    // Every method has an empty default, override what you need
+    class Listener
+    {
+      public:
+        virtual ~Listener() = default;
+
+        virtual void notification(const std::string &method, const json &params)
+        {
+        }
+        virtual void response(const json &id, const json &result)
+        {
+        }
+        virtual void error(const json &id, const json &error)
+        {
+        }
+        /// A request from the server that no responder answered, reply with sendResponse().
+        virtual void request(const std::string &method, const json &params, const json &id)
+        {
+        }
+        virtual void serverStderr(const char *data, size_t size)
+        {
+        }
+        /// Complete stderr lines, batched and rate limited, see stderrLog(). They point into the log
+        /// and are only valid during the call; `skipped` lines since the last batch were left out.
+        virtual void serverLog(const std::vector<LogLine> &lines, uint64_t skipped)
+        {
+        }
+        virtual void serverFinished(int exitCode, bool crashed)
+        {
+        }
+        /// First diagnostics have arrived, startupTimeline() is complete.
+        virtual void startupComplete()
+        {
+        }
+        /// A backpressure limit has been hit (true), or usage is back under half of every limit.
+        virtual void congestionChanged(bool congested)
+        {
+        }
+        virtual void requestDropped(const RequestID &id, const std::string &method)
+        {
+        }
+        /// The server died and is started again after `delayMsec`.
+        virtual void serverRestarting(int attempt, int delayMsec)
+        {
+        }
+        /// A restarted server answered initialize, the replayed state is in place.
+        virtual void serverRecovered(const RecoveryStats &stats)
+        {
+        }
+        /// New pulled diagnostics for `uri`, the report's "items". Documents the server reported
+        /// unchanged are not passed on again.
+        virtual void diagnosticsPulled(const std::string &uri, const json &diagnostics)
+        {
+        }
+    };
+
+    explicit LSPClientCore(LSPTransport &transport, Listener *listener = nullptr);
+    ~LSPClientCore() override;
+
+    LSPClientCore(const LSPClientCore &) = delete;
+    LSPClientCore &operator=(const LSPClientCore &) = delete;
+
+    void setListener(Listener *listener);
+
+    // LSP methods Requests to send to server
+    RequestID initialize(option<DocumentUri> rootUri = {});
+    // Sends initialize and initialized back to back without waiting for the reply,
+    // so a standby server is ready by the time the first document is opened.
+    // Anything sent afterwards (e.g. the first didOpen) is pipelined behind them.
+    RequestID prewarm(option<DocumentUri> rootUri = {});
+    RequestID shutdown();
+    RequestID sync();
+    RequestID registerCapability();
+
+    RequestID rangeFomatting(DocumentUri uri, Range range);
+    RequestID foldingRange(DocumentUri uri);
+    RequestID selectionRange(DocumentUri uri, std::vector<Position> &positions);
+    RequestID onTypeFormatting(DocumentUri uri, Position position, string_ref ch);
+
+    RequestID formatting(DocumentUri uri);
+    RequestID codeAction(DocumentUri uri, Range range, CodeActionContext context);
+    RequestID completion(DocumentUri uri, Position position, option<CompletionContext> context = {});
+    RequestID signatureHelp(DocumentUri uri, Position position);
+    RequestID gotoDefinition(DocumentUri uri, Position position);
+    RequestID gotoDeclaration(DocumentUri uri, Position position);
+    RequestID references(DocumentUri uri, Position position);
+    RequestID switchSourceHeader(DocumentUri uri);
+    RequestID rename(DocumentUri uri, Position position, string_ref newName);
+    RequestID hover(DocumentUri uri, Position position);
+    RequestID documentSymbol(DocumentUri uri);
+    RequestID documentColor(DocumentUri uri);
+    RequestID documentHighlight(DocumentUri uri, Position position);
+    RequestID symbolInfo(DocumentUri uri, Position position);
+    RequestID typeHierarchy(DocumentUri uri, Position position, TypeHierarchyDirection direction, int resolve);
+    RequestID workspaceSymbol(string_ref query);
+    RequestID executeCommand(string_ref cmd, option<TweakArgs> tweakArgs = {},
+                             option<WorkspaceEdit> workspaceEdit = {});
+
+    // LSP methods notifications to Send to server
+    void didChangeConfiguration(ConfigurationSettings &settings);
+    void exit();
+    void initialized();
+    void didOpen(DocumentUri uri, string_ref code, string_ref lang = "cpp");
+    void didClose(DocumentUri uri);
+    void didChangeWatchedFiles(std::vector<FileEvent> &changes);
+    void didChange(DocumentUri uri, std::vector<TextDocumentContentChangeEvent> &changes,
+                   option<bool> wantDiagnostics = {});
+
+    // General sender and requester for sever
+    void sendNotification(string_ref method, json params);
+    // Returns an empty id if backpressure rejected the request
+    RequestID sendRequest(string_ref method, json params);
+
+    // Replies to a request the server sent, `id` as passed to Listener::request
+    void sendResponse(const json &id, json result);
+    void sendErrorResponse(const json &id, ErrorCode code, string_ref message, json data = json());
+
+    // Server requests with a responder are answered as soon as they are decoded and never reach
+    // the listener, so the server isn't kept waiting on the application. Built in:
+    //   workspace/configuration          the values set with setConfigurationSection(), else null
+    //   window/workDoneProgress/create   accepted
+    //   client/registerCapability        accepted (file watcher registrations are applied first)
+    //   client/unregisterCapability      accepted
+    //   workspace/diagnostic/refresh     accepted, pulls the due documents again
+    // Setting an empty responder removes it and the method goes to the listener again.
+    void setRequestResponder(string_ref method, RequestResponder responder);
+    // What workspace/configuration returns for `section`, a dotted path like "clangd.fallbackFlags".
+    // Asking for a parent section returns the object holding everything set below it.
+    void setConfigurationSection(string_ref section, json value);
+
+    // Work done progress reported by the server ($/progress), e.g. background indexing.
+    // The notifications still reach Listener::notification as well.
+    ProgressTracker &progress();
+
+    // Pull diagnostics (textDocument/diagnostic, workspace/diagnostic) for servers with a
+    // diagnosticProvider. Must be called before initialize(), which then announces the capability;
+    // it is off by default since some servers stop pushing diagnostics once a client can pull.
+    // Replies are handled by the client, new diagnostics go to Listener::diagnosticsPulled.
+    void enablePullDiagnostics(DiagnosticPullOptions options = DiagnosticPullOptions());
+    // Documents on screen are pulled by pullDiagnostics(), others only for a while after an edit.
+    void setDocumentVisible(DocumentUri uri, bool visible);
+    // Sends textDocument/diagnostic for every due document (see DiagnosticPuller), with the
+    // resultId of its last report so the server can answer "unchanged". Call it when editing
+    // pauses or the view scrolls. Returns the number of requests sent, 0 if the server can't
+    // be pulled from.
+    size_t pullDiagnostics();
+    // One document, due or not. Returns an empty id if the server can't be pulled from.
+    RequestID documentDiagnostic(DocumentUri uri);
+    // The whole workspace, with the resultIds of every document reported so far. Servers may
+    // hold the reply back until something changes. Returns an empty id without server support.
+    RequestID workspaceDiagnostic();
+    bool canPullDiagnostics() const;
+    const DiagnosticPuller &diagnosticPuller() const;
+
+    // Number of requests that have been sent and not been answered yet
+    int inFlightRequests() const;
+
+    // Calls `callback` once when the reply to `id` arrives.
+    // If the server exits first, it gets a RequestCancelled error instead.
+    // Returns false, dropping the callback, if `id` isn't waiting for a reply: empty, already
+    // answered or never sent.
+    bool setResponseCallback(const RequestID &id, ResponseCallback callback);
+    // Forgets the callback of `id`; the request is dequeued if it was not written yet,
+    // otherwise the server is sent $/cancelRequest.
+    void cancelRequest(const RequestID &id);
+
+    const StartupTimeline &startupTimeline() const;
+
+    // Traffic counters, per-method latency histograms and queue state. Counting is always on and
+    // costs a clock read per message; a snapshot walks one histogram per method, so polling it
+    // every second is fine. snapshot.toJson() gives the same as a JSON object for dashboards.
+    MetricsSnapshot metrics() const;
+    void resetMetrics();
+
+    // Records every message to and from the server, and its stderr, into a binary trace that
+    // lspclient_trace_replay plays back, see TraceRecorder. Returns false and sets traceError()
+    // if the trace can't be created. While no trace is running the cost is a null check.
+    bool startTrace(const std::string &path, TraceOptions options = TraceOptions());
+    void stopTrace();
+    bool isTracing() const;
+    std::string traceError() const;
+
+    // Spans of every request's way through the client, tagged with its id and method, from the
+    // scheduler queue to the response callback; see SpanTracer. spans()->writeFile("spans.json")
+    // gives a file for ui.perfetto.dev. While disabled, spans() is null and the cost is a null check.
+    void enableSpans(size_t maxEvents = 100000);
+    void disableSpans();
+    SpanTracer *spans() const;
+
+    // Bytes held per subsystem: buffers, the request table, document text, instrumentation and
+    // caches. The figures are counters kept as the data changes, so this is cheap to poll.
+    MemoryUsage memoryUsage() const;
+    // Once the total exceeds `bytes`, caches give memory back, the largest first, until it fits.
+    // Buffers, requests and documents are never dropped; they are what the client is working on.
+    // 0 disables the budget.
+    void setMemoryBudget(size_t bytes);
+    size_t memoryBudget() const;
+    // Adds a cache of the application, e.g. a SymbolCache, to memoryUsage() and the budget.
+    // `evict` is asked to free about `bytes`; freeing more or less is fine.
+    void addMemoryCache(string_ref name, std::function<size_t()> usage, std::function<void(size_t bytes)> evict);
+
+    // Stores the replies to documentSymbol() and workspaceSymbol() in `cache`, so the next session can
+    // answer from it while its server is still indexing. Looking entries up and flush() are left to the
+    // application. Outlines are stored under the hash of the text they were asked for, which is only
+    // known for documents opened after this call. The cache must outlive the client or be unset first.
+    void setSymbolCache(SymbolCache *cache);
+
+    // Server stderr split into lines and kept in a ring, the most recent of it for crash reports
+    // (stderrLog().tail()). Batches go to Listener::serverLog while stderr is being read, at most
+    // every StderrOptions::batchMsec; the owner of the event loop calls flushStderr() after
+    // stderrTimeout() so the last lines before the server goes quiet are not held back.
+    StderrLog &stderrLog();
+    /// Milliseconds until the pending lines are due, -1 if there are none.
+    int stderrTimeout() const;
+    /// Hands the pending lines to the listener if they are due.
+    void flushStderr();
+
+    // Outgoing requests are queued per priority class, see RequestScheduler.
+    // By default every method is Interactive except outline/folding/colors/pulled diagnostics
+    // (Viewport) and workspace diagnostics (Background).
+    void setMethodPriority(string_ref method, RequestPriority priority);
+    void setInFlightLimit(RequestPriority priority, int limit);
+    SchedulerStats schedulerStats(RequestPriority priority) const;
+
+    // Bounds the requests in flight and the bytes waiting to be written. When a limit is hit,
+    // new requests are queued, replace an older queued request of the same method, or are
+    // rejected (an empty RequestID is returned) depending on the policy.
+    void setBackpressure(BackpressureLimits limits);
+    BackpressureLimits backpressure() const;
+    SendStatus lastSendStatus() const;
+    bool isCongested() const;
+    int64_t queuedBytes() const;
+
+    // Watches rootPath with inotify (Linux only) and reports changes matching the globs the
+    // server registers for workspace/didChangeWatchedFiles, one notification per batch.
+    // Must be called before initialize(), which then announces dynamic registration support.
+    // The owner of the event loop polls fileWatcherFd() and calls readFileEvents() when it is
+    // readable, and flushFileEvents() after fileEventTimeout().
+    bool watchFiles(const std::string &rootPath, int windowMsec = 200);
+    void setFileWatchers(const std::vector<FileSystemWatcher> &watchers);
+    int fileWatcherFd() const;
+    void readFileEvents();
+    /// Milliseconds until the pending batch of file events is due, -1 if there is none.
+    int fileEventTimeout() const;
+    /// Sends the pending batch if it is due.
+    void flushFileEvents();
+
+    // When the server exits without shutdown()/exit() having been sent, it is restarted with
+    // exponential backoff and brought back to the current state in one pipelined burst:
+    // initialize, initialized, the merged configuration, and didOpen with the current text and
+    // version of every open document. Requests without a reply are sent again afterwards,
+    // except for methods with side effects (workspace/executeCommand), whose callbacks get a
+    // RequestCancelled error. Set the policy before opening documents; their text is only
+    // tracked while it is enabled.
+    void setRestartPolicy(RestartPolicy policy);
+    RestartPolicy restartPolicy() const;
+    void setRetryOnRestart(string_ref method, bool retry);
+    bool isRecovering() const;
+    const RecoveryStats &recoveryStats() const;
+
+    // Requests sent while a PriorityScope is alive get its priority, e.g.
+    //   LSPClientCore::PriorityScope background(client, RequestPriority::Background);
+    //   for (auto &file : files) client.documentSymbol(file);
+    class PriorityScope
+    {
+      public:
+        PriorityScope(LSPClientCore &client, RequestPriority priority);
+        ~PriorityScope();
+
+        PriorityScope(const PriorityScope &) = delete;
+        PriorityScope &operator=(const PriorityScope &) = delete;
+
+      private:
+        LSPClientCore &client;
+        option<RequestPriority> previous;
+    };
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingRequest
+    {
+        std::string method;
+        ResponseCallback callback;
+        // Kept while restarts are enabled, to send the request again to a new server
+        std::string payload;
+        RequestPriority priority = RequestPriority::Interactive;
+        Clock::time_point sentAt;
+        // Only set while spans are enabled
+        Clock::time_point writtenAt;
+        // What this entry adds to pendingBytes
+        size_t accounted = 0;
+        // Where the reply goes in the symbol cache, a uri or a query; empty if it isn't cached
+        std::string cacheKey;
+        uint64_t contentHash = 0;
+    };
+
+    struct TrackedDocument
+    {
+        std::string languageId;
+        std::string text;
+        int version = 0;
+        // False if the document was opened before text tracking was enabled
+        bool textKnown = false;
+        // What this entry adds to documentBytes
+        size_t accounted = 0;
+    };
+
+    struct MemoryCache
+    {
+        std::string name;
+        std::function<size_t()> usage;
+        std::function<void(size_t bytes)> evict;
+    };
+
+    LSPTransport &transport;
+    Listener *listener;
+    Listener noListener;
+
+    std::vector<std::string> writeToServerBuffer;
+    int64_t writeBufferBytes = 0;
+    bool hasInitialized = false;
+
+    MessageFramer framer;
+    std::unordered_map<RequestID, PendingRequest> pendingRequests;
+    unsigned long long lastRequestId = 0;
+
+    RequestScheduler scheduler;
+    std::map<std::string, RequestPriority> methodPriorities;
+    option<RequestPriority> priorityOverride;
+
+    BackpressureLimits limits;
+    SendStatus sendStatus = SendStatus::Sent;
+    bool congested = false;
+
+    std::unique_ptr<InotifyWatcher> fileWatcher;
+    FileWatchFilter fileWatchFilter;
+    FileEventCoalescer fileEvents;
+    std::map<std::string, std::vector<FileSystemWatcher>> watcherRegistrations;
+
+    Clock::time_point startupClock;
+    StartupTimeline timeline;
+    RequestID initializeId;
+    MetricsRecorder metricsRecorder;
+    std::unique_ptr<TraceRecorder> trace;
+    std::string lastTraceError;
+    std::unique_ptr<SpanTracer> spanTracer;
+    // When the first byte of the message being framed arrived, kept while spans are enabled
+    Clock::time_point readStart;
+
+    size_t pendingBytes = 0;
+    size_t documentBytes = 0;
+    size_t decodePeak = 0;
+    size_t budget = 0;
+    uint64_t evictions = 0;
+    std::vector<MemoryCache> memoryCaches;
+    SymbolCache *symbolCache = nullptr;
+
+    std::unordered_map<std::string, RequestResponder> responders;
+    ProgressTracker progressTracker;
+    DiagnosticPuller diagnosticPulls;
+    bool pullDiagnosticsEnabled = false;
+    // From the server's diagnosticProvider, read from its reply to initialize
+    bool diagnosticProvider = false;
+    bool workspaceDiagnostics = false;
+    option<std::string> diagnosticIdentifier;
+    StderrLog stderrLines;
+    std::vector<LogLine> stderrBatch;
+    json configurationSections = json::object();
+
+    std::unordered_map<std::string, TrackedDocument> documents;
+    json initializeParams;
+    option<ConfigurationSettings> configuration;
+    RestartPolicy restart;
+    RecoveryStats recovery;
+    std::map<std::string, bool> retryOnRestart;
+    std::vector<RequestID> retryRequests;
+    bool stopRequested = false;
+    // From the crash until the new server answers initialize
+    bool recovering = false;
+    // From the crash until the replay burst is written; document changes meanwhile are part of it
+    bool replayPending = false;
+    int restartAttempts = 0;
+    Clock::time_point crashedAt;
+    Clock::time_point recoveredAt;
+
+    // LSPTransport::Receiver
+    void transportOpened() override;
+    void transportData(const char *data, size_t size) override;
+    void transportStderr(const char *data, size_t size) override;
+    void transportClosed(int exitCode, bool crashed) override;
+    void transportDrained() override;
+
+    int64_t elapsed() const;
+    RequestID nextRequestId(string_ref method);
+    void handleMessage(const std::string &payload);
+    ResponseCallback requestFinished(const std::string &id, bool failed);
+    void failPendingRequests(const std::string &message);
+    void writeScheduled();
+    void handleRegistrations(const json &params, bool registering);
+    json configurationFor(const json &item) const;
+    void readServerCapabilities(const json &result);
+    void handleDiagnosticReport(const std::string &uri, const json &report, const uint64_t *change);
+    void cacheReply(const RequestID &id, std::string key, uint64_t contentHash);
+    void storeSymbols(const PendingRequest &pending, const json &result);
+    bool isOverLimit() const;
+    void updateCongestion();
+
+    void writeToServer(const std::string &content);
+    void writeRequest(const RequestID &id, const std::string &content);
+    void replySpans(const std::string &id, Clock::time_point decodeStart, Clock::time_point decodeEnd);
+    void flushWriteBuffer();
+    void deliverStderr();
+
+    void accountRequest(const RequestID &id, PendingRequest &pending);
+    void accountDocument(const std::string &uri, TrackedDocument &document);
+    void enforceMemoryBudget();
+
+    void notify(string_ref method, json value);
+    SendStatus request(string_ref method, json param, RequestID id);
+
+    bool scheduleRestart();
+    void replayState();
+    bool shouldRetry(const std::string &method) const;
+};
+
+#endif
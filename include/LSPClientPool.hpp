@@ -0,0 +1,103 @@
+#ifndef LSPCLIENTPOOL_HPP
+#define LSPCLIENTPOOL_HPP
+
+#include "LSPClient.hpp"
+#include <QElapsedTimer>
+#include <QTimer>
+#include <functional>
+#include <map>
+#include <memory>
+
+struct LanguageServerConfig
+{
+    QString program;
+    QStringList arguments;
+    /// Upper bound of server processes started for this language.
+    int maxInstances = 1;
+    /// Keep an initialized standby server around, so opening a document of a new
+    /// shard does not have to wait for a process to spawn and initialize.
+    /// The standby is initialized without a rootUri.
+    bool prewarm = false;
+};
+
+// Routes documents to one of several LSPClient instances.
+//
+// Documents are assigned by languageId and by a shard key computed from their
+// uri (for example the project root). Each distinct shard gets its own server
+// until the language's maxInstances is reached; after that, new shards go to
+// the instance with the fewest requests in flight. Instances without open
+// documents are shut down once they have been idle for idleTimeout.
+class LSPClientPool : public QObject
+{
+    Q_OBJECT
+
+  public:
+    using ShardKeyFunction = std::function<std::string(const std::string &uri)>;
+
+    explicit LSPClientPool(QObject *parent = nullptr);
+
+    LSPClientPool(LSPClientPool &&) = delete;
+    LSPClientPool(LSPClientPool &) = delete;
+
+    LSPClientPool &operator=(LSPClientPool &&) = delete;
+    LSPClientPool &operator=(LSPClientPool &) = delete;
+
+    ~LSPClientPool() override;
+
+    void setServer(const std::string &languageId, LanguageServerConfig config);
+
+    /// By default every document of a language shares one shard.
+    /// If the key is a uri, it is also used as rootUri when a new instance is initialized.
+    void setShardKey(ShardKeyFunction function);
+
+    /// Milliseconds an instance may stay without open documents, negative to keep instances forever.
+    void setIdleTimeout(int msec);
+
+    // Opens the document on the instance it is routed to, returns nullptr if the language has no server
+    LSPClient *didOpen(DocumentUri uri, string_ref code, string_ref languageId);
+    void didClose(DocumentUri uri);
+
+    // Instance the document was routed to, or nullptr if it is not open
+    LSPClient *clientFor(const std::string &uri) const;
+
+    int instanceCount(const std::string &languageId = std::string()) const;
+
+    // Sends shutdown/exit to all matching instances at once instead of one after the other
+    void shutdownIdle();
+    void shutdownAll();
+
+  signals:
+    void clientStarted(LSPClient *client, QString languageId, QString shardKey);
+    void clientStopped(LSPClient *client, QString languageId, QString shardKey);
+
+  private slots:
+    void onIdleCheck();
+
+  private:
+    struct Instance
+    {
+        std::string languageId;
+        std::string shardKey;
+        std::unique_ptr<LSPClient> client;
+        int openDocuments = 0;
+        qint64 idleSince = 0;
+        bool stopping = false;
+        bool standby = false;
+    };
+
+    std::map<std::string, LanguageServerConfig> servers;
+    std::vector<std::unique_ptr<Instance>> instances;
+    std::map<std::string, Instance *> documents;
+    ShardKeyFunction shardKey;
+    int idleTimeout = 60 * 1000;
+    QTimer idleTimer;
+    QElapsedTimer clock;
+
+    Instance *route(const std::string &uri, const std::string &languageId);
+    Instance *start(const std::string &languageId, const std::string &key, bool standby = false);
+    void prewarm(const std::string &languageId);
+    void stop(const std::vector<Instance *> &stopping);
+    void release(LSPClient *client);
+};
+
+#endif
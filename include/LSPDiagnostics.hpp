@@ -0,0 +1,89 @@
+#ifndef LSPDIAGNOSTICS_HPP
+#define LSPDIAGNOSTICS_HPP
+
+#include "LSPTypes.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct DiagnosticPullOptions
+{
+    /// Documents edited this recently are pulled even when they are not visible.
+    int recentEditMsec = 30000;
+};
+
+// What pull diagnostics (textDocument/diagnostic) remembers per document.
+//
+// Every report the server sends carries a resultId; sending it back as
+// previousResultId lets the server answer "unchanged" without a payload. Only
+// open documents that are visible, or were edited within recentEditMsec, are
+// due, and only once they changed since their last report or the server asked
+// for a refresh. A closed document keeps its resultId for workspace/diagnostic.
+class DiagnosticPuller
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit DiagnosticPuller(DiagnosticPullOptions options = DiagnosticPullOptions());
+
+    void setOptions(DiagnosticPullOptions options);
+    const DiagnosticPullOptions &options() const
+    {
+        return settings;
+    }
+
+    void opened(const std::string &uri, Clock::time_point now = Clock::now());
+    void edited(const std::string &uri, Clock::time_point now = Clock::now());
+    void closed(const std::string &uri);
+    void setVisible(const std::string &uri, bool visible);
+    bool isVisible(const std::string &uri) const;
+
+    /// Documents to pull now, visible ones first, then the most recently edited. Documents with
+    /// a request in flight are left out.
+    std::vector<std::string> due(Clock::time_point now = Clock::now()) const;
+
+    /// A request for `uri` is about to be sent with `previousResultId` (empty for none).
+    /// Returns the state it asks about, to pass to reported().
+    uint64_t started(const std::string &uri, std::string &previousResultId);
+    /// The reply to a request started(), "full" or "unchanged".
+    void reported(const std::string &uri, const std::string &resultId, uint64_t change);
+    /// The request failed or was cancelled, the document is due again.
+    void failed(const std::string &uri);
+    /// A report that was not asked for per document: workspace/diagnostic, relatedDocuments.
+    void remember(const std::string &uri, const std::string &resultId);
+
+    /// Every open document is due again, e.g. after workspace/diagnostic/refresh.
+    void refresh();
+    /// Drops every resultId, for a restarted server that never issued them, and refreshes.
+    void forgetResults();
+    void clear();
+
+    std::string resultId(const std::string &uri) const;
+    std::vector<PreviousResultId> previousResultIds() const;
+
+    size_t size() const
+    {
+        return documents.size();
+    }
+    size_t memoryUsage() const;
+
+  private:
+    struct Document
+    {
+        std::string resultId;
+        // Counts edits and refreshes; the document is stale while reportedChange is behind
+        uint64_t change = 1;
+        uint64_t reportedChange = 0;
+        Clock::time_point editedAt;
+        int pulling = 0;
+        bool open = false;
+        bool visible = false;
+    };
+
+    DiagnosticPullOptions settings;
+    std::unordered_map<std::string, Document> documents;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef LSPEDITS_HPP
+#define LSPEDITS_HPP
+
+#include "LSPTypes.hpp"
+#include <functional>
+
+// Applies TextEdit lists as returned by formatting, rename and codeAction.
+//
+// All edits of one document are resolved to byte offsets, sorted and checked
+// for overlaps first, and the new content is then produced in a single linear
+// pass over the old one. Documents that are not open in the editor are read
+// through a memory mapping and the result is streamed into a temporary file
+// that replaces the original only once every document of the edit is valid.
+
+/// A document whose content is owned by the caller (usually an open editor tab).
+struct OpenDocument
+{
+    std::string text;
+    /// The version last sent to the server, bumped by one for each applied edit.
+    int version = 0;
+};
+
+struct DocumentEditResult
+{
+    std::string uri;
+    bool applied = false;
+    std::string failureReason;
+    /// Versions before and after the edit, both -1 for files edited on disk.
+    int oldVersion = -1;
+    int newVersion = -1;
+};
+
+struct WorkspaceEditResult
+{
+    /// True if every document of the edit has been changed.
+    bool applied = false;
+    std::string failureReason;
+    std::vector<DocumentEditResult> documents;
+};
+
+/// Applies `edits` to `text`. On failure `text` is left untouched and `error` (if given) says why.
+/// Positions are interpreted in `encoding`, which must match the negotiated offsetEncoding.
+bool applyTextEdits(std::string &text, std::vector<TextEdit> edits, std::string *error = nullptr,
+                    OffsetEncoding encoding = OffsetEncoding::UTF8);
+
+class WorkspaceEditApplier
+{
+  public:
+    /// Returns the open document for `uri`, or nullptr if the file should be edited on disk.
+    using DocumentLookup = std::function<OpenDocument *(const std::string &uri)>;
+
+    explicit WorkspaceEditApplier(DocumentLookup lookup = {}, OffsetEncoding encoding = OffsetEncoding::UTF8);
+
+    /// Applies all changes of `edit`. Nothing is modified unless every document validates.
+    WorkspaceEditResult apply(const WorkspaceEdit &edit);
+    WorkspaceEditResult apply(const std::map<std::string, std::vector<TextEdit>> &changes);
+
+  private:
+    DocumentLookup lookup;
+    OffsetEncoding encoding;
+};
+
+#endif
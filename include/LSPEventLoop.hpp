@@ -0,0 +1,87 @@
+#ifndef LSPEVENTLOOP_HPP
+#define LSPEVENTLOOP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Minimal single-threaded event loop on top of epoll (Linux only), for running
+// LSPClientCore without Qt. Descriptors are level-triggered unless the caller
+// passes EPOLLET. Everything but post() must be called from the loop's thread.
+class LSPEventLoop
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+    /// Gets the epoll event mask that fired (EPOLLIN, EPOLLOUT, EPOLLHUP, ...).
+    using IOCallback = std::function<void(uint32_t events)>;
+    using Task = std::function<void()>;
+    using TimerID = uint64_t;
+
+    LSPEventLoop();
+    ~LSPEventLoop();
+
+    LSPEventLoop(const LSPEventLoop &) = delete;
+    LSPEventLoop &operator=(const LSPEventLoop &) = delete;
+
+    /// False if epoll could not be created.
+    bool isValid() const
+    {
+        return epollFd >= 0;
+    }
+
+    bool watch(int fd, uint32_t events, IOCallback callback);
+    bool modify(int fd, uint32_t events);
+    /// Safe to call from inside a callback, also for the descriptor being dispatched.
+    void unwatch(int fd);
+
+    /// Runs `task` once after `msec` milliseconds.
+    TimerID startTimer(int msec, Task task);
+    void cancelTimer(TimerID id);
+
+    /// Runs `task` on the loop's thread. The only thread-safe member.
+    void post(Task task);
+
+    /// Runs until quit(), returns its exit code.
+    int run();
+    void quit(int exitCode = 0);
+
+    /// Waits at most `timeoutMsec` (-1 for no limit) and dispatches whatever is ready once.
+    void processEvents(int timeoutMsec = -1);
+
+  private:
+    struct Watch
+    {
+        uint32_t generation;
+        IOCallback callback;
+    };
+    struct Timer
+    {
+        TimerID id;
+        Task task;
+    };
+
+    int epollFd = -1;
+    int wakeFd = -1;
+    uint32_t nextGeneration = 0;
+    std::unordered_map<int, Watch> watches;
+
+    TimerID lastTimerId = 0;
+    std::multimap<Clock::time_point, Timer> timers;
+    std::unordered_map<TimerID, std::multimap<Clock::time_point, Timer>::iterator> timerIndex;
+
+    std::mutex postedMutex;
+    std::vector<Task> posted;
+
+    bool running = false;
+    int exitCode = 0;
+
+    int nextTimeout(int timeoutMsec) const;
+    void runTimers();
+    void runPosted();
+};
+
+#endif
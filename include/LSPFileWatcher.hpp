@@ -0,0 +1,126 @@
+#ifndef LSPFILEWATCHER_HPP
+#define LSPFILEWATCHER_HPP
+
+#include "LSPTypes.hpp"
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+
+// Glob as used by FileSystemWatcher registrations: `*` and `?` stay within one
+// path segment, `**` spans segments, plus `[...]` classes and `{a,b}` alternatives.
+class GlobPattern
+{
+  public:
+    GlobPattern() = default;
+    explicit GlobPattern(const std::string &pattern);
+
+    bool matches(const std::string &path) const;
+
+  private:
+    // Brace alternatives are expanded up front, so matching never has to backtrack into them
+    std::vector<std::string> alternatives;
+};
+
+// Folds bursts of file events into one batch per path.
+//
+// Created+Changed stays Created, Created+Deleted cancels out, Deleted+Created
+// becomes Changed and anything followed by Deleted is Deleted. A batch is due
+// once no event arrived for `window`, or at the latest 4 windows after the first
+// event, so a build touching files without pause still gets reported.
+class FileEventCoalescer
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FileEventCoalescer(std::chrono::milliseconds window = std::chrono::milliseconds(200));
+
+    void setWindow(std::chrono::milliseconds window);
+    std::chrono::milliseconds window() const
+    {
+        return quietWindow;
+    }
+
+    void add(const std::string &path, FileChangeType type, Clock::time_point now = Clock::now());
+
+    bool empty() const
+    {
+        return pending.empty();
+    }
+    bool due(Clock::time_point now = Clock::now()) const;
+
+    /// Time left until the current batch is due.
+    std::chrono::milliseconds timeUntilDue(Clock::time_point now = Clock::now()) const;
+
+    std::vector<FileEvent> takeBatch();
+
+  private:
+    std::chrono::milliseconds quietWindow;
+    Clock::time_point first, last;
+    std::unordered_map<std::string, FileChangeType> pending;
+    std::vector<std::string> order;
+};
+
+// Recursive directory watcher on top of Linux inotify. On other platforms
+// isSupported() is false and nothing is ever reported.
+class InotifyWatcher
+{
+  public:
+    using Callback = std::function<void(const std::string &path, FileChangeType type)>;
+
+    InotifyWatcher();
+    ~InotifyWatcher();
+
+    InotifyWatcher(const InotifyWatcher &) = delete;
+    InotifyWatcher &operator=(const InotifyWatcher &) = delete;
+
+    static bool isSupported();
+
+    /// Watches `root` and every directory below it, except for the excluded directory names.
+    bool watchTree(const std::string &root);
+    void setExcludedDirectories(std::vector<std::string> names);
+
+    /// Pollable descriptor, readable whenever readEvents() has something to report.
+    int fd() const
+    {
+        return inotifyFd;
+    }
+
+    /// Reads everything that is pending without blocking. Returns false if the kernel queue
+    /// overflowed and events were lost, the caller should rescan in that case.
+    bool readEvents(const Callback &callback);
+    /// Walks the watched trees again after an overflow: directories that appeared get watched and
+    /// every file is reported as Changed, since what happened to it is unknown.
+    void rescan(const Callback &callback);
+
+  private:
+    int inotifyFd = -1;
+    std::vector<std::string> roots;
+    std::unordered_map<int, std::string> directories;
+    std::vector<std::string> excluded = {".git"};
+
+    void addDirectory(const std::string &path, const Callback *created);
+};
+
+// Matches file events against the watchers a server registered for
+// workspace/didChangeWatchedFiles and coalesces the matching ones.
+class FileWatchFilter
+{
+  public:
+    void setWatchers(const std::vector<FileSystemWatcher> &watchers);
+    bool empty() const
+    {
+        return watchers.empty();
+    }
+    bool accepts(const std::string &path, FileChangeType type) const;
+
+  private:
+    struct CompiledWatcher
+    {
+        std::string base;
+        GlobPattern glob;
+        int kind = 7;
+    };
+    std::vector<CompiledWatcher> watchers;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef LSPFRAMER_HPP
+#define LSPFRAMER_HPP
+
+#include <cstddef>
+#include <string>
+
+// Splits the server's stdout into Content-Length framed JSON-RPC payloads.
+// Input may arrive in arbitrary chunks: a read can hold several messages, or
+// end in the middle of a header or body; the remainder is kept for the next append.
+class MessageFramer
+{
+  public:
+    void append(const char *data, size_t size);
+
+    /// Moves the next complete payload into `payload`, returns false if none is buffered yet.
+    bool next(std::string &payload);
+
+    /// Number of bytes received but not yet returned as a payload.
+    size_t buffered() const
+    {
+        return buffer.size() - consumed;
+    }
+
+    void clear();
+
+    /// Bytes allocated for buffering, which stays at the size of the largest message seen.
+    size_t capacity() const
+    {
+        return buffer.capacity();
+    }
+
+    static std::string frame(const std::string &payload);
+
+  private:
+    std::string buffer;
+    size_t consumed = 0;
+    size_t contentLength = 0;
+    bool inBody = false;
+
+    bool parseHeader();
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef LSPFWD_HPP
+#define LSPFWD_HPP
+
+// Declares the protocol types of LSPTypes.hpp, for headers that only mention
+// them by reference or pointer.
+
+enum class ErrorCode;
+class LSPError;
+struct TextDocumentIdentifier;
+struct VersionedTextDocumentIdentifier;
+struct Position;
+struct Range;
+struct Location;
+struct TextEdit;
+struct TextDocumentItem;
+enum class TraceLevel;
+enum class TextDocumentSyncKind;
+enum class CompletionItemKind;
+enum class SymbolKind;
+enum class OffsetEncoding;
+enum class MarkupKind;
+enum class ResourceOperationKind;
+enum class FailureHandlingKind;
+struct ClientCapabilities;
+struct ClangdCompileCommand;
+struct ConfigurationSettings;
+struct InitializationOptions;
+struct InitializeParams;
+enum class MessageType;
+struct ShowMessageParams;
+struct Registration;
+struct RegistrationParams;
+struct UnregistrationParams;
+struct DidOpenTextDocumentParams;
+struct DidCloseTextDocumentParams;
+struct TextDocumentContentChangeEvent;
+struct DidChangeTextDocumentParams;
+enum class FileChangeType;
+struct FileEvent;
+struct DidChangeWatchedFilesParams;
+enum class WatchKind;
+struct FileSystemWatcher;
+struct DidChangeWatchedFilesRegistrationOptions;
+struct DidChangeConfigurationParams;
+struct DocumentRangeFormattingParams;
+struct DocumentOnTypeFormattingParams;
+struct FoldingRangeParams;
+enum class FoldingRangeKind;
+struct FoldingRange;
+struct SelectionRangeParams;
+struct SelectionRange;
+struct DocumentFormattingParams;
+struct DocumentSymbolParams;
+struct DiagnosticRelatedInformation;
+struct CodeAction;
+struct Diagnostic;
+struct PublishDiagnosticsParams;
+struct DocumentDiagnosticParams;
+struct PreviousResultId;
+struct WorkspaceDiagnosticParams;
+struct CodeActionContext;
+struct CodeActionParams;
+struct WorkspaceEdit;
+struct TweakArgs;
+struct ExecuteCommandParams;
+struct LspCommand;
+struct SymbolInformation;
+struct SymbolDetails;
+struct WorkspaceSymbolParams;
+struct ApplyWorkspaceEditParams;
+struct TextDocumentPositionParams;
+enum class CompletionTriggerKind;
+struct CompletionContext;
+struct CompletionParams;
+struct MarkupContent;
+struct Hover;
+enum class InsertTextFormat;
+struct CompletionItem;
+struct CompletionList;
+struct ParameterInformation;
+struct SignatureInformation;
+struct SignatureHelp;
+struct RenameParams;
+enum class DocumentHighlightKind;
+struct DocumentHighlight;
+enum class TypeHierarchyDirection;
+struct TypeHierarchyParams;
+struct TypeHierarchyItem;
+struct ReferenceParams;
+struct FileStatus;
+
+#endif
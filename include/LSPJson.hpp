@@ -0,0 +1,34 @@
+#ifndef LSPJSON_HPP
+#define LSPJSON_HPP
+
+#include "LSPUri.hpp"
+#include "nlohmann/json.hpp"
+
+// The complete nlohmann::json, for code that builds or reads JSON. LSPUri.hpp
+// only forward-declares it, which is all a header passing json by reference needs.
+
+namespace nlohmann {
+    template <typename T>
+    struct adl_serializer<option<T>> {
+        static void to_json(json& j, const option<T>& opt) {
+            if (opt.has()) {
+                j = opt.value();
+            } else {
+                j = nullptr;
+            }
+        }
+        static void from_json(const json& j, option<T>& opt) {
+            if (j.is_null()) {
+                opt = option<T>();
+            } else {
+                opt = option<T>(j.get<T>());
+            }
+        }
+    };
+}
+
+// basic_json<> is instantiated once, in src/LSPJson.cpp, instead of in every
+// translation unit that uses it.
+extern template class nlohmann::basic_json<>;
+
+#endif
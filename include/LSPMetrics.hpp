@@ -0,0 +1,190 @@
+#ifndef LSPMETRICS_HPP
+#define LSPMETRICS_HPP
+
+#include "LSPUri.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Log-linear histogram of durations in microseconds, in the style of HdrHistogram.
+//
+// Values below 64us are counted exactly; above that every power of two is split
+// into 32 linear buckets, so any recorded value is off by at most 1/32 (~3%).
+// Everything up to 2^40us (~12 days) fits into a fixed array of counters and
+// recording is a couple of bit operations.
+class LatencyHistogram
+{
+  public:
+    static const size_t bucketCount = 64 + 35 * 32;
+
+    void record(uint64_t micros);
+    void clear();
+
+    uint64_t count() const
+    {
+        return total;
+    }
+    uint64_t min() const
+    {
+        return total == 0 ? 0 : minimum;
+    }
+    uint64_t max() const
+    {
+        return maximum;
+    }
+    double mean() const
+    {
+        return total == 0 ? 0 : static_cast<double>(sum) / static_cast<double>(total);
+    }
+    /// Upper bound of the bucket holding the value at `fraction` (0..1) of the recorded values.
+    uint64_t percentile(double fraction) const;
+    /// Like percentile(), but looks up several ascending fractions in one pass.
+    void percentiles(const double *fractions, uint64_t *values, size_t count) const;
+
+    static size_t bucketFor(uint64_t micros);
+    static uint64_t bucketUpperBound(size_t bucket);
+
+  private:
+    std::array<uint64_t, bucketCount> counts{};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t minimum = UINT64_MAX;
+    uint64_t maximum = 0;
+};
+
+struct LatencySummary
+{
+    uint64_t count = 0;
+    double meanMsec = 0;
+    double p50Msec = 0;
+    double p90Msec = 0;
+    double p99Msec = 0;
+    double maxMsec = 0;
+};
+
+struct MethodMetrics
+{
+    std::string method;
+    uint64_t sent = 0;
+    uint64_t answered = 0;
+    /// Answered with an error object, including RequestCancelled replies.
+    uint64_t errors = 0;
+    /// cancelRequest() was called while it was queued or in flight.
+    uint64_t cancelled = 0;
+    /// Replaced by a newer request of the same method (OverflowPolicy::DropOldestSuperseded).
+    uint64_t superseded = 0;
+    /// Turned away by OverflowPolicy::Reject.
+    uint64_t rejected = 0;
+    /// From sendRequest() to the reply being decoded.
+    LatencySummary latency;
+};
+
+// Counters of one client, see LSPClientCore::metrics().
+struct MetricsSnapshot
+{
+    /// Milliseconds covered by the counters, since construction or the last resetMetrics().
+    int64_t intervalMsec = 0;
+
+    uint64_t messagesIn = 0;
+    uint64_t messagesOut = 0;
+    /// JSON payload bytes, without the Content-Length headers.
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    /// Replies whose request was already forgotten (cancelled, failed over a crash, unknown id).
+    uint64_t repliesDiscarded = 0;
+    /// Time to parse one incoming message.
+    LatencySummary decode;
+
+    /// Current state rather than counters.
+    size_t inFlight = 0;
+    /// Requests waiting in the scheduler, over all priority classes.
+    size_t queued = 0;
+    /// The deepest any priority class' queue has been.
+    size_t maxQueued = 0;
+    int64_t queuedBytes = 0;
+
+    std::vector<MethodMetrics> methods;
+
+    json toJson() const;
+};
+
+// Bytes held by one client, see LSPClientCore::memoryUsage(). Every figure comes from a
+// counter kept up to date as the data changes, nothing is walked to produce them.
+struct MemoryUsage
+{
+    struct Cache
+    {
+        std::string name;
+        size_t bytes = 0;
+    };
+
+    /// Server output that has not been framed into a message yet (the framer's buffer).
+    size_t receiveBuffer = 0;
+    /// Messages waiting for the transport to open plus what the transport has not written yet.
+    size_t sendBuffer = 0;
+    /// Requests held back by the scheduler.
+    size_t scheduledRequests = 0;
+    /// The request table, including payloads kept to retry them after a restart.
+    size_t pendingRequests = 0;
+    /// Text of open documents, kept to replay them after a restart, and their pull diagnostics state.
+    size_t documents = 0;
+    /// Metrics histograms, progress tokens, the wire trace buffer and the stderr ring.
+    size_t instrumentation = 0;
+    /// What the budget evicts from: spans and the caches added with addMemoryCache().
+    std::vector<Cache> caches;
+    /// Largest message decoded so far. Its JSON tree only lives while the message is dispatched,
+    /// so it is not part of total(), but expect a peak of several times this size.
+    size_t decodePeak = 0;
+
+    /// 0 if there is none.
+    size_t budget = 0;
+    /// How often the caches had to give memory back to stay within the budget.
+    uint64_t evictions = 0;
+
+    size_t total() const;
+    json toJson() const;
+};
+
+// Collects what goes into a MetricsSnapshot. All of it is plain counting on the
+// thread driving the client, there are no locks or atomics.
+class MetricsRecorder
+{
+  public:
+    MetricsRecorder();
+
+    void messageIn(size_t bytes, uint64_t decodeMicros);
+    void messageOut(size_t bytes);
+    void requestSent(const std::string &method);
+    void requestAnswered(const std::string &method, uint64_t micros, bool error);
+    void requestCancelled(const std::string &method);
+    void requestSuperseded(const std::string &method);
+    void requestRejected(const std::string &method);
+    void replyDiscarded();
+
+    /// Fills in everything but the queue state, which the client adds.
+    MetricsSnapshot snapshot() const;
+    void reset();
+    size_t memoryUsage() const;
+
+  private:
+    struct Method
+    {
+        MethodMetrics counters;
+        LatencyHistogram latency;
+    };
+
+    int64_t startedMsec = 0;
+    uint64_t messagesIn = 0;
+    uint64_t messagesOut = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t repliesDiscarded = 0;
+    LatencyHistogram decode;
+    std::unordered_map<std::string, Method> methods;
+
+    Method &method(const std::string &name);
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef LSPPROGRESS_HPP
+#define LSPPROGRESS_HPP
+
+#include "LSPUri.hpp"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// State of one work done progress token, e.g. clangd's background indexing
+struct ProgressInfo
+{
+    /// The token as sent by the server; numeric tokens are kept in their JSON spelling.
+    std::string token;
+    std::string title;
+    std::string message;
+    /// 0-100 as reported by the server, -1 if it never sent one.
+    int percentage = -1;
+    bool cancellable = false;
+    bool finished = false;
+
+    /// Wall time since "begin", the total once finished.
+    int64_t elapsedMsec = 0;
+    /// Taken from an "N/M" counter in the message (clangd: "indexing 12/345"), -1 if there is none.
+    int64_t itemsDone = -1;
+    int64_t itemsTotal = -1;
+    /// Items completed per second since the counter was first seen, 0 until it moved.
+    double itemsPerSecond = 0;
+    /// Estimated from the item rate, or from the percentage if there are no items; -1 if unknown.
+    int64_t remainingMsec = -1;
+};
+
+// Follows the begin/report/end lifecycle of $/progress tokens.
+//
+// Feed it the params of every $/progress notification (LSPClientCore does that
+// itself). Subscribers are throttled per token: "begin" and "end" are always
+// delivered, reports in between at most once per interval. The latest state of
+// every token can be read at any time with active().
+class ProgressTracker
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void(const ProgressInfo &progress)>;
+    using SubscriptionID = int;
+
+    /// Handles the params of a $/progress notification; returns false if it isn't work done progress.
+    bool handle(const json &params, Clock::time_point now = Clock::now());
+
+    /// Tokens between "begin" and "end", in the order they began.
+    std::vector<ProgressInfo> active() const;
+    /// The most recently finished tokens, oldest first (at most historySize()).
+    const std::deque<ProgressInfo> &finished() const
+    {
+        return history;
+    }
+    bool isBusy() const
+    {
+        return !running.empty();
+    }
+
+    void setHistorySize(size_t size);
+    size_t historySize() const
+    {
+        return maxHistory;
+    }
+
+    SubscriptionID subscribe(Callback callback, int intervalMsec = 250);
+    void unsubscribe(SubscriptionID id);
+
+    /// Forgets every running token, e.g. when the server exited.
+    void clear();
+
+    /// Fixed size of the tokens and history, their strings are not counted.
+    size_t memoryUsage() const;
+
+  private:
+    struct Token
+    {
+        ProgressInfo info;
+        uint64_t order = 0;
+        Clock::time_point begun;
+        // Where the item counter was when it was first seen, the rate is measured from there
+        int64_t firstItems = -1;
+        Clock::time_point firstItemsAt;
+    };
+
+    struct Subscription
+    {
+        Callback callback;
+        Clock::duration interval;
+        std::map<std::string, Clock::time_point> lastDelivered;
+    };
+
+    std::map<std::string, Token> running;
+    std::deque<ProgressInfo> history;
+    size_t maxHistory = 16;
+    uint64_t nextOrder = 0;
+
+    std::map<SubscriptionID, Subscription> subscriptions;
+    SubscriptionID lastSubscription = 0;
+
+    void update(Token &token, const json &value, Clock::time_point now);
+    void publish(const ProgressInfo &info, bool always, Clock::time_point now);
+};
+
+#endif
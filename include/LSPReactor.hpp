@@ -0,0 +1,84 @@
+#ifndef LSPREACTOR_HPP
+#define LSPREACTOR_HPP
+
+#include "LSPClientCore.hpp"
+#include "LSPEventLoop.hpp"
+#include "LSPServerProcess.hpp"
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Drives many server connections from a single thread.
+//
+// Every connection is an LSPServerProcess plus its own LSPClientCore (and so its
+// own framer and request table). The pipes are registered edge-triggered; when
+// one becomes readable the connection joins a FIFO ready list, and each round
+// reads at most readBudget() bytes from every ready connection before going back
+// to epoll. A connection with more data left goes to the back of the list, so a
+// server flooding its stdout gets one budget per round like everybody else.
+class LSPReactor
+{
+  public:
+    struct Connection
+    {
+        Connection(LSPEventLoop &loop, std::string program, std::vector<std::string> arguments,
+                   LSPClientCore::Listener *listener);
+
+        LSPServerProcess process;
+        LSPClientCore client;
+    };
+
+    explicit LSPReactor(size_t readBudget = 64 * 1024);
+    ~LSPReactor();
+
+    LSPReactor(const LSPReactor &) = delete;
+    LSPReactor &operator=(const LSPReactor &) = delete;
+
+    LSPEventLoop &loop()
+    {
+        return eventLoop;
+    }
+
+    /// Bytes read from one connection (stdout and stderr each) per round.
+    void setReadBudget(size_t bytes);
+    size_t readBudget() const
+    {
+        return budget;
+    }
+
+    /// Spawns a server; returns nullptr if that failed. The connection is owned by the reactor.
+    Connection *addServer(std::string program, std::vector<std::string> arguments,
+                          LSPClientCore::Listener *listener = nullptr);
+    /// Kills the server if it is still running. Safe to call from the connection's own callbacks,
+    /// it is destroyed once the current round is over.
+    void removeServer(Connection *connection);
+    size_t connectionCount() const
+    {
+        return connections.size();
+    }
+
+    /// Runs until quit(), returns its exit code.
+    int run();
+    void quit(int exitCode = 0);
+    /// One round: waits at most `timeoutMsec` for events (not at all if something is still
+    /// readable), then gives every ready connection its read budget.
+    void processEvents(int timeoutMsec = -1);
+
+  private:
+    friend class LSPServerProcess;
+
+    LSPEventLoop eventLoop;
+    size_t budget;
+    bool running = false;
+    int exitCode = 0;
+
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::vector<std::unique_ptr<Connection>> retired;
+    // Removed connections stay in here as nullptr until the round passes them
+    std::deque<LSPServerProcess *> ready;
+
+    void markReadable(LSPServerProcess *process, bool isStdout);
+    void serviceReady();
+};
+
+#endif
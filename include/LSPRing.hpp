@@ -0,0 +1,186 @@
+#ifndef LSPRING_HPP
+#define LSPRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+//
+// The producer only ever writes `tail` and the consumer only `head`; each side keeps
+// a cached copy of the other's index and only reloads it when the ring looks full
+// (or empty), so in steady state a push or pop touches no shared cache line but the slot.
+template <typename T> class SpscRing
+{
+  public:
+    /// `capacity` is rounded up to a power of two.
+    explicit SpscRing(size_t capacity = 1024)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask = size - 1;
+        slots.reset(new T[size]);
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+    /// Producer side. Returns false and leaves `value` untouched if the ring is full.
+    bool push(T &&value)
+    {
+        size_t t = tail.value.load(std::memory_order_relaxed);
+        if (t - producerHead == capacity())
+        {
+            producerHead = head.value.load(std::memory_order_acquire);
+            if (t - producerHead == capacity())
+                return false;
+        }
+        slots[t & mask] = std::move(value);
+        tail.value.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. Returns false if the ring is empty.
+    bool pop(T &value)
+    {
+        size_t h = head.value.load(std::memory_order_relaxed);
+        if (h == consumerTail)
+        {
+            consumerTail = tail.value.load(std::memory_order_acquire);
+            if (h == consumerTail)
+                return false;
+        }
+        value = std::move(slots[h & mask]);
+        head.value.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. Hands everything available to `f` and publishes the freed slots once
+    /// at the end, returns the number of elements consumed.
+    template <typename F> size_t drain(F &&f)
+    {
+        size_t h = head.value.load(std::memory_order_relaxed);
+        consumerTail = tail.value.load(std::memory_order_acquire);
+        size_t count = consumerTail - h;
+        for (; h != consumerTail; ++h)
+        {
+            f(std::move(slots[h & mask]));
+            slots[h & mask] = T();
+        }
+        head.value.store(h, std::memory_order_release);
+        return count;
+    }
+
+    /// Exact only on the consumer side, a hint anywhere else.
+    bool empty() const
+    {
+        return head.value.load(std::memory_order_acquire) == tail.value.load(std::memory_order_acquire);
+    }
+
+  private:
+    // Keeps the two indices (and each side's private state) on separate cache lines
+    struct alignas(64) Index
+    {
+        std::atomic<size_t> value{0};
+    };
+
+    Index head;
+    size_t consumerTail = 0;
+    alignas(64) Index tail;
+    size_t producerHead = 0;
+    alignas(64) size_t mask = 0;
+    std::unique_ptr<T[]> slots;
+};
+
+// SpscRing plus a wakeup that fires at most once per batch.
+//
+// The consumer is "armed" while it waits. The first send() after that disarms it and
+// calls the wake function, e.g. posting one event to the consumer's loop or writing an
+// eventfd; every further send() until the consumer drained the ring only pushes. The
+// consumer calls receive() when woken and gets everything queued so far in one go.
+template <typename T> class SpscChannel
+{
+  public:
+    using WakeFunction = std::function<void()>;
+
+    explicit SpscChannel(size_t capacity = 1024, WakeFunction wake = nullptr) : ring(capacity), wake(std::move(wake))
+    {
+    }
+
+    /// Must be set before the producer starts.
+    void setWakeFunction(WakeFunction function)
+    {
+        wake = std::move(function);
+    }
+
+    /// Producer side. Returns false if the ring is full; the producer should stop reading
+    /// its input until the consumer caught up rather than spin.
+    bool send(T &&value)
+    {
+        if (!ring.push(std::move(value)))
+            return false;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (armed.load(std::memory_order_relaxed) && armed.exchange(false) && wake)
+            wake();
+        return true;
+    }
+
+    /// Consumer side. Drains the ring into `f` and re-arms the wakeup.
+    template <typename F> size_t receive(F &&f)
+    {
+        size_t count = 0;
+        for (;;)
+        {
+            count += ring.drain(f);
+            armed.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ring.empty())
+                return count;
+            // Something arrived between draining and arming. If the producer already
+            // took the wakeup, leave it to that one; otherwise take it back and go on.
+            if (!armed.exchange(false))
+                return count;
+        }
+    }
+
+    bool empty() const
+    {
+        return ring.empty();
+    }
+    size_t capacity() const
+    {
+        return ring.capacity();
+    }
+
+  private:
+    SpscRing<T> ring;
+    WakeFunction wake;
+    std::atomic<bool> armed{true};
+};
+
+// One channel per direction between an I/O thread and the thread consuming messages.
+// LSPServerProcess and the Qt adapter do their I/O on the thread driving the client,
+// so nothing in the library uses this; it is for applications that move the transport
+// to a thread of their own.
+struct MessageChannels
+{
+    /// Decoded payloads read from the server, produced by the I/O thread.
+    SpscChannel<std::string> incoming;
+    /// Framed messages to write to the server, produced by the client thread.
+    SpscChannel<std::string> outgoing;
+
+    explicit MessageChannels(size_t capacity = 4096) : incoming(capacity), outgoing(capacity)
+    {
+    }
+};
+
+#endif
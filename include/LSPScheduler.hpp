@@ -0,0 +1,137 @@
+#ifndef LSPSCHEDULER_HPP
+#define LSPSCHEDULER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class RequestPriority
+{
+    /// Something the user is waiting for right now (completion, hover, ...).
+    Interactive = 0,
+    /// Results for what is currently on screen (outline, folding, colors).
+    Viewport = 1,
+    /// Sweeps the user does not wait for, e.g. symbols of every file in a project.
+    Background = 2,
+};
+
+enum class OverflowPolicy
+{
+    /// Keep queueing, the queue grows without bound.
+    Queue,
+    /// Drop the oldest queued request of the same method, which the new one supersedes
+    /// (e.g. an older completion). Queues if there is nothing to drop.
+    DropOldestSuperseded,
+    /// Don't send the request at all.
+    Reject,
+};
+
+// Limits after which the client counts as congested, 0 means no limit.
+struct BackpressureLimits
+{
+    /// Requests written to the server and not answered yet, over all priority classes.
+    int maxInFlight = 0;
+    /// Bytes waiting to be written: queued requests plus the process' write buffer.
+    int64_t maxQueuedBytes = 0;
+    OverflowPolicy policy = OverflowPolicy::Queue;
+};
+
+enum class SendStatus
+{
+    Sent,
+    Queued,
+    Rejected,
+};
+
+struct SchedulerStats
+{
+    size_t queueDepth = 0;
+    size_t maxQueueDepth = 0;
+    size_t inFlight = 0;
+    uint64_t sent = 0;
+    /// Time spent queued before being written, summed over all sent requests.
+    uint64_t totalWaitMicros = 0;
+    uint64_t maxWaitMicros = 0;
+};
+
+// Orders outgoing requests by priority class.
+//
+// Each class has a limit of requests in flight; requests beyond it wait in
+// a per-class FIFO until a reply frees a slot. Whenever slots are free, the
+// higher class is always written first, so an interactive request never waits
+// behind a background sweep. Notifications (document sync) don't go through
+// the scheduler at all and are written immediately.
+class RequestScheduler
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Message
+    {
+        std::string id;
+        std::string method;
+        std::string payload;
+        RequestPriority priority = RequestPriority::Interactive;
+        Clock::time_point enqueued;
+    };
+
+    RequestScheduler();
+
+    /// Maximum requests of `priority` in flight, 0 for no limit.
+    void setInFlightLimit(RequestPriority priority, int limit);
+    int inFlightLimit(RequestPriority priority) const;
+    /// Maximum requests in flight over all classes, 0 for no limit.
+    void setTotalInFlightLimit(int limit);
+
+    void submit(RequestPriority priority, std::string id, std::string method, std::string payload);
+
+    /// Moves every request that may be written now into `ready`, highest priority first.
+    void takeReady(std::vector<Message> &ready);
+
+    /// The reply to `id` arrived (or it was cancelled), freeing its slot.
+    void completed(const std::string &id);
+
+    /// Removes a request that has not been written yet, returns false if it is not queued.
+    bool remove(const std::string &id);
+
+    /// Removes the oldest queued (not yet written) request of `method`, returns its id or an empty string.
+    std::string dropOldest(const std::string &method);
+
+    /// Drops all queued and in-flight bookkeeping, e.g. when the server exits.
+    void clear();
+
+    bool hasQueued() const;
+    size_t queuedBytes() const
+    {
+        return bytesQueued;
+    }
+    size_t inFlightCount() const
+    {
+        return inFlight.size();
+    }
+    bool isInFlight(const std::string &id) const
+    {
+        return inFlight.count(id) != 0;
+    }
+    SchedulerStats stats(RequestPriority priority) const;
+
+  private:
+    static const int classCount = 3;
+
+    struct PriorityClass
+    {
+        std::deque<Message> queue;
+        int limit = 0;
+        SchedulerStats stats;
+    };
+
+    PriorityClass classes[classCount];
+    std::unordered_map<std::string, RequestPriority> inFlight;
+    int totalLimit = 0;
+    size_t bytesQueued = 0;
+};
+
+#endif
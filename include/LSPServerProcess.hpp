@@ -0,0 +1,91 @@
+#ifndef LSPSERVERPROCESS_HPP
+#define LSPSERVERPROCESS_HPP
+
+#include "LSPEventLoop.hpp"
+#include "LSPTransport.hpp"
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+class LSPReactor;
+
+// A language server started with posix_spawn, talking over non-blocking pipes
+// driven by an LSPEventLoop. This is the transport for running LSPClientCore
+// without Qt:
+//
+//   LSPEventLoop loop;
+//   LSPServerProcess server(loop, "clangd", {"--background-index"});
+//   LSPClientCore client(server, &listener);
+//   server.start();
+//   client.initialize(...);
+//   loop.run();
+//
+// SIGPIPE is ignored process-wide on the first start() (as QProcess does), so a
+// write to a server that just died fails with EPIPE instead of killing us.
+class LSPServerProcess : public LSPTransport
+{
+  public:
+    LSPServerProcess(LSPEventLoop &loop, std::string program, std::vector<std::string> arguments);
+    ~LSPServerProcess() override;
+
+    LSPServerProcess(const LSPServerProcess &) = delete;
+    LSPServerProcess &operator=(const LSPServerProcess &) = delete;
+
+    /// Spawns the server, returns false and sets errorString() if that failed.
+    bool start();
+    const std::string &errorString() const
+    {
+        return error;
+    }
+    pid_t pid() const
+    {
+        return processId;
+    }
+
+    /// Closes the server's stdin, e.g. after exit, so it sees EOF.
+    void closeWrite();
+    void terminate();
+    void kill();
+
+    bool isOpen() const override;
+    void write(const std::string &data) override;
+    int64_t bytesToWrite() const override;
+    bool restart(int delayMsec) override;
+
+  private:
+    friend class LSPReactor;
+
+    LSPEventLoop &loop;
+    // Set when driven by an LSPReactor, which then decides when the pipes are read
+    LSPReactor *reactor = nullptr;
+    std::string program;
+    std::vector<std::string> arguments;
+    std::string error;
+
+    pid_t processId = -1;
+    int stdinFd = -1;
+    int stdoutFd = -1;
+    int stderrFd = -1;
+
+    std::string outgoing;
+    size_t outgoingOffset = 0;
+
+    LSPEventLoop::TimerID reapTimer = 0;
+    LSPEventLoop::TimerID restartTimer = 0;
+    bool exited = false;
+
+    // Reactor bookkeeping: which pipes may still be readable, and whether we are on its ready list
+    bool stdoutReadable = false;
+    bool stderrReadable = false;
+    bool queued = false;
+
+    void onStdinWritable();
+    // Read at most `budget` bytes, return true if the pipe may still hold more
+    bool readStdout(size_t budget);
+    bool readStderr(size_t budget);
+    void closeFd(int &fd);
+    void flushOutgoing();
+    void reap();
+};
+
+#endif
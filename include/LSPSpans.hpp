@@ -0,0 +1,98 @@
+#ifndef LSPSPANS_HPP
+#define LSPSPANS_HPP
+
+#include "LSPUri.hpp"
+#include <chrono>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+// Timeline of where requests spend their time, exported in the Chrome trace
+// event format for chrome://tracing or ui.perfetto.dev.
+//
+// Every request becomes an async track named after its method, from begin() to
+// end(), with its stages nested inside:
+//
+//   serialize   building and dumping the JSON-RPC message
+//   queue       waiting in the RequestScheduler
+//   write       framing and handing it to the transport
+//   server      from the write until the first byte of the reply arrived
+//   read        until the whole reply was framed
+//   decode      json::parse of the reply
+//   dispatch    the listener and the response callback
+//
+// Work that belongs to no request of ours (notifications, server requests) is
+// recorded as complete events on a thread of its own. Events are kept in memory,
+// the oldest are dropped beyond maxEvents.
+class SpanTracer
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit SpanTracer(size_t maxEvents = 100000);
+
+    void begin(const std::string &id, const std::string &method, Clock::time_point at);
+    void stage(const std::string &id, const char *name, Clock::time_point start, Clock::time_point end);
+    /// Closes the request's track, `outcome` is e.g. "answered", "error" or "cancelled".
+    void end(const std::string &id, Clock::time_point at, const char *outcome);
+    /// Work outside of a request, e.g. decoding a notification.
+    void complete(const char *name, const std::string &method, Clock::time_point start, Clock::time_point end);
+
+    /// {"traceEvents": [...]} with timestamps in microseconds since the tracer was created.
+    json toJson() const;
+    bool writeFile(const std::string &path) const;
+    void clear();
+
+    size_t eventCount() const
+    {
+        return events.size();
+    }
+    size_t droppedEvents() const
+    {
+        return dropped;
+    }
+    size_t memoryUsage() const
+    {
+        return bytes;
+    }
+    /// Drops the oldest events until `wanted` bytes have been freed or none are left, returns what was freed.
+    size_t evict(size_t wanted);
+
+  private:
+    enum class Kind
+    {
+        Stage,
+        Request,
+        Complete,
+    };
+
+    struct Event
+    {
+        Kind kind;
+        const char *name;
+        std::string id;
+        std::string method;
+        const char *outcome;
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    struct OpenRequest
+    {
+        std::string method;
+        Clock::time_point start;
+    };
+
+    size_t maxEvents;
+    size_t dropped = 0;
+    size_t bytes = 0;
+    Clock::time_point origin;
+    std::deque<Event> events;
+    std::unordered_map<std::string, OpenRequest> open;
+
+    void add(Event event);
+    void dropOldest();
+    static size_t sizeOf(const Event &event);
+};
+
+#endif
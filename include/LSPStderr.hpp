@@ -0,0 +1,127 @@
+#ifndef LSPSTDERR_HPP
+#define LSPSTDERR_HPP
+
+#include "LSPUri.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class LogLevel : uint8_t
+{
+    Unknown, // no prefix, or parsing is off
+    Error,
+    Info,
+    Verbose,
+    Debug,
+};
+
+// One line of server output, pointing into the StderrLog it came from
+struct LogLine
+{
+    LogLevel level = LogLevel::Unknown;
+    /// "12:34:56.789" of clangd's "I[12:34:56.789] ..." prefix, empty without one.
+    string_ref time;
+    /// The line without the prefix.
+    string_ref text;
+    /// The whole line as the server wrote it, without the line break.
+    string_ref line;
+};
+
+struct StderrOptions
+{
+    /// Most recent output kept for crash reports; older lines are dropped as new ones arrive.
+    size_t ringBytes = 64 * 1024;
+    /// Split clangd's E/I/V/D[time] prefixes off into LogLine::level and time.
+    bool parseLevels = true;
+    /// Lines are handed over at most this often, in one batch.
+    int batchMsec = 100;
+    /// A batch carries at most the newest this many lines, the older ones are skipped. 0 for no limit.
+    size_t maxBatchLines = 500;
+};
+
+// Server stderr split into complete lines and kept in a fixed ring of bytes.
+//
+// Chunks are cut wherever the pipe happened to be read, so the tail of a chunk
+// waits for the rest of its line. Lines are copied into the ring once, with a
+// 4 byte length in front of each; nothing is allocated per line. The consumer
+// takes them in batches, at most every batchMsec, which bounds the rate of
+// e.g. GUI updates for a server logging thousands of lines per second. Lines
+// the ring overwrote before they were taken, or beyond maxBatchLines, count as
+// skipped.
+class StderrLog
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit StderrLog(StderrOptions options = StderrOptions());
+
+    /// Keeps the current lines if the ring size stays the same.
+    void setOptions(StderrOptions options);
+    const StderrOptions &options() const
+    {
+        return settings;
+    }
+
+    void append(const char *data, size_t size);
+    /// Ends a line the server did not finish, e.g. because it exited.
+    void finish();
+    void clear();
+
+    bool hasPending() const
+    {
+        return delivered < nextSequence;
+    }
+    bool due(Clock::time_point now = Clock::now()) const;
+    /// Time left until the pending lines are due, -1 if there are none.
+    std::chrono::milliseconds timeUntilDue(Clock::time_point now = Clock::now()) const;
+
+    /// Fills `lines` with what arrived since the last batch and returns how many lines were skipped.
+    /// The lines are valid until the next call that changes the log.
+    uint64_t takeBatch(std::vector<LogLine> &lines, Clock::time_point now = Clock::now());
+
+    /// Everything still in the ring, oldest first, one line each, e.g. for a crash report.
+    std::string tail() const;
+
+    /// Complete lines seen since the log was created or cleared.
+    uint64_t lineCount() const
+    {
+        return nextSequence;
+    }
+    uint64_t skippedLines() const
+    {
+        return skipped;
+    }
+    size_t memoryUsage() const
+    {
+        return ring.capacity() + partial.capacity() + scratch.capacity();
+    }
+
+  private:
+    StderrOptions settings;
+    std::string ring;
+    // Offset of the oldest record and bytes in use, records may wrap around the end
+    size_t start = 0;
+    size_t used = 0;
+    // Offset of the first record not taken yet
+    size_t deliverOffset = 0;
+    uint64_t firstSequence = 0;
+    uint64_t nextSequence = 0;
+    uint64_t delivered = 0;
+    uint64_t skipped = 0;
+    uint64_t skippedBefore = 0;
+    Clock::time_point lastBatch;
+    // Start of a line whose end has not arrived yet
+    std::string partial;
+    // The one record of a batch that wraps around the end of the ring
+    std::string scratch;
+
+    void push(const char *data, size_t size);
+    void dropOldest();
+    void copyIn(size_t offset, const char *data, size_t size);
+    void copyOut(size_t offset, char *out, size_t size) const;
+    uint32_t recordSize(size_t offset) const;
+    LogLine parse(const char *data, size_t size) const;
+};
+
+#endif
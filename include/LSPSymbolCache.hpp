@@ -0,0 +1,89 @@
+#ifndef LSPSYMBOLCACHE_HPP
+#define LSPSYMBOLCACHE_HPP
+
+#include "LSPUri.hpp"
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class MappedFile;
+
+// Persistent cache for textDocument/documentSymbol and workspace/symbol replies,
+// so an editor can answer "go to symbol" right after a restart while the server
+// is still indexing.
+//
+// The file is memory mapped and only the entries that are looked up get decoded.
+// Layout (native byte order, the file is dropped if the header does not match):
+//
+//   Header   magic "LSPSYMC1", u32 format version, u32 entry count
+//   Index    entry count x { u64 key, u64 content hash, u64 blob offset, u64 blob size }
+//            sorted by key
+//   Blobs    CBOR encoded { "name", "stamps", "result" }
+//
+// documentSymbol entries are keyed by uri and only returned for the content hash
+// they were stored with. workspace/symbol entries are keyed by query and remember
+// the size, mtime and content hash of every file they point into; they are
+// revalidated on lookup and dropped once one of those files has changed.
+//
+// LSPClientCore::setSymbolCache() stores the client's replies; lookups and
+// flush() are up to the application, e.g. answering from the cache until the
+// server's own reply arrives and flushing on exit.
+class SymbolCache
+{
+  public:
+    explicit SymbolCache(std::string path);
+    ~SymbolCache();
+
+    SymbolCache(const SymbolCache &) = delete;
+    SymbolCache &operator=(const SymbolCache &) = delete;
+
+    static uint64_t contentHash(const char *data, size_t size);
+    static uint64_t contentHash(const std::string &content)
+    {
+        return contentHash(content.data(), content.size());
+    }
+
+    bool lookupDocumentSymbols(const std::string &uri, uint64_t contentHash, json &result);
+    void storeDocumentSymbols(const std::string &uri, uint64_t contentHash, const json &result);
+
+    bool lookupWorkspaceSymbols(const std::string &query, json &result);
+    void storeWorkspaceSymbols(const std::string &query, const json &result);
+
+    void invalidate(const std::string &uri);
+    void clear();
+
+    /// Writes all entries to disk, replacing the cache file atomically.
+    bool flush();
+
+    size_t size() const;
+    /// Entries stored since the last flush(), held in memory; flush() gives it back.
+    size_t memoryUsage() const
+    {
+        return updatedBytes;
+    }
+
+  private:
+    struct Entry
+    {
+        uint64_t contentHash = 0;
+        std::vector<uint8_t> blob;
+    };
+
+    std::string path;
+    std::unique_ptr<MappedFile> mapped;
+    const char *index = nullptr;
+    uint32_t mappedCount = 0;
+
+    std::unordered_map<uint64_t, Entry> updated;
+    std::unordered_set<uint64_t> removed;
+    size_t updatedBytes = 0;
+
+    void load();
+    bool find(uint64_t key, uint64_t &contentHash, const uint8_t *&blob, size_t &blobSize) const;
+    bool lookup(uint64_t key, const std::string &name, const uint64_t *contentHash, json &entry);
+    void store(uint64_t key, uint64_t contentHash, json entry);
+    void remove(uint64_t key);
+};
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef LSPTRACE_HPP
+#define LSPTRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+enum class TraceDirection : uint8_t
+{
+    ToServer = 0,
+    FromServer = 1,
+    ServerStderr = 2,
+};
+
+struct TraceRecord
+{
+    TraceDirection direction = TraceDirection::ToServer;
+    /// Microseconds since the recording was started, from the monotonic clock.
+    uint64_t micros = 0;
+    /// A message's JSON payload without its Content-Length header, or a chunk of stderr.
+    std::string data;
+};
+
+struct TraceOptions
+{
+    /// A new segment is started once the current one would grow past this, 0 writes one unbounded file.
+    uint64_t segmentBytes = 64ull << 20;
+    /// Segments kept on disk; when all are used the oldest is overwritten.
+    unsigned segmentCount = 4;
+    /// Records are collected in memory and written in blocks of about this size.
+    size_t bufferBytes = 256 << 10;
+    bool recordStderr = true;
+};
+
+// Binary recording of the traffic between LSPClientCore and a server, so a slow
+// session can be played back exactly with lspclient_trace_replay.
+//
+// Every message is recorded whole, so each segment starts at a message boundary
+// and can be replayed by itself. Layout (native byte order):
+//
+//   Header   magic "LSPTRAC1", u32 format version, u32 segment sequence number,
+//            i64 wall clock start of the recording in msec since the epoch
+//   Records  { u8 direction, u64 micros since start, u32 size, size bytes of data }
+//
+// With segmentBytes set the segments are named path.0, path.1, ... and used as a
+// ring of segmentCount files; the sequence number gives their order. Otherwise
+// everything goes to `path` itself.
+//
+// Recording costs a clock read and a copy into the buffer per message; the
+// buffer is written out when it is full, so there is one fwrite per bufferBytes.
+// If writing fails, recording stops and errorString() tells why.
+class TraceRecorder
+{
+  public:
+    TraceRecorder(std::string path, TraceOptions options = TraceOptions());
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder &) = delete;
+    TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+    /// Creates the first segment, returns false and sets errorString() if that failed.
+    bool open();
+    bool isRecording() const
+    {
+        return file != nullptr;
+    }
+    const std::string &errorString() const
+    {
+        return error;
+    }
+    const TraceOptions &options() const
+    {
+        return settings;
+    }
+
+    void record(TraceDirection direction, const char *data, size_t size);
+    void record(TraceDirection direction, const std::string &data)
+    {
+        record(direction, data.data(), data.size());
+    }
+    /// Writes out what is buffered, e.g. before handing the trace to someone.
+    void flush();
+    void close();
+
+    uint64_t recordCount() const
+    {
+        return records;
+    }
+    /// Everything recorded so far, including what was overwritten by the ring.
+    uint64_t recordedBytes() const
+    {
+        return totalBytes;
+    }
+    /// The write buffer, about bufferBytes while recording.
+    size_t memoryUsage() const
+    {
+        return buffer.capacity();
+    }
+
+    /// The file holding segment `sequence` of a trace at `path`.
+    static std::string segmentPath(const std::string &path, const TraceOptions &options, uint32_t sequence);
+
+  private:
+    std::string path;
+    TraceOptions settings;
+    std::string error;
+
+    FILE *file = nullptr;
+    std::string buffer;
+    uint32_t sequence = 0;
+    uint64_t segmentSize = 0;
+    uint64_t records = 0;
+    uint64_t totalBytes = 0;
+    int64_t startedWallMsec = 0;
+    std::chrono::steady_clock::time_point startedAt;
+
+    bool startSegment();
+    bool writeBuffer();
+    void fail(const std::string &message);
+};
+
+// Reads the records of a trace in order, following rotated segments.
+class TraceReader
+{
+  public:
+    TraceReader();
+    ~TraceReader();
+
+    TraceReader(const TraceReader &) = delete;
+    TraceReader &operator=(const TraceReader &) = delete;
+
+    /// Opens `path` itself, or else the segments path.0, path.1, ... oldest first.
+    bool open(const std::string &path);
+    const std::string &errorString() const
+    {
+        return error;
+    }
+    /// Wall clock start of the recording in msec since the epoch.
+    int64_t startedWallMsec() const
+    {
+        return startedWall;
+    }
+
+    /// Moves to the next record, returns false at the end of the trace.
+    /// A record cut off by a crash of the recording process ends its segment.
+    bool next(TraceRecord &record);
+
+  private:
+    std::vector<std::string> segments;
+    size_t segmentIndex = 0;
+    std::unique_ptr<MappedFile> mapped;
+    size_t offset = 0;
+    int64_t startedWall = 0;
+    std::string error;
+
+    bool openSegment(size_t index);
+};
+
+#endif
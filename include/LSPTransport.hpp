@@ -0,0 +1,57 @@
+#ifndef LSPTRANSPORT_HPP
+#define LSPTRANSPORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// The byte pipe between LSPClientCore and a server, e.g. the stdio of a
+// child process. The transport owns the I/O; it hands everything it reads to
+// its receiver and never interprets the bytes itself.
+class LSPTransport
+{
+  public:
+    class Receiver
+    {
+      public:
+        virtual ~Receiver() = default;
+
+        /// The transport can be written to now; anything written before was buffered by the receiver.
+        virtual void transportOpened() = 0;
+        /// A chunk of the server's stdout, split at arbitrary points.
+        virtual void transportData(const char *data, size_t size) = 0;
+        virtual void transportStderr(const char *data, size_t size)
+        {
+        }
+        /// The server is gone. `crashed` is true if it was killed by a signal.
+        virtual void transportClosed(int exitCode, bool crashed) = 0;
+        /// Bytes queued in the transport have been written, so write buffer usage went down.
+        virtual void transportDrained()
+        {
+        }
+    };
+
+    virtual ~LSPTransport() = default;
+
+    void setReceiver(Receiver *newReceiver)
+    {
+        receiver = newReceiver;
+    }
+
+    virtual bool isOpen() const = 0;
+    /// Writes or queues an already framed message. Only called while isOpen().
+    virtual void write(const std::string &data) = 0;
+    /// Bytes accepted by write() that have not reached the pipe yet.
+    virtual int64_t bytesToWrite() const = 0;
+    /// Starts the server again after `delayMsec`, reporting transportOpened() once it runs or
+    /// transportClosed() if it could not be started. Returns false if restarting isn't supported.
+    virtual bool restart(int delayMsec)
+    {
+        return false;
+    }
+
+  protected:
+    Receiver *receiver = nullptr;
+};
+
+#endif
@@ -0,0 +1,1051 @@
+//
+// Created by Alex on 2020/1/28.
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+// Most of the code comes from clangd(Protocol.h)
+
+#ifndef LSPTYPES_HPP
+#define LSPTYPES_HPP
+#include "LSPUri.hpp"
+#include <map>
+#include <string>
+#include <tuple>
+#include <memory>
+#include <vector>
+
+// The protocol types on their own. Their JSON serializers are in LSP.hpp and
+// compiled once into the library, so code that only fills in or reads these
+// structs never parses nlohmann/json.hpp.
+
+using TextType = string_ref;
+enum class ErrorCode
+{
+    // Defined by JSON RPC.
+    ParseError = -32700,
+    InvalidRequest = -32600,
+    MethodNotFound = -32601,
+    InvalidParams = -32602,
+    InternalError = -32603,
+    ServerNotInitialized = -32002,
+    UnknownErrorCode = -32001,
+    // Defined by the protocol.
+    RequestCancelled = -32800,
+};
+class LSPError
+{
+  public:
+    TextType Message;
+    ErrorCode Code;
+    static char ID;
+    LSPError(TextType Message, ErrorCode Code) : Message(Message), Code(Code)
+    {
+    }
+};
+struct TextDocumentIdentifier
+{
+    /// The text document's URI.
+    DocumentUri uri;
+};
+
+struct VersionedTextDocumentIdentifier : public TextDocumentIdentifier
+{
+    int version = 0;
+};
+
+struct Position
+{
+    /// Line position in a document (zero-based).
+    int line = 0;
+    /// Character offset on a line in a document (zero-based).
+    /// WARNING: this is in UTF-16 codepoints, not bytes or characters!
+    /// Use the functions in SourceCode.h to construct/interpret Positions.
+    int character = 0;
+    friend bool operator==(const Position &LHS, const Position &RHS)
+    {
+        return std::tie(LHS.line, LHS.character) == std::tie(RHS.line, RHS.character);
+    }
+    friend bool operator!=(const Position &LHS, const Position &RHS)
+    {
+        return !(LHS == RHS);
+    }
+    friend bool operator<(const Position &LHS, const Position &RHS)
+    {
+        return std::tie(LHS.line, LHS.character) < std::tie(RHS.line, RHS.character);
+    }
+    friend bool operator<=(const Position &LHS, const Position &RHS)
+    {
+        return std::tie(LHS.line, LHS.character) <= std::tie(RHS.line, RHS.character);
+    }
+};
+
+struct Range
+{
+    /// The range's start position.
+    Position start;
+
+    /// The range's end position.
+    Position end;
+
+    friend bool operator==(const Range &LHS, const Range &RHS)
+    {
+        return std::tie(LHS.start, LHS.end) == std::tie(RHS.start, RHS.end);
+    }
+    friend bool operator!=(const Range &LHS, const Range &RHS)
+    {
+        return !(LHS == RHS);
+    }
+    friend bool operator<(const Range &LHS, const Range &RHS)
+    {
+        return std::tie(LHS.start, LHS.end) < std::tie(RHS.start, RHS.end);
+    }
+    bool contains(Position Pos) const
+    {
+        return start <= Pos && Pos < end;
+    }
+    bool contains(Range Rng) const
+    {
+        return start <= Rng.start && Rng.end <= end;
+    }
+};
+
+struct Location
+{
+    /// The text document's URI.
+    std::string uri;
+    Range range;
+
+    friend bool operator==(const Location &LHS, const Location &RHS)
+    {
+        return LHS.uri == RHS.uri && LHS.range == RHS.range;
+    }
+    friend bool operator!=(const Location &LHS, const Location &RHS)
+    {
+        return !(LHS == RHS);
+    }
+    friend bool operator<(const Location &LHS, const Location &RHS)
+    {
+        return std::tie(LHS.uri, LHS.range) < std::tie(RHS.uri, RHS.range);
+    }
+};
+
+struct TextEdit
+{
+    /// The range of the text document to be manipulated. To insert
+    /// text into a document create a range where start === end.
+    Range range;
+
+    /// The string to be inserted. For delete operations use an
+    /// empty string.
+    std::string newText;
+};
+
+struct TextDocumentItem
+{
+    /// The text document's URI.
+    DocumentUri uri;
+
+    /// The text document's language identifier.
+    string_ref languageId;
+
+    /// The version number of this document (it will strictly increase after each
+    int version = 0;
+
+    /// The content of the opened text document.
+    string_ref text;
+};
+
+enum class TraceLevel
+{
+    Off = 0,
+    Messages = 1,
+    Verbose = 2,
+};
+enum class TextDocumentSyncKind
+{
+    /// Documents should not be synced at all.
+    None = 0,
+
+    /// Documents are synced by always sending the full content of the document.
+    Full = 1,
+
+    /// Documents are synced by sending the full content on open.  After that
+    /// only incremental updates to the document are send.
+    Incremental = 2,
+};
+enum class CompletionItemKind
+{
+    Missing = 0,
+    Text = 1,
+    Method = 2,
+    Function = 3,
+    Constructor = 4,
+    Field = 5,
+    Variable = 6,
+    Class = 7,
+    Interface = 8,
+    Module = 9,
+    Property = 10,
+    Unit = 11,
+    Value = 12,
+    Enum = 13,
+    Keyword = 14,
+    Snippet = 15,
+    Color = 16,
+    File = 17,
+    Reference = 18,
+    Folder = 19,
+    EnumMember = 20,
+    Constant = 21,
+    Struct = 22,
+    Event = 23,
+    Operator = 24,
+    TypeParameter = 25,
+};
+enum class SymbolKind
+{
+    File = 1,
+    Module = 2,
+    Namespace = 3,
+    Package = 4,
+    Class = 5,
+    Method = 6,
+    Property = 7,
+    Field = 8,
+    Constructor = 9,
+    Enum = 10,
+    Interface = 11,
+    Function = 12,
+    Variable = 13,
+    Constant = 14,
+    String = 15,
+    Number = 16,
+    Boolean = 17,
+    Array = 18,
+    Object = 19,
+    Key = 20,
+    Null = 21,
+    EnumMember = 22,
+    Struct = 23,
+    Event = 24,
+    Operator = 25,
+    TypeParameter = 26
+};
+enum class OffsetEncoding
+{
+    // Any string is legal on the wire. Unrecognized encodings parse as this.
+    UnsupportedEncoding,
+    // Length counts code units of UTF-16 encoded text. (Standard LSP behavior).
+    UTF16,
+    // Length counts bytes of UTF-8 encoded text. (Clangd extension).
+    UTF8,
+    // Length counts codepoints in unicode text. (Clangd extension).
+    UTF32,
+};
+enum class MarkupKind
+{
+    PlainText,
+    Markdown,
+};
+enum class ResourceOperationKind
+{
+    Create,
+    Rename,
+    Delete
+};
+enum class FailureHandlingKind
+{
+    Abort,
+    Transactional,
+    Undo,
+    TextOnlyTransactional
+};
+
+struct ClientCapabilities
+{
+    /// The supported set of SymbolKinds for workspace/symbol.
+    /// workspace.symbol.symbolKind.valueSet
+    std::vector<SymbolKind> WorkspaceSymbolKinds;
+    /// Whether the client accepts diagnostics with codeActions attached inline.
+    /// textDocument.publishDiagnostics.codeActionsInline.
+    bool DiagnosticFixes = true;
+
+    /// Whether the client accepts diagnostics with related locations.
+    /// textDocument.publishDiagnostics.relatedInformation.
+    bool DiagnosticRelatedInformation = true;
+
+    /// Whether the client accepts diagnostics with category attached to it
+    /// using the "category" extension.
+    /// textDocument.publishDiagnostics.categorySupport
+    bool DiagnosticCategory = true;
+
+    /// Client supports snippets as insert text.
+    /// textDocument.completion.completionItem.snippetSupport
+    bool CompletionSnippets = true;
+
+    bool CompletionDeprecated = true;
+
+    /// Client supports completions with additionalTextEdit near the cursor.
+    /// This is a clangd extension. (LSP says this is for unrelated text only).
+    /// textDocument.completion.editsNearCursor
+    bool CompletionFixes = true;
+
+    /// Client supports hierarchical document symbols.
+    bool HierarchicalDocumentSymbol = true;
+
+    /// Client supports processing label offsets instead of a simple label string.
+    bool OffsetsInSignatureHelp = true;
+
+    /// The supported set of CompletionItemKinds for textDocument/completion.
+    /// textDocument.completion.completionItemKind.valueSet
+    std::vector<CompletionItemKind> CompletionItemKinds;
+
+    /// Client supports CodeAction return value for textDocument/codeAction.
+    /// textDocument.codeAction.codeActionLiteralSupport.
+    bool CodeActionStructure = true;
+    /// Supported encodings for LSP character offsets. (clangd extension).
+    std::vector<OffsetEncoding> offsetEncoding = {OffsetEncoding::UTF8};
+    /// The content format that should be used for Hover requests.
+    std::vector<MarkupKind> HoverContentFormat = {MarkupKind::PlainText};
+
+    bool ApplyEdit = false;
+    bool DocumentChanges = false;
+    /// The client follows workspace/didChangeWatchedFiles registrations.
+    /// workspace.didChangeWatchedFiles.dynamicRegistration
+    bool DidChangeWatchedFiles = false;
+    ClientCapabilities()
+    {
+        for (int i = 1; i <= 26; ++i)
+        {
+            WorkspaceSymbolKinds.push_back((SymbolKind)i);
+        }
+        for (int i = 0; i <= 25; ++i)
+        {
+            CompletionItemKinds.push_back((CompletionItemKind)i);
+        }
+    }
+};
+
+struct ClangdCompileCommand
+{
+    TextType workingDirectory;
+    std::vector<TextType> compilationCommand;
+};
+
+struct ConfigurationSettings
+{
+    // Changes to the in-memory compilation database.
+    // The key of the map is a file name.
+    std::map<std::string, ClangdCompileCommand> compilationDatabaseChanges;
+};
+
+struct InitializationOptions
+{
+    // What we can change throught the didChangeConfiguration request, we can
+    // also set through the initialize request (initializationOptions field).
+    ConfigurationSettings configSettings;
+
+    option<TextType> compilationDatabasePath;
+    // Additional flags to be included in the "fallback command" used when
+    // the compilation database doesn't describe an opened file.
+    // The command used will be approximately `clang $FILE $fallbackFlags`.
+    std::vector<TextType> fallbackFlags;
+
+    /// Clients supports show file status for textDocument/clangd.fileStatus.
+    bool clangdFileStatus = false;
+};
+
+struct InitializeParams
+{
+    unsigned processId = 0;
+    ClientCapabilities capabilities;
+    option<DocumentUri> rootUri;
+    option<TextType> rootPath;
+    InitializationOptions initializationOptions;
+};
+
+enum class MessageType
+{
+    /// An error message.
+    Error = 1,
+    /// A warning message.
+    Warning = 2,
+    /// An information message.
+    Info = 3,
+    /// A log message.
+    Log = 4,
+};
+struct ShowMessageParams
+{
+    /// The message type.
+    MessageType type = MessageType::Info;
+    /// The actual message.
+    std::string message;
+};
+
+struct Registration
+{
+    /**
+     * The id used to register the request. The id can be used to deregister
+     * the request again.
+     */
+    TextType id;
+    /**
+     * The method / capability to register for.
+     */
+    TextType method;
+};
+
+struct RegistrationParams
+{
+    std::vector<Registration> registrations;
+};
+
+struct UnregistrationParams
+{
+    std::vector<Registration> unregisterations;
+};
+
+struct DidOpenTextDocumentParams
+{
+    /// The document that was opened.
+    TextDocumentItem textDocument;
+};
+
+struct DidCloseTextDocumentParams
+{
+    /// The document that was closed.
+    TextDocumentIdentifier textDocument;
+};
+
+struct TextDocumentContentChangeEvent
+{
+    /// The range of the document that changed.
+    option<Range> range;
+
+    /// The length of the range that got replaced.
+    option<int> rangeLength;
+    /// The new text of the range/document.
+    std::string text;
+};
+
+struct DidChangeTextDocumentParams
+{
+    /// The document that did change. The version number points
+    /// to the version after all provided content changes have
+    /// been applied.
+    VersionedTextDocumentIdentifier textDocument;
+
+    /// The actual content changes.
+    std::vector<TextDocumentContentChangeEvent> contentChanges;
+
+    /// Forces diagnostics to be generated, or to not be generated, for this
+    /// version of the file. If not set, diagnostics are eventually consistent:
+    /// either they will be provided for this version or some subsequent one.
+    /// This is a clangd extension.
+    option<bool> wantDiagnostics;
+};
+
+enum class FileChangeType
+{
+    /// The file got created.
+    Created = 1,
+    /// The file got changed.
+    Changed = 2,
+    /// The file got deleted.
+    Deleted = 3
+};
+struct FileEvent
+{
+    /// The file's URI.
+    URIForFile uri;
+    /// The change type.
+    FileChangeType type = FileChangeType::Created;
+};
+
+struct DidChangeWatchedFilesParams
+{
+    /// The actual file events.
+    std::vector<FileEvent> changes;
+};
+
+enum class WatchKind
+{
+    Create = 1,
+    Change = 2,
+    Delete = 4
+};
+struct FileSystemWatcher
+{
+    /// The glob pattern to watch, relative to baseUri if that is set.
+    std::string globPattern;
+    /// Base of a RelativePattern, empty for plain glob patterns.
+    std::string baseUri;
+    /// Bitmask of WatchKind, defaults to all kinds.
+    int kind = 7;
+};
+
+struct DidChangeWatchedFilesRegistrationOptions
+{
+    std::vector<FileSystemWatcher> watchers;
+};
+
+struct DidChangeConfigurationParams
+{
+    ConfigurationSettings settings;
+};
+
+struct DocumentRangeFormattingParams
+{
+    /// The document to format.
+    TextDocumentIdentifier textDocument;
+
+    /// The range to format
+    Range range;
+};
+
+struct DocumentOnTypeFormattingParams
+{
+    /// The document to format.
+    TextDocumentIdentifier textDocument;
+
+    /// The position at which this request was sent.
+    Position position;
+
+    /// The character that has been typed.
+    TextType ch;
+};
+
+struct FoldingRangeParams
+{
+    /// The document to format.
+    TextDocumentIdentifier textDocument;
+};
+
+enum class FoldingRangeKind
+{
+    Comment,
+    Imports,
+    Region,
+};
+
+struct FoldingRange
+{
+    /**
+     * The zero-based line number from where the folded range starts.
+     */
+    int startLine;
+    /**
+     * The zero-based character offset from where the folded range starts.
+     * If not defined, defaults to the length of the start line.
+     */
+    int startCharacter;
+    /**
+     * The zero-based line number where the folded range ends.
+     */
+    int endLine;
+    /**
+     * The zero-based character offset before the folded range ends.
+     * If not defined, defaults to the length of the end line.
+     */
+    int endCharacter;
+
+    FoldingRangeKind kind;
+};
+
+struct SelectionRangeParams
+{
+    /// The document to format.
+    TextDocumentIdentifier textDocument;
+    std::vector<Position> positions;
+};
+
+struct SelectionRange
+{
+    Range range;
+    std::unique_ptr<SelectionRange> parent;
+};
+
+struct DocumentFormattingParams
+{
+    /// The document to format.
+    TextDocumentIdentifier textDocument;
+};
+
+struct DocumentSymbolParams
+{
+    // The text document to find symbols in.
+    TextDocumentIdentifier textDocument;
+};
+
+struct DiagnosticRelatedInformation
+{
+    /// The location of this related diagnostic information.
+    Location location;
+    /// The message of this related diagnostic information.
+    std::string message;
+};
+struct CodeAction;
+
+struct Diagnostic
+{
+    /// The range at which the message applies.
+    Range range;
+
+    /// The diagnostic's severity. Can be omitted. If omitted it is up to the
+    /// client to interpret diagnostics as error, warning, info or hint.
+    int severity = 0;
+
+    /// The diagnostic's code. Can be omitted.
+    std::string code;
+
+    /// A human-readable string describing the source of this
+    /// diagnostic, e.g. 'typescript' or 'super lint'.
+    std::string source;
+
+    /// The diagnostic's message.
+    std::string message;
+
+    /// An array of related diagnostic information, e.g. when symbol-names within
+    /// a scope collide all definitions can be marked via this property.
+    option<std::vector<DiagnosticRelatedInformation>> relatedInformation;
+
+    /// The diagnostic's category. Can be omitted.
+    /// An LSP extension that's used to send the name of the category over to the
+    /// client. The category typically describes the compilation stage during
+    /// which the issue was produced, e.g. "Semantic Issue" or "Parse Issue".
+    option<std::string> category;
+
+    /// Clangd extension: code actions related to this diagnostic.
+    /// Only with capability textDocument.publishDiagnostics.codeActionsInline.
+    /// (These actions can also be obtained using textDocument/codeAction).
+    option<std::vector<CodeAction>> codeActions;
+};
+
+struct PublishDiagnosticsParams
+{
+    /**
+     * The URI for which diagnostic information is reported.
+     */
+    std::string uri;
+    /**
+     * An array of diagnostic information items.
+     */
+    std::vector<Diagnostic> diagnostics;
+};
+
+struct DocumentDiagnosticParams
+{
+    TextDocumentIdentifier textDocument;
+    /// The identifier of the server's diagnosticProvider, if it has one.
+    option<std::string> identifier;
+    /// The resultId of the last report for this document.
+    option<std::string> previousResultId;
+};
+
+struct PreviousResultId
+{
+    std::string uri;
+    /// The resultId of the last report for uri.
+    std::string value;
+};
+
+struct WorkspaceDiagnosticParams
+{
+    option<std::string> identifier;
+    /// Documents with a report already, so the server can answer them "unchanged".
+    std::vector<PreviousResultId> previousResultIds;
+};
+
+struct CodeActionContext
+{
+    /// An array of diagnostics.
+    std::vector<Diagnostic> diagnostics;
+};
+
+struct CodeActionParams
+{
+    /// The document in which the command was invoked.
+    TextDocumentIdentifier textDocument;
+
+    /// The range for which the command was invoked.
+    Range range;
+
+    /// Context carrying additional information.
+    CodeActionContext context;
+};
+
+struct WorkspaceEdit
+{
+    /// Holds changes to existing resources.
+    option<std::map<std::string, std::vector<TextEdit>>> changes;
+
+    /// Note: "documentChanges" is not currently used because currently there is
+    /// no support for versioned edits.
+};
+
+struct TweakArgs
+{
+    /// A file provided by the client on a textDocument/codeAction request.
+    std::string file;
+    /// A selection provided by the client on a textDocument/codeAction request.
+    Range selection;
+    /// ID of the tweak that should be executed. Corresponds to Tweak::id().
+    std::string tweakID;
+};
+
+struct ExecuteCommandParams
+{
+    std::string command;
+    // Arguments
+    option<WorkspaceEdit> workspaceEdit;
+    option<TweakArgs> tweakArgs;
+};
+
+struct LspCommand : public ExecuteCommandParams
+{
+    std::string title;
+};
+
+struct CodeAction
+{
+    /// A short, human-readable, title for this code action.
+    std::string title;
+
+    /// The kind of the code action.
+    /// Used to filter code actions.
+    option<std::string> kind;
+    /// The diagnostics that this code action resolves.
+    option<std::vector<Diagnostic>> diagnostics;
+
+    /// The workspace edit this code action performs.
+    option<WorkspaceEdit> edit;
+
+    /// A command this code action executes. If a code action provides an edit
+    /// and a command, first the edit is executed and then the command.
+    option<LspCommand> command;
+};
+
+struct SymbolInformation
+{
+    /// The name of this symbol.
+    std::string name;
+    /// The kind of this symbol.
+    SymbolKind kind = SymbolKind::Class;
+    /// The location of this symbol.
+    Location location;
+    /// The name of the symbol containing this symbol.
+    std::string containerName;
+};
+
+struct SymbolDetails
+{
+    TextType name;
+    TextType containerName;
+    /// Unified Symbol Resolution identifier
+    /// This is an opaque string uniquely identifying a symbol.
+    /// Unlike SymbolID, it is variable-length and somewhat human-readable.
+    /// It is a common representation across several clang tools.
+    /// (See USRGeneration.h)
+    TextType USR;
+    option<TextType> ID;
+};
+
+struct WorkspaceSymbolParams
+{
+    /// A non-empty query string
+    TextType query;
+};
+
+struct ApplyWorkspaceEditParams
+{
+    WorkspaceEdit edit;
+};
+
+struct TextDocumentPositionParams
+{
+    /// The text document.
+    TextDocumentIdentifier textDocument;
+
+    /// The position inside the text document.
+    Position position;
+};
+
+enum class CompletionTriggerKind
+{
+    /// Completion was triggered by typing an identifier (24x7 code
+    /// complete), manual invocation (e.g Ctrl+Space) or via API.
+    Invoked = 1,
+    /// Completion was triggered by a trigger character specified by
+    /// the `triggerCharacters` properties of the `CompletionRegistrationOptions`.
+    TriggerCharacter = 2,
+    /// Completion was re-triggered as the current completion list is incomplete.
+    TriggerTriggerForIncompleteCompletions = 3
+};
+struct CompletionContext
+{
+    /// How the completion was triggered.
+    CompletionTriggerKind triggerKind = CompletionTriggerKind::Invoked;
+    /// The trigger character (a single character) that has trigger code complete.
+    /// Is undefined if `triggerKind !== CompletionTriggerKind.TriggerCharacter`
+    option<TextType> triggerCharacter;
+};
+
+struct CompletionParams : TextDocumentPositionParams
+{
+    option<CompletionContext> context;
+};
+
+struct MarkupContent
+{
+    MarkupKind kind = MarkupKind::PlainText;
+    std::string value;
+};
+
+struct Hover
+{
+    /// The hover's content
+    MarkupContent contents;
+
+    /// An optional range is a range inside a text document
+    /// that is used to visualize a hover, e.g. by changing the background color.
+    option<Range> range;
+};
+
+enum class InsertTextFormat
+{
+    Missing = 0,
+    /// The primary text to be inserted is treated as a plain string.
+    PlainText = 1,
+    /// The primary text to be inserted is treated as a snippet.
+    ///
+    /// A snippet can define tab stops and placeholders with `$1`, `$2`
+    /// and `${3:foo}`. `$0` defines the final tab stop, it defaults to the end
+    /// of the snippet. Placeholders with equal identifiers are linked, that is
+    /// typing in one will update others too.
+    ///
+    /// See also:
+    /// https//github.com/Microsoft/vscode/blob/master/src/vs/editor/contrib/snippet/common/snippet.md
+    Snippet = 2,
+};
+struct CompletionItem
+{
+    /// The label of this completion item. By default also the text that is
+    /// inserted when selecting this completion.
+    std::string label;
+
+    /// The kind of this completion item. Based of the kind an icon is chosen by
+    /// the editor.
+    CompletionItemKind kind = CompletionItemKind::Missing;
+
+    /// A human-readable string with additional information about this item, like
+    /// type or symbol information.
+    std::string detail;
+
+    /// A human-readable string that represents a doc-comment.
+    std::string documentation;
+
+    /// A string that should be used when comparing this item with other items.
+    /// When `falsy` the label is used.
+    std::string sortText;
+
+    /// A string that should be used when filtering a set of completion items.
+    /// When `falsy` the label is used.
+    std::string filterText;
+
+    /// A string that should be inserted to a document when selecting this
+    /// completion. When `falsy` the label is used.
+    std::string insertText;
+
+    /// The format of the insert text. The format applies to both the `insertText`
+    /// property and the `newText` property of a provided `textEdit`.
+    InsertTextFormat insertTextFormat = InsertTextFormat::Missing;
+
+    /// An edit which is applied to a document when selecting this completion.
+    /// When an edit is provided `insertText` is ignored.
+    ///
+    /// Note: The range of the edit must be a single line range and it must
+    /// contain the position at which completion has been requested.
+    TextEdit textEdit;
+
+    /// An optional array of additional text edits that are applied when selecting
+    /// this completion. Edits must not overlap with the main edit nor with
+    /// themselves.
+    std::vector<TextEdit> additionalTextEdits;
+
+    /// Indicates if this item is deprecated.
+    bool deprecated = false;
+
+    // TODO(krasimir): The following optional fields defined by the language
+    // server protocol are unsupported:
+    //
+    // data?: any - A data entry field that is preserved on a completion item
+    //              between a completion and a completion resolve request.
+};
+
+struct CompletionList
+{
+    /// The list is not complete. Further typing should result in recomputing the
+    /// list.
+    bool isIncomplete = false;
+
+    /// The completion items.
+    std::vector<CompletionItem> items;
+};
+
+struct ParameterInformation
+{
+
+    /// The label of this parameter. Ignored when labelOffsets is set.
+    std::string labelString;
+
+    /// Inclusive start and exclusive end offsets withing the containing signature
+    /// label.
+    /// Offsets are computed by lspLength(), which counts UTF-16 code units by
+    /// default but that can be overriden, see its documentation for details.
+    option<std::pair<unsigned, unsigned>> labelOffsets;
+
+    /// The documentation of this parameter. Optional.
+    std::string documentation;
+};
+struct SignatureInformation
+{
+
+    /// The label of this signature. Mandatory.
+    std::string label;
+
+    /// The documentation of this signature. Optional.
+    std::string documentation;
+
+    /// The parameters of this signature.
+    std::vector<ParameterInformation> parameters;
+};
+struct SignatureHelp
+{
+    /// The resulting signatures.
+    std::vector<SignatureInformation> signatures;
+    /// The active signature.
+    int activeSignature = 0;
+    /// The active parameter of the active signature.
+    int activeParameter = 0;
+    /// Position of the start of the argument list, including opening paren. e.g.
+    /// foo("first arg",   "second arg",
+    ///    ^-argListStart   ^-cursor
+    /// This is a clangd-specific extension, it is only available via C++ API and
+    /// not currently serialized for the LSP.
+    Position argListStart;
+};
+
+struct RenameParams
+{
+    /// The document that was opened.
+    TextDocumentIdentifier textDocument;
+
+    /// The position at which this request was sent.
+    Position position;
+
+    /// The new name of the symbol.
+    std::string newName;
+};
+
+enum class DocumentHighlightKind
+{
+    Text = 1,
+    Read = 2,
+    Write = 3
+};
+
+struct DocumentHighlight
+{
+    /// The range this highlight applies to.
+    Range range;
+    /// The highlight kind, default is DocumentHighlightKind.Text.
+    DocumentHighlightKind kind = DocumentHighlightKind::Text;
+    friend bool operator<(const DocumentHighlight &LHS, const DocumentHighlight &RHS)
+    {
+        int LHSKind = static_cast<int>(LHS.kind);
+        int RHSKind = static_cast<int>(RHS.kind);
+        return std::tie(LHS.range, LHSKind) < std::tie(RHS.range, RHSKind);
+    }
+    friend bool operator==(const DocumentHighlight &LHS, const DocumentHighlight &RHS)
+    {
+        return LHS.kind == RHS.kind && LHS.range == RHS.range;
+    }
+};
+enum class TypeHierarchyDirection
+{
+    Children = 0,
+    Parents = 1,
+    Both = 2
+};
+
+struct TypeHierarchyParams : public TextDocumentPositionParams
+{
+    /// The hierarchy levels to resolve. `0` indicates no level.
+    int resolve = 0;
+
+    /// The direction of the hierarchy levels to resolve.
+    TypeHierarchyDirection direction = TypeHierarchyDirection::Parents;
+};
+
+struct TypeHierarchyItem
+{
+    /// The human readable name of the hierarchy item.
+    std::string name;
+
+    /// Optional detail for the hierarchy item. It can be, for instance, the
+    /// signature of a function or method.
+    option<std::string> detail;
+
+    /// The kind of the hierarchy item. For instance, class or interface.
+    SymbolKind kind;
+
+    /// `true` if the hierarchy item is deprecated. Otherwise, `false`.
+    bool deprecated;
+
+    /// The URI of the text document where this type hierarchy item belongs to.
+    DocumentUri uri;
+
+    /// The range enclosing this type hierarchy item not including
+    /// leading/trailing whitespace but everything else like comments. This
+    /// information is typically used to determine if the client's cursor is
+    /// inside the type hierarch item to reveal in the symbol in the UI.
+    Range range;
+
+    /// The range that should be selected and revealed when this type hierarchy
+    /// item is being picked, e.g. the name of a function. Must be contained by
+    /// the `range`.
+    Range selectionRange;
+
+    /// If this type hierarchy item is resolved, it contains the direct parents.
+    /// Could be empty if the item does not have direct parents. If not defined,
+    /// the parents have not been resolved yet.
+    option<std::vector<TypeHierarchyItem>> parents;
+
+    /// If this type hierarchy item is resolved, it contains the direct children
+    /// of the current item. Could be empty if the item does not have any
+    /// descendants. If not defined, the children have not been resolved.
+    option<std::vector<TypeHierarchyItem>> children;
+
+    /// The protocol has a slot here for an optional 'data' filed, which can
+    /// be used to identify a type hierarchy item in a resolve request. We don't
+    /// need this (the item itself is sufficient to identify what to resolve)
+    /// so don't declare it.
+};
+
+struct ReferenceParams : public TextDocumentPositionParams
+{
+    // For now, no options like context.includeDeclaration are supported.
+};
+struct FileStatus
+{
+    /// The text document's URI.
+    DocumentUri uri;
+    /// The human-readable string presents the current state of the file, can be
+    /// shown in the UI (e.g. status bar).
+    TextType state;
+    // FIXME: add detail messages.
+};
+
+#endif // LSPTYPES_HPP
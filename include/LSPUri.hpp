@@ -5,10 +5,12 @@
 #ifndef LSP_URI_H
 #define LSP_URI_H
 
+#include <cctype>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <string>
-#include "nlohmann/json.hpp"
+#include "nlohmann/json_fwd.hpp"
 
 using json = nlohmann::json;
 class string_ref {
@@ -76,28 +78,8 @@ public:
     T &operator*() { return value(); }
     explicit operator bool() const { return fHas; }
 };
-namespace nlohmann {
-    template <typename T>
-    struct adl_serializer<option<T>> {
-        static void to_json(json& j, const option<T>& opt) {
-            if (opt.has()) {
-                j = opt.value();
-            } else {
-                j = nullptr;
-            }
-        }
-        static void from_json(const json& j, option<T>& opt) {
-            if (j.is_null()) {
-                opt = option<T>();
-            } else {
-                opt = option<T>(j.get<T>());
-            }
-        }
-    };
-}
-
 inline uint8_t ToHex(uint8_t ch) {
-    return  ch > 9 ? ch + 'A' : ch + '0';
+    return  ch > 9 ? ch - 10 + 'A' : ch + '0';
 }
 
 struct URIForFile {
@@ -110,12 +92,10 @@ struct URIForFile {
                 ch = '/';
             }
             if (std::isalnum(ch) || strchr(symbol, ch)) {
-                if (ch == '/' && result.back() == '/') {
+                if (ch == '/' && !result.empty() && result.back() == '/') {
                     continue;
                 }
                 result += ch;
-            } else if (ch == ' ') {
-                result += '+';
             } else {
                 result += '%';
                 result += ToHex((uint8_t) ch >> 4);
@@ -124,6 +104,43 @@ struct URIForFile {
         }
         return result;
     }
+    static std::string UriDecode(string_ref ref) {
+        auto fromHex = [](char ch) -> int {
+            if (ch >= '0' && ch <= '9') return ch - '0';
+            if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+            if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+            return -1;
+        };
+        std::string result;
+        result.reserve(ref.size());
+        for (size_t i = 0; i < ref.size(); ++i) {
+            char ch = ref[i];
+            if (ch == '%' && i + 2 < ref.size() && fromHex(ref[i + 1]) >= 0 && fromHex(ref[i + 2]) >= 0) {
+                result += (char) (fromHex(ref[i + 1]) * 16 + fromHex(ref[i + 2]));
+                i += 2;
+            } else {
+                result += ch;
+            }
+        }
+        return result;
+    }
+    /// Converts a "file://" uri back to a local path, returns an empty string for other schemes.
+    static std::string UriToPath(string_ref uri) {
+        static const char scheme[] = "file://";
+        if (uri.size() < sizeof(scheme) - 1 || strncmp(uri.data(), scheme, sizeof(scheme) - 1) != 0) {
+            return std::string();
+        }
+        std::string path = UriDecode(string_ref(uri.data() + sizeof(scheme) - 1, uri.size() - sizeof(scheme) + 1));
+        size_t slashes = 0;
+        while (slashes < path.size() && path[slashes] == '/') {
+            ++slashes;
+        }
+        if (path.size() > slashes + 1 && path[slashes + 1] == ':') {
+            // file:///C:/foo -> C:/foo
+            return path.substr(slashes);
+        }
+        return slashes > 1 ? path.substr(slashes - 1) : path;
+    }
     explicit operator bool() const { return !file.empty(); }
     friend bool operator==(const URIForFile &LHS, const URIForFile &RHS) {
         return LHS.file == RHS.file;
@@ -135,7 +152,8 @@ struct URIForFile {
         return LHS.file < RHS.file;
     }
     void from(string_ref path) {
-        file = "file:///" + UriEncode(path);
+        std::string encoded = UriEncode(path);
+        file = (!encoded.empty() && encoded.front() == '/' ? "file://" : "file:///") + encoded;
     }
     explicit URIForFile(const char *str) : file(str) {}
     URIForFile() = default;
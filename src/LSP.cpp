@@ -0,0 +1,335 @@
+#include <LSP.hpp>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+
+// FNV-1a, usable in case labels
+constexpr uint32_t keyHash(const char *key, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ static_cast<unsigned char>(key[i])) * 16777619u;
+    return hash;
+}
+
+uint32_t keyHash(const std::string &key)
+{
+    return keyHash(key.data(), key.size());
+}
+
+template <size_t N> bool isKey(const std::string &key, const char (&name)[N])
+{
+    return key.size() == N - 1 && memcmp(key.data(), name, N - 1) == 0;
+}
+
+} // namespace
+
+// Out of line members of the specializations declared by JSON_DECLARE
+#define JSON_DEFINE(Type, TO, FROM)                                                                                    \
+    void nlohmann::adl_serializer<Type>::to_json(json &j, const Type &value) TO                                        \
+    void nlohmann::adl_serializer<Type>::from_json(const json &j, Type &value) FROM
+
+// Decodes an object in one pass over the keys it has, instead of looking up
+// every known key twice like FROM_KEY. Each key is switched on by its hash;
+// two fields of a type hashing alike would be duplicate case labels, so the
+// hash is collision free for the keys listed, and one compare rules out
+// unknown keys. Other keys are ignored, and so is a value that isn't an object.
+#define FROM_FIELDS(...)                                                                                               \
+    {                                                                                                                  \
+        if (!j.is_object())                                                                                            \
+            return;                                                                                                    \
+        for (auto field = j.begin(); field != j.end(); ++field)                                                        \
+        {                                                                                                              \
+            const std::string &key = field.key();                                                                      \
+            switch (keyHash(key))                                                                                      \
+            {                                                                                                          \
+                __VA_ARGS__                                                                                            \
+            }                                                                                                          \
+        }                                                                                                              \
+    }
+#define FIELD(KEY) FIELD_WITH(KEY, field->get_to(value.KEY))
+// A field that needs more than get_to, STATEMENT sees the value as *field
+#define FIELD_WITH(KEY, STATEMENT)                                                                                     \
+    case keyHash(#KEY, sizeof(#KEY) - 1):                                                                              \
+        if (isKey(key, #KEY))                                                                                          \
+            STATEMENT;                                                                                                 \
+        break;
+
+// Enums map to strings like NLOHMANN_JSON_SERIALIZE_ENUM: a value missing from
+// VALUES maps to its first entry. VALUES(X) expands X(enumerator, "string")
+// for each entry, so both directions are a switch.
+#define JSON_DEFINE_ENUM(Type, VALUES)                                                                                 \
+    void to_json(json &j, const Type &value)                                                                           \
+    {                                                                                                                  \
+        static const std::pair<Type, const char *> first[] = {VALUES(ENUM_PAIR)};                                      \
+        switch (value)                                                                                                 \
+        {                                                                                                              \
+            VALUES(ENUM_TO_CASE)                                                                                       \
+        }                                                                                                              \
+        j = first[0].second;                                                                                           \
+    }                                                                                                                  \
+    void from_json(const json &j, Type &value)                                                                         \
+    {                                                                                                                  \
+        static const std::pair<Type, const char *> first[] = {VALUES(ENUM_PAIR)};                                      \
+        if (j.is_string())                                                                                             \
+        {                                                                                                              \
+            auto &key = j.get_ref<const std::string &>();                                                              \
+            switch (keyHash(key))                                                                                      \
+            {                                                                                                          \
+                VALUES(ENUM_FROM_CASE)                                                                                 \
+            }                                                                                                          \
+        }                                                                                                              \
+        value = first[0].first;                                                                                        \
+    }
+#define ENUM_PAIR(VALUE, NAME) {VALUE, NAME},
+#define ENUM_TO_CASE(VALUE, NAME)                                                                                      \
+    case VALUE:                                                                                                        \
+        j = NAME;                                                                                                      \
+        return;
+#define ENUM_FROM_CASE(VALUE, NAME)                                                                                    \
+    case keyHash(NAME, sizeof(NAME) - 1):                                                                              \
+        if (isKey(key, NAME))                                                                                          \
+        {                                                                                                              \
+            value = VALUE;                                                                                             \
+            return;                                                                                                    \
+        }                                                                                                              \
+        break;
+
+JSON_DEFINE(
+    URIForFile, { j = value.file; }, { value.file = j.get<std::string>(); })
+
+JSON_DEFINE(TextDocumentIdentifier, MAP_JSON(MAP_KEY(uri)), {})
+
+JSON_DEFINE(VersionedTextDocumentIdentifier, MAP_JSON(MAP_KEY(uri), MAP_KEY(version)), {})
+
+JSON_DEFINE(Position, MAP_JSON(MAP_KEY(line), MAP_KEY(character)), FROM_FIELDS(FIELD(line) FIELD(character)))
+
+JSON_DEFINE(Range, MAP_JSON(MAP_KEY(start), MAP_KEY(end)), FROM_FIELDS(FIELD(start) FIELD(end)))
+
+JSON_DEFINE(Location, MAP_JSON(MAP_KEY(uri), MAP_KEY(range)), FROM_FIELDS(FIELD(uri) FIELD(range)))
+
+JSON_DEFINE(TextEdit, MAP_JSON(MAP_KEY(range), MAP_KEY(newText)), FROM_FIELDS(FIELD(range) FIELD(newText)))
+
+JSON_DEFINE(TextDocumentItem, MAP_JSON(MAP_KEY(uri), MAP_KEY(languageId), MAP_KEY(version), MAP_KEY(text)), {})
+
+#define OFFSET_ENCODING_VALUES(X)                                                                                      \
+    X(OffsetEncoding::UnsupportedEncoding, "unspported")                                                               \
+    X(OffsetEncoding::UTF8, "utf-8")                                                                                   \
+    X(OffsetEncoding::UTF16, "utf-16")                                                                                 \
+    X(OffsetEncoding::UTF32, "utf-32")
+JSON_DEFINE_ENUM(OffsetEncoding, OFFSET_ENCODING_VALUES)
+
+#define MARKUP_KIND_VALUES(X)                                                                                          \
+    X(MarkupKind::PlainText, "plaintext")                                                                              \
+    X(MarkupKind::Markdown, "markdown")
+JSON_DEFINE_ENUM(MarkupKind, MARKUP_KIND_VALUES)
+
+#define RESOURCE_OPERATION_KIND_VALUES(X)                                                                              \
+    X(ResourceOperationKind::Create, "create")                                                                         \
+    X(ResourceOperationKind::Rename, "rename")                                                                         \
+    X(ResourceOperationKind::Delete, "dename")
+JSON_DEFINE_ENUM(ResourceOperationKind, RESOURCE_OPERATION_KIND_VALUES)
+
+#define FAILURE_HANDLING_KIND_VALUES(X)                                                                                \
+    X(FailureHandlingKind::Abort, "abort")                                                                             \
+    X(FailureHandlingKind::Transactional, "transactional")                                                             \
+    X(FailureHandlingKind::Undo, "undo")                                                                               \
+    X(FailureHandlingKind::TextOnlyTransactional, "textOnlyTransactional")
+JSON_DEFINE_ENUM(FailureHandlingKind, FAILURE_HANDLING_KIND_VALUES)
+
+JSON_DEFINE(
+    ClientCapabilities,
+    MAP_JSON(MAP_KV("textDocument",
+                 MAP_KV("publishDiagnostics", // PublishDiagnosticsClientCapabilities
+                        MAP_TO("categorySupport", DiagnosticCategory), MAP_TO("codeActionsInline", DiagnosticFixes),
+                        MAP_TO("relatedInformation", DiagnosticRelatedInformation), ),
+                 MAP_KV("completion", // CompletionClientCapabilities
+                        MAP_KV("completionItem", MAP_TO("snippetSupport", CompletionSnippets),
+                               MAP_TO("deprecatedSupport", CompletionDeprecated)),
+                        MAP_KV("completionItemKind", MAP_TO("valueSet", CompletionItemKinds)),
+                        MAP_TO("editsNearCursor", CompletionFixes)),
+                 MAP_KV("codeAction", MAP_TO("codeActionLiteralSupport", CodeActionStructure)),
+                 MAP_KV("documentSymbol", MAP_TO("hierarchicalDocumentSymbolSupport", HierarchicalDocumentSymbol)),
+                 MAP_KV("hover", // HoverClientCapabilities
+                        MAP_TO("contentFormat", HoverContentFormat)),
+                 MAP_KV("signatureHelp", MAP_KV("signatureInformation",
+                                                MAP_KV("parameterInformation",
+                                                       MAP_TO("labelOffsetSupport", OffsetsInSignatureHelp))))),
+             MAP_KV("workspace",     // WorkspaceEditClientCapabilities
+                 MAP_KV("symbol", // WorkspaceSymbolClientCapabilities
+                        MAP_KV("symbolKind", MAP_TO("valueSet", WorkspaceSymbolKinds))),
+                 MAP_TO("applyEdit", ApplyEdit),
+                 MAP_KV("didChangeWatchedFiles", MAP_TO("dynamicRegistration", DidChangeWatchedFiles)),
+                 MAP_KV("workspaceEdit", // WorkspaceEditClientCapabilities
+                        MAP_TO("documentChanges", DocumentChanges))),
+             MAP_TO("offsetEncoding", offsetEncoding)),
+    {})
+
+JSON_DEFINE(ClangdCompileCommand, MAP_JSON(MAP_KEY(workingDirectory), MAP_KEY(compilationCommand)), {})
+
+JSON_DEFINE(ConfigurationSettings, MAP_JSON(MAP_KEY(compilationDatabaseChanges)), {})
+
+JSON_DEFINE(InitializationOptions,
+            MAP_JSON(MAP_KEY(configSettings), MAP_KEY(compilationDatabasePath), MAP_KEY(fallbackFlags),
+                     MAP_KEY(clangdFileStatus)),
+            {})
+
+JSON_DEFINE(InitializeParams,
+            MAP_JSON(MAP_KEY(processId), MAP_KEY(capabilities), MAP_KEY(rootUri), MAP_KEY(initializationOptions),
+                     MAP_KEY(rootPath)),
+            {})
+
+JSON_DEFINE(ShowMessageParams, {}, FROM_FIELDS(FIELD(type) FIELD(message)))
+
+JSON_DEFINE(Registration, MAP_JSON(MAP_KEY(id), MAP_KEY(method)), {})
+
+JSON_DEFINE(RegistrationParams, MAP_JSON(MAP_KEY(registrations)), {})
+
+JSON_DEFINE(UnregistrationParams, MAP_JSON(MAP_KEY(unregisterations)), {})
+
+JSON_DEFINE(DidOpenTextDocumentParams, MAP_JSON(MAP_KEY(textDocument)), {})
+
+JSON_DEFINE(DidCloseTextDocumentParams, MAP_JSON(MAP_KEY(textDocument)), {})
+
+JSON_DEFINE(TextDocumentContentChangeEvent, MAP_JSON(MAP_KEY(range), MAP_KEY(rangeLength), MAP_KEY(text)), {})
+
+JSON_DEFINE(DidChangeTextDocumentParams,
+            MAP_JSON(MAP_KEY(textDocument), MAP_KEY(contentChanges), MAP_KEY(wantDiagnostics)), {})
+
+JSON_DEFINE(FileEvent, MAP_JSON(MAP_KEY(uri), MAP_KEY(type)), {})
+
+JSON_DEFINE(DidChangeWatchedFilesParams, MAP_JSON(MAP_KEY(changes)), {})
+
+namespace
+{
+// A plain pattern, or a RelativePattern {baseUri, pattern} whose baseUri is a URI or a WorkspaceFolder
+void globFromJson(const json &glob, FileSystemWatcher &value)
+{
+    if (glob.is_string())
+    {
+        glob.get_to(value.globPattern);
+        return;
+    }
+    glob.at("pattern").get_to(value.globPattern);
+    auto &base = glob.at("baseUri");
+    value.baseUri = base.is_string() ? base.get<std::string>() : base.at("uri").get<std::string>();
+}
+} // namespace
+
+JSON_DEFINE(FileSystemWatcher, MAP_JSON(MAP_KEY(globPattern), MAP_KEY(kind)),
+            FROM_FIELDS(FIELD_WITH(globPattern, globFromJson(*field, value)) FIELD(kind)))
+
+JSON_DEFINE(DidChangeWatchedFilesRegistrationOptions, MAP_JSON(MAP_KEY(watchers)), FROM_FIELDS(FIELD(watchers)))
+
+JSON_DEFINE(DidChangeConfigurationParams, MAP_JSON(MAP_KEY(settings)), {})
+
+JSON_DEFINE(DocumentRangeFormattingParams, MAP_JSON(MAP_KEY(textDocument), MAP_KEY(range)), {})
+
+JSON_DEFINE(DocumentOnTypeFormattingParams, MAP_JSON(MAP_KEY(textDocument), MAP_KEY(position), MAP_KEY(ch)), {})
+
+JSON_DEFINE(FoldingRangeParams, MAP_JSON(MAP_KEY(textDocument)), {})
+
+#define FOLDING_RANGE_KIND_VALUES(X)                                                                                   \
+    X(FoldingRangeKind::Comment, "comment")                                                                            \
+    X(FoldingRangeKind::Imports, "imports")                                                                            \
+    X(FoldingRangeKind::Region, "region")
+JSON_DEFINE_ENUM(FoldingRangeKind, FOLDING_RANGE_KIND_VALUES)
+
+JSON_DEFINE(FoldingRange, {},
+            FROM_FIELDS(FIELD(startLine) FIELD(startCharacter) FIELD(endLine) FIELD(endCharacter) FIELD(kind)))
+
+JSON_DEFINE(SelectionRangeParams, MAP_JSON(MAP_KEY(textDocument), MAP_KEY(positions)), {})
+
+JSON_DEFINE(SelectionRange, {},
+            FROM_FIELDS(FIELD(range) FIELD_WITH(parent, {
+                value.parent = std::make_unique<SelectionRange>();
+                field->get_to(*value.parent);
+            })))
+
+JSON_DEFINE(DocumentFormattingParams, MAP_JSON(MAP_KEY(textDocument)), {})
+
+JSON_DEFINE(DocumentSymbolParams, MAP_JSON(MAP_KEY(textDocument)), {})
+
+JSON_DEFINE(DiagnosticRelatedInformation, MAP_JSON(MAP_KEY(location), MAP_KEY(message)),
+            FROM_FIELDS(FIELD(location) FIELD(message)))
+
+JSON_DEFINE(Diagnostic,
+            MAP_JSON(MAP_KEY(range), MAP_KEY(code), MAP_KEY(source), MAP_KEY(message), MAP_KEY(relatedInformation),
+                     MAP_KEY(category), MAP_KEY(codeActions)),
+            FROM_FIELDS(FIELD(range) FIELD(code) FIELD(source) FIELD(message) FIELD(relatedInformation)
+                            FIELD(category) FIELD(codeActions)))
+
+JSON_DEFINE(PublishDiagnosticsParams, {}, FROM_FIELDS(FIELD(uri) FIELD(diagnostics)))
+
+// Optional strings are left out, servers don't take null for them
+JSON_DEFINE(DocumentDiagnosticParams, {
+    j["textDocument"] = value.textDocument;
+    if (value.identifier.has())
+        j["identifier"] = value.identifier.value();
+    if (value.previousResultId.has())
+        j["previousResultId"] = value.previousResultId.value();
+}, {})
+
+JSON_DEFINE(PreviousResultId, MAP_JSON(MAP_KEY(uri), MAP_KEY(value)), FROM_FIELDS(FIELD(uri) FIELD(value)))
+
+JSON_DEFINE(WorkspaceDiagnosticParams, {
+    j["previousResultIds"] = value.previousResultIds;
+    if (value.identifier.has())
+        j["identifier"] = value.identifier.value();
+}, {})
+
+JSON_DEFINE(CodeActionContext, MAP_JSON(MAP_KEY(diagnostics)), {})
+
+JSON_DEFINE(CodeActionParams, MAP_JSON(MAP_KEY(textDocument), MAP_KEY(range), MAP_KEY(context)), {})
+
+JSON_DEFINE(WorkspaceEdit, MAP_JSON(MAP_KEY(changes)), FROM_FIELDS(FIELD(changes)))
+
+JSON_DEFINE(TweakArgs, MAP_JSON(MAP_KEY(file), MAP_KEY(selection), MAP_KEY(tweakID)),
+            FROM_FIELDS(FIELD(file) FIELD(selection) FIELD(tweakID)))
+
+JSON_DEFINE(ExecuteCommandParams, MAP_JSON(MAP_KEY(command), MAP_KEY(workspaceEdit), MAP_KEY(tweakArgs)), {})
+
+JSON_DEFINE(LspCommand, MAP_JSON(MAP_KEY(command), MAP_KEY(workspaceEdit), MAP_KEY(tweakArgs), MAP_KEY(title)),
+            FROM_FIELDS(FIELD(command) FIELD(workspaceEdit) FIELD(tweakArgs) FIELD(title)))
+
+JSON_DEFINE(CodeAction,
+            MAP_JSON(MAP_KEY(title), MAP_KEY(kind), MAP_KEY(diagnostics), MAP_KEY(edit), MAP_KEY(command)),
+            FROM_FIELDS(FIELD(title) FIELD(kind) FIELD(diagnostics) FIELD(edit) FIELD(command)))
+
+JSON_DEFINE(SymbolInformation, MAP_JSON(MAP_KEY(name), MAP_KEY(kind), MAP_KEY(location), MAP_KEY(containerName)),
+            FROM_FIELDS(FIELD(name) FIELD(kind) FIELD(location) FIELD(containerName)))
+
+JSON_DEFINE(WorkspaceSymbolParams, MAP_JSON(MAP_KEY(query)), {})
+
+JSON_DEFINE(ApplyWorkspaceEditParams, MAP_JSON(MAP_KEY(edit)), {})
+
+JSON_DEFINE(TextDocumentPositionParams, MAP_JSON(MAP_KEY(textDocument), MAP_KEY(position)), {})
+
+JSON_DEFINE(CompletionContext, MAP_JSON(MAP_KEY(triggerKind), MAP_KEY(triggerCharacter)), {})
+
+JSON_DEFINE(CompletionParams, MAP_JSON(MAP_KEY(context), MAP_KEY(textDocument), MAP_KEY(position)), {})
+
+JSON_DEFINE(MarkupContent, {}, FROM_FIELDS(FIELD(kind) FIELD(value)))
+
+JSON_DEFINE(Hover, {}, FROM_FIELDS(FIELD(contents) FIELD(range)))
+
+JSON_DEFINE(CompletionItem, {},
+            FROM_FIELDS(FIELD(label) FIELD(kind) FIELD(detail) FIELD(documentation) FIELD(sortText) FIELD(filterText)
+                            FIELD(insertText) FIELD(insertTextFormat) FIELD(textEdit) FIELD(additionalTextEdits)))
+
+JSON_DEFINE(CompletionList, {}, FROM_FIELDS(FIELD(isIncomplete) FIELD(items)))
+
+JSON_DEFINE(ParameterInformation, {}, FROM_FIELDS(FIELD(labelString) FIELD(labelOffsets) FIELD(documentation)))
+
+JSON_DEFINE(SignatureInformation, {}, FROM_FIELDS(FIELD(label) FIELD(documentation) FIELD(parameters)))
+
+JSON_DEFINE(SignatureHelp, {}, FROM_FIELDS(FIELD(signatures) FIELD(activeParameter) FIELD(argListStart)))
+
+JSON_DEFINE(RenameParams, MAP_JSON(MAP_KEY(textDocument), MAP_KEY(position), MAP_KEY(newName)), {})
+
+JSON_DEFINE(TypeHierarchyParams,
+            MAP_JSON(MAP_KEY(resolve), MAP_KEY(direction), MAP_KEY(textDocument), MAP_KEY(position)), {})
+
+JSON_DEFINE(ReferenceParams, MAP_JSON(MAP_KEY(textDocument), MAP_KEY(position)), {})
@@ -1,12 +1,35 @@
 #include <LSPClient.hpp>
-#include <QCoreApplication>
 #include <QJsonDocument>
+#include <QJsonArray>
 #include <QJsonObject>
-#include <iostream>
 
 using RequestID = std::string;
 
-LSPClient::LSPClient(QString path, QStringList args)
+namespace
+{
+QJsonObject toQJsonObject(const json &value)
+{
+    // The signals only ever carried objects, anything else arrives as an empty one
+    if (!value.is_object())
+        return QJsonObject();
+    return QJsonDocument::fromJson(QByteArray::fromStdString(value.dump())).object();
+}
+
+// Wrapped in an array, QJsonDocument can't hold a bare value
+QJsonValue toQJsonValue(const json &value)
+{
+    json wrapped = json::array({value});
+    return QJsonDocument::fromJson(QByteArray::fromStdString(wrapped.dump())).array().at(0);
+}
+
+json fromQJsonValue(const QJsonValue &value)
+{
+    QJsonDocument wrapped(QJsonArray{value});
+    return json::parse(wrapped.toJson(QJsonDocument::Compact).toStdString(), nullptr, false).at(0);
+}
+} // namespace
+
+LSPClient::LSPClient(QString path, QStringList args) : clientCore(*this, this)
 {
     clientProcess = new QProcess();
     clientProcess->setProgram(path);
@@ -14,374 +37,563 @@ LSPClient::LSPClient(QString path, QStringList args)
 
     connect(clientProcess, SIGNAL(errorOccurred(QProcess::ProcessError)), this,
             SLOT(onClientError(QProcess::ProcessError)));
+    connect(clientProcess, SIGNAL(started()), this, SLOT(onClientStarted()));
+    connect(clientProcess, SIGNAL(bytesWritten(qint64)), this, SLOT(onClientBytesWritten(qint64)));
     connect(clientProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(onClientReadyReadStdout()));
     connect(clientProcess, SIGNAL(readyReadStandardError()), this, SLOT(onClientReadyReadStderr()));
     connect(clientProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this,
             SLOT(onClientFinished(int, QProcess::ExitStatus)));
 
+    fileEventTimer.setSingleShot(true);
+    connect(&fileEventTimer, SIGNAL(timeout()), this, SLOT(onFileEventTimeout()));
+    stderrTimer.setSingleShot(true);
+    connect(&stderrTimer, SIGNAL(timeout()), this, SLOT(onStderrTimeout()));
+
     clientProcess->start();
 }
 
 // slots
 
-void LSPClient::onClientReadyReadStdout()
+void LSPClient::onClientStarted()
 {
-    // Fixme(coder3101): If all buffer does not comes in one go, then we are in trouble
-    // We can fix it later by specifying that if incomplete buffer recieved in one time
-    // then in the next time. We should append and emit the signal only onces.
+    restarting = false;
+    if (receiver != nullptr)
+        receiver->transportOpened();
+}
 
+void LSPClient::onClientBytesWritten(qint64 bytes)
+{
+    if (receiver != nullptr)
+        receiver->transportDrained();
+}
+
+void LSPClient::onClientReadyReadStdout()
+{
     QByteArray buffer = clientProcess->readAllStandardOutput();
+    if (receiver != nullptr)
+        receiver->transportData(buffer.constData(), static_cast<size_t>(buffer.size()));
+}
 
-    int messageStart = buffer.indexOf("\r\n\r\n") + 4;
-    int lenStart = buffer.indexOf("Content-Length: ") + 16;
-    int lenEnd = buffer.indexOf("\r\n");
-    bool ok = false;
-    int contentLength = buffer.mid(lenStart, lenEnd - lenStart).toInt(&ok);
+void LSPClient::onFileWatcherActivated()
+{
+    clientCore.readFileEvents();
+    scheduleFileEvents();
+}
 
-    if (!ok)
-        return;
+void LSPClient::onFileEventTimeout()
+{
+    clientCore.flushFileEvents();
+    scheduleFileEvents();
+}
 
-    QByteArray payload = buffer.mid(messageStart);
-    if (payload.size() != contentLength)
-    {
-        // Warning: Incomplete message has arrived,
-        // At this point we should keep it in buffer but we are discarding this message;
-        return;
-    }
-    QJsonParseError error{};
+void LSPClient::onStderrTimeout()
+{
+    clientCore.flushStderr();
+    scheduleStderr();
+}
 
-    auto msg = QJsonDocument::fromJson(payload, &error);
+void LSPClient::onClientReadyReadStderr()
+{
+    // The core splits it into lines and calls serverLog() once a batch is due
+    QByteArray buffer = clientProcess->readAllStandardError();
+    if (receiver != nullptr && !buffer.isEmpty())
+        receiver->transportStderr(buffer.constData(), static_cast<size_t>(buffer.size()));
+    scheduleStderr();
+}
 
-    if (error.error != QJsonParseError::NoError || !msg.isObject())
+void LSPClient::onClientError(QProcess::ProcessError error)
+{
+    emit onServerError(error);
+    // A restart that fails to start never gets finished(), report it as another exit
+    if (restarting && error == QProcess::FailedToStart)
     {
-        // Some JSON Parse Error
-        return;
+        restarting = false;
+        if (receiver != nullptr)
+            receiver->transportClosed(-1, false);
     }
-    auto obj = msg.object();
+}
 
-    if (obj.contains("id"))
-    {
-        if (obj.contains("method"))
-        {
-            emit onRequest(obj["method"].toString(), obj["param"].toObject(), obj["id"].toObject());
-        }
-        else if (obj.contains("result"))
-        {
-            emit onResponse(obj["id"].toObject(), obj["result"].toObject());
-        }
-        else if (obj.contains("error"))
-        {
-            emit onError(obj["id"].toObject(), obj["error"].toObject());
-        }
-    }
-    else if (obj.contains("method"))
+void LSPClient::onClientFinished(int exitCode, QProcess::ExitStatus status)
+{
+    lastExitStatus = status;
+    if (receiver != nullptr)
+        receiver->transportClosed(exitCode, status == QProcess::CrashExit);
+}
+
+// LSPTransport
+
+bool LSPClient::isOpen() const
+{
+    return clientProcess != nullptr && clientProcess->state() == QProcess::Running;
+}
+
+void LSPClient::write(const std::string &data)
+{
+    clientProcess->write(data.data(), static_cast<qint64>(data.size()));
+}
+
+int64_t LSPClient::bytesToWrite() const
+{
+    return clientProcess != nullptr ? clientProcess->bytesToWrite() : 0;
+}
+
+bool LSPClient::restart(int delayMsec)
+{
+    QTimer::singleShot(delayMsec, this, [this]() {
+        restarting = true;
+        clientProcess->start();
+    });
+    return true;
+}
+
+// LSPClientCore::Listener
+
+void LSPClient::notification(const std::string &method, const json &params)
+{
+    // Converting to QJson costs a serialize/parse round trip, skip it if nobody listens
+    if (receivers(SIGNAL(onNotify(QString, QJsonObject))) > 0)
+        emit onNotify(QString::fromStdString(method), toQJsonObject(params));
+}
+
+void LSPClient::response(const json &id, const json &result)
+{
+    if (receivers(SIGNAL(onResponse(QJsonValue, QJsonObject))) > 0)
+        emit onResponse(toQJsonValue(id), toQJsonObject(result));
+}
+
+void LSPClient::error(const json &id, const json &error)
+{
+    if (receivers(SIGNAL(onError(QJsonValue, QJsonObject))) > 0)
+        emit onError(toQJsonValue(id), toQJsonObject(error));
+}
+
+void LSPClient::request(const std::string &method, const json &params, const json &id)
+{
+    emit onRequest(QString::fromStdString(method), toQJsonObject(params), toQJsonValue(id));
+}
+
+void LSPClient::serverLog(const std::vector<LogLine> &lines, uint64_t skipped)
+{
+    std::string content;
+    if (skipped > 0)
+        content += "[" + std::to_string(skipped) + " lines skipped]\n";
+    for (auto &line : lines)
     {
-        // notification
-        if (obj.contains("params"))
-        {
-            emit onNotify(obj["method"].toString(), obj["params"].toObject());
-        }
+        content.append(line.line.data(), line.line.size());
+        content += '\n';
     }
+    emit newStderr(QString::fromUtf8(content.data(), static_cast<int>(content.size())));
 }
 
-void LSPClient::onClientReadyReadStderr()
+void LSPClient::serverFinished(int exitCode, bool crashed)
 {
-    QString content = clientProcess->readAllStandardError();
-    if (!content.isEmpty())
-        emit newStderr(content);
+    emit onServerFinished(exitCode, lastExitStatus);
 }
 
-void LSPClient::onClientError(QProcess::ProcessError error)
+void LSPClient::startupComplete()
 {
-    emit onServerError(error);
+    emit onStartupComplete();
 }
 
-void LSPClient::onClientFinished(int exitCode, QProcess::ExitStatus status)
+void LSPClient::congestionChanged(bool congested)
 {
-    emit onServerFinished(exitCode, status);
+    if (congested)
+        emit onCongested();
+    else
+        emit onDecongested();
+}
+
+void LSPClient::requestDropped(const RequestID &id, const std::string &method)
+{
+    emit onRequestDropped(QString::fromStdString(id), QString::fromStdString(method));
+}
+
+void LSPClient::serverRestarting(int attempt, int delayMsec)
+{
+    emit onServerRestarting(attempt, delayMsec);
+}
+
+void LSPClient::serverRecovered(const RecoveryStats &stats)
+{
+    emit onServerRecovered(stats.lastRecoveryMsec);
+}
+
+void LSPClient::diagnosticsPulled(const std::string &uri, const json &diagnostics)
+{
+    if (receivers(SIGNAL(onDiagnosticsPulled(QString, QJsonArray))) > 0)
+        emit onDiagnosticsPulled(QString::fromStdString(uri), toQJsonValue(diagnostics).toArray());
 }
 
 // Protocol methods
 RequestID LSPClient::initialize(option<DocumentUri> rootUri)
 {
-    if (hasInitialized)
-        return "[Didn't send request because the server is already initialized]";
-    hasInitialized = true;
-    InitializeParams params;
-    params.processId = static_cast<unsigned int>(QCoreApplication::applicationPid());
-    params.rootUri = rootUri;
-    return SendRequest("initialize", params);
+    return clientCore.initialize(rootUri);
+}
+RequestID LSPClient::prewarm(option<DocumentUri> rootUri)
+{
+    return clientCore.prewarm(rootUri);
 }
 RequestID LSPClient::shutdown()
 {
-    return SendRequest("shutdown", json());
+    return clientCore.shutdown();
 }
 RequestID LSPClient::sync()
 {
-    return SendRequest("sync", json());
+    return clientCore.sync();
 }
 void LSPClient::exit()
 {
-    SendNotification("exit", json());
+    clientCore.exit();
 }
 void LSPClient::initialized()
 {
-    SendNotification("initialized", json());
+    clientCore.initialized();
 }
 RequestID LSPClient::registerCapability()
 {
-    return SendRequest("client/registerCapability", json());
+    return clientCore.registerCapability();
 }
-void LSPClient::didOpen(DocumentUri uri, string_ref text, string_ref languageId = "cpp")
+void LSPClient::didOpen(DocumentUri uri, string_ref text, string_ref languageId)
 {
-    DidOpenTextDocumentParams params;
-    params.textDocument.uri = uri;
-    params.textDocument.text = text;
-    params.textDocument.languageId = languageId;
-    SendNotification("textDocument/didOpen", params);
+    clientCore.didOpen(uri, text, languageId);
 }
 void LSPClient::didClose(DocumentUri uri)
 {
-    DidCloseTextDocumentParams params;
-    params.textDocument.uri = uri;
-    SendNotification("textDocument/didClose", params);
+    clientCore.didClose(uri);
 }
 void LSPClient::didChange(DocumentUri uri, std::vector<TextDocumentContentChangeEvent> &changes,
                           option<bool> wantDiagnostics)
 {
-    DidChangeTextDocumentParams params;
-    params.textDocument.uri = uri;
-    params.contentChanges = std::move(changes);
-    params.wantDiagnostics = wantDiagnostics;
-    SendNotification("textDocument/didChange", params);
+    clientCore.didChange(uri, changes, wantDiagnostics);
 }
 RequestID LSPClient::rangeFomatting(DocumentUri uri, Range range)
 {
-    DocumentRangeFormattingParams params;
-    params.textDocument.uri = uri;
-    params.range = range;
-    return SendRequest("textDocument/rangeFormatting", params);
+    return clientCore.rangeFomatting(uri, range);
 }
 RequestID LSPClient::foldingRange(DocumentUri uri)
 {
-    FoldingRangeParams params;
-    params.textDocument.uri = uri;
-    return SendRequest("textDocument/foldingRange", params);
+    return clientCore.foldingRange(uri);
 }
 RequestID LSPClient::selectionRange(DocumentUri uri, std::vector<Position> &positions)
 {
-    SelectionRangeParams params;
-    params.textDocument.uri = uri;
-    params.positions = std::move(positions);
-    return SendRequest("textDocument/selectionRange", params);
+    return clientCore.selectionRange(uri, positions);
 }
 RequestID LSPClient::onTypeFormatting(DocumentUri uri, Position position, string_ref ch)
 {
-    DocumentOnTypeFormattingParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    params.ch = ch;
-    return SendRequest("textDocument/onTypeFormatting", params);
+    return clientCore.onTypeFormatting(uri, position, ch);
 }
 RequestID LSPClient::formatting(DocumentUri uri)
 {
-    DocumentFormattingParams params;
-    params.textDocument.uri = uri;
-    return SendRequest("textDocument/formatting", params);
+    return clientCore.formatting(uri);
 }
 RequestID LSPClient::codeAction(DocumentUri uri, Range range, CodeActionContext context)
 {
-    CodeActionParams params;
-    params.textDocument.uri = uri;
-    params.range = range;
-    params.context = std::move(context);
-    return SendRequest("textDocument/codeAction", std::move(params));
+    return clientCore.codeAction(uri, range, std::move(context));
 }
 RequestID LSPClient::completion(DocumentUri uri, Position position, option<CompletionContext> context)
 {
-    CompletionParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    params.context = context;
-    return SendRequest("textDocument/completion", params);
+    return clientCore.completion(uri, position, context);
 }
 RequestID LSPClient::signatureHelp(DocumentUri uri, Position position)
 {
-    TextDocumentPositionParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    return SendRequest("textDocument/signatureHelp", params);
+    return clientCore.signatureHelp(uri, position);
 }
 RequestID LSPClient::gotoDefinition(DocumentUri uri, Position position)
 {
-    TextDocumentPositionParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    return SendRequest("textDocument/definition", params);
+    return clientCore.gotoDefinition(uri, position);
 }
 RequestID LSPClient::gotoDeclaration(DocumentUri uri, Position position)
 {
-    TextDocumentPositionParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    return SendRequest("textDocument/declaration", params);
+    return clientCore.gotoDeclaration(uri, position);
 }
 RequestID LSPClient::references(DocumentUri uri, Position position)
 {
-    ReferenceParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    return SendRequest("textDocument/references", params);
+    return clientCore.references(uri, position);
 }
 RequestID LSPClient::switchSourceHeader(DocumentUri uri)
 {
-    TextDocumentIdentifier params;
-    params.uri = uri;
-    return SendRequest("textDocument/references", params);
+    return clientCore.switchSourceHeader(uri);
 }
 RequestID LSPClient::rename(DocumentUri uri, Position position, string_ref newName)
 {
-    RenameParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    params.newName = newName;
-    return SendRequest("textDocument/rename", std::move(params));
+    return clientCore.rename(uri, position, newName);
 }
 RequestID LSPClient::hover(DocumentUri uri, Position position)
 {
-    TextDocumentPositionParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    return SendRequest("textDocument/hover", params);
+    return clientCore.hover(uri, position);
 }
 RequestID LSPClient::documentSymbol(DocumentUri uri)
 {
-    DocumentSymbolParams params;
-    params.textDocument.uri = uri;
-    return SendRequest("textDocument/documentSymbol", params);
+    return clientCore.documentSymbol(uri);
 }
 RequestID LSPClient::documentColor(DocumentUri uri)
 {
-    DocumentSymbolParams params;
-    params.textDocument.uri = uri;
-    return SendRequest("textDocument/documentColor", params);
+    return clientCore.documentColor(uri);
 }
 RequestID LSPClient::documentHighlight(DocumentUri uri, Position position)
 {
-    TextDocumentPositionParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    return SendRequest("textDocument/documentHighlight", params);
+    return clientCore.documentHighlight(uri, position);
 }
 RequestID LSPClient::symbolInfo(DocumentUri uri, Position position)
 {
-    TextDocumentPositionParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    return SendRequest("textDocument/symbolInfo", params);
+    return clientCore.symbolInfo(uri, position);
 }
 RequestID LSPClient::typeHierarchy(DocumentUri uri, Position position, TypeHierarchyDirection direction, int resolve)
 {
-    TypeHierarchyParams params;
-    params.textDocument.uri = uri;
-    params.position = position;
-    params.direction = direction;
-    params.resolve = resolve;
-    return SendRequest("textDocument/typeHierarchy", params);
+    return clientCore.typeHierarchy(uri, position, direction, resolve);
 }
 RequestID LSPClient::workspaceSymbol(string_ref query)
 {
-    WorkspaceSymbolParams params;
-    params.query = query;
-    return SendRequest("workspace/symbol", params);
+    return clientCore.workspaceSymbol(query);
 }
 RequestID LSPClient::executeCommand(string_ref cmd, option<TweakArgs> tweakArgs, option<WorkspaceEdit> workspaceEdit)
 {
-    ExecuteCommandParams params;
-    params.tweakArgs = std::move(tweakArgs);
-    params.workspaceEdit = std::move(workspaceEdit);
-    params.command = cmd;
-    return SendRequest("workspace/executeCommand", std::move(params));
+    return clientCore.executeCommand(cmd, std::move(tweakArgs), std::move(workspaceEdit));
 }
-RequestID LSPClient::didChangeWatchedFiles(std::vector<FileEvent> &changes)
+void LSPClient::didChangeWatchedFiles(std::vector<FileEvent> &changes)
 {
-    DidChangeWatchedFilesParams params;
-    params.changes = std::move(changes);
-    return SendRequest("workspace/didChangeWatchedFiles", std::move(params));
+    clientCore.didChangeWatchedFiles(changes);
 }
-RequestID LSPClient::didChangeConfiguration(ConfigurationSettings &settings)
+void LSPClient::didChangeConfiguration(ConfigurationSettings &settings)
 {
-    DidChangeConfigurationParams params;
-    params.settings = std::move(settings);
-    return SendRequest("workspace/didChangeConfiguration", std::move(params));
+    clientCore.didChangeConfiguration(settings);
 }
 
 // general send and notify
 void LSPClient::sendNotification(string_ref method, QJsonDocument &jsonDoc)
 {
-    json doc = toNlohmann(jsonDoc);
-    notify(method, doc);
+    clientCore.sendNotification(method, toNlohmann(jsonDoc));
 }
 
 RequestID LSPClient::sendRequest(string_ref method, QJsonDocument &jsonDoc)
 {
-    std::string id = method.str();
-    json doc = toNlohmann(jsonDoc);
-    request(method, doc, id);
-    return id;
+    return clientCore.sendRequest(method, toNlohmann(jsonDoc));
 }
 
-// general send and notify
-void LSPClient::SendNotification(string_ref method, json jsonDoc)
+void LSPClient::sendResponse(const QJsonValue &id, const QJsonValue &result)
 {
-    notify(method, std::move(jsonDoc));
+    clientCore.sendResponse(fromQJsonValue(id), fromQJsonValue(result));
 }
 
-RequestID LSPClient::SendRequest(string_ref method, json jsonDoc)
+void LSPClient::sendErrorResponse(const QJsonValue &id, ErrorCode code, string_ref message)
 {
-    std::string id = method.str();
-    request(method, std::move(jsonDoc), id);
-    return id;
+    clientCore.sendErrorResponse(fromQJsonValue(id), code, message);
 }
 
-// private
+void LSPClient::setConfigurationSection(string_ref section, const QJsonValue &value)
+{
+    clientCore.setConfigurationSection(section, fromQJsonValue(value));
+}
 
-void LSPClient::writeToServer(std::string &content)
+ProgressTracker &LSPClient::progress()
 {
-    writeToServerBuffer.push_back("Content-Length: " + std::to_string(content.length()) + "\r\n");
-    writeToServerBuffer.push_back("\r\n");
-    writeToServerBuffer.push_back(content);
-    if (clientProcess != nullptr && clientProcess->state() == QProcess::Running)
-    {
-        for (auto s : writeToServerBuffer)
-            clientProcess->write(s.c_str());
-        writeToServerBuffer.clear();
-    }
+    return clientCore.progress();
 }
 
-json LSPClient::toNlohmann(QJsonDocument &doc)
+void LSPClient::enablePullDiagnostics(DiagnosticPullOptions options)
 {
-    return json{doc.toJson().toStdString()};
+    clientCore.enablePullDiagnostics(options);
 }
 
-QJsonDocument LSPClient::toJSONDoc(json &nlohman)
+void LSPClient::setDocumentVisible(DocumentUri uri, bool visible)
 {
-    QString rawStr = QString::fromStdString(nlohman.dump());
-    return QJsonDocument::fromJson(rawStr.toLocal8Bit());
+    clientCore.setDocumentVisible(uri, visible);
+}
+
+size_t LSPClient::pullDiagnostics()
+{
+    return clientCore.pullDiagnostics();
+}
+
+RequestID LSPClient::documentDiagnostic(DocumentUri uri)
+{
+    return clientCore.documentDiagnostic(uri);
+}
+
+RequestID LSPClient::workspaceDiagnostic()
+{
+    return clientCore.workspaceDiagnostic();
+}
+
+StderrLog &LSPClient::stderrLog()
+{
+    return clientCore.stderrLog();
+}
+
+int LSPClient::inFlightRequests() const
+{
+    return clientCore.inFlightRequests();
+}
+
+bool LSPClient::setResponseCallback(const RequestID &id, ResponseCallback callback)
+{
+    return clientCore.setResponseCallback(id, std::move(callback));
+}
+
+void LSPClient::cancelRequest(const RequestID &id)
+{
+    clientCore.cancelRequest(id);
+}
+
+const StartupTimeline &LSPClient::startupTimeline() const
+{
+    return clientCore.startupTimeline();
+}
+
+MetricsSnapshot LSPClient::metrics() const
+{
+    return clientCore.metrics();
+}
+
+void LSPClient::resetMetrics()
+{
+    clientCore.resetMetrics();
+}
+
+bool LSPClient::startTrace(const std::string &path, TraceOptions options)
+{
+    return clientCore.startTrace(path, options);
+}
+
+void LSPClient::stopTrace()
+{
+    clientCore.stopTrace();
+}
+
+bool LSPClient::isTracing() const
+{
+    return clientCore.isTracing();
+}
+
+void LSPClient::enableSpans(size_t maxEvents)
+{
+    clientCore.enableSpans(maxEvents);
+}
+
+void LSPClient::disableSpans()
+{
+    clientCore.disableSpans();
 }
 
-void LSPClient::notify(string_ref method, json value)
+SpanTracer *LSPClient::spans() const
 {
-    json payload = {{"jsonrpc", "2.0"}, {"method", method}, {"params", value}};
-    std::string content = payload.dump();
-    writeToServer(content);
+    return clientCore.spans();
 }
 
-void LSPClient::request(string_ref method, json param, RequestID id)
+MemoryUsage LSPClient::memoryUsage() const
 {
-    json rpc = {{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", param}};
-    std::string content = rpc.dump();
-    writeToServer(content);
+    return clientCore.memoryUsage();
+}
+
+void LSPClient::setMemoryBudget(size_t bytes)
+{
+    clientCore.setMemoryBudget(bytes);
+}
+
+size_t LSPClient::memoryBudget() const
+{
+    return clientCore.memoryBudget();
+}
+
+void LSPClient::addMemoryCache(string_ref name, std::function<size_t()> usage, std::function<void(size_t bytes)> evict)
+{
+    clientCore.addMemoryCache(name, std::move(usage), std::move(evict));
+}
+
+void LSPClient::setMethodPriority(string_ref method, RequestPriority priority)
+{
+    clientCore.setMethodPriority(method, priority);
+}
+
+void LSPClient::setInFlightLimit(RequestPriority priority, int limit)
+{
+    clientCore.setInFlightLimit(priority, limit);
+}
+
+SchedulerStats LSPClient::schedulerStats(RequestPriority priority) const
+{
+    return clientCore.schedulerStats(priority);
+}
+
+void LSPClient::setBackpressure(BackpressureLimits limits)
+{
+    clientCore.setBackpressure(limits);
+}
+
+BackpressureLimits LSPClient::backpressure() const
+{
+    return clientCore.backpressure();
+}
+
+SendStatus LSPClient::lastSendStatus() const
+{
+    return clientCore.lastSendStatus();
+}
+
+bool LSPClient::isCongested() const
+{
+    return clientCore.isCongested();
+}
+
+qint64 LSPClient::queuedBytes() const
+{
+    return clientCore.queuedBytes();
+}
+
+void LSPClient::setRestartPolicy(RestartPolicy policy)
+{
+    clientCore.setRestartPolicy(policy);
+}
+
+const RecoveryStats &LSPClient::recoveryStats() const
+{
+    return clientCore.recoveryStats();
+}
+
+LSPClientCore &LSPClient::core()
+{
+    return clientCore;
+}
+
+bool LSPClient::watchFiles(const std::string &rootPath, int windowMsec)
+{
+    if (!clientCore.watchFiles(rootPath, windowMsec))
+        return false;
+    fileWatcherNotifier.reset(new QSocketNotifier(clientCore.fileWatcherFd(), QSocketNotifier::Read));
+    connect(fileWatcherNotifier.get(), SIGNAL(activated(int)), this, SLOT(onFileWatcherActivated()));
+    return true;
+}
+
+void LSPClient::setFileWatchers(const std::vector<FileSystemWatcher> &watchers)
+{
+    clientCore.setFileWatchers(watchers);
+}
+
+// private
+
+void LSPClient::scheduleFileEvents()
+{
+    int timeout = clientCore.fileEventTimeout();
+    if (timeout >= 0 && !fileEventTimer.isActive())
+        fileEventTimer.start(timeout);
+}
+
+void LSPClient::scheduleStderr()
+{
+    int timeout = clientCore.stderrTimeout();
+    if (timeout >= 0 && !stderrTimer.isActive())
+        stderrTimer.start(timeout);
+}
+
+json LSPClient::toNlohmann(QJsonDocument &doc)
+{
+    return json::parse(doc.toJson(QJsonDocument::Compact).toStdString(), nullptr, false);
+}
+
+QJsonDocument LSPClient::toJSONDoc(json &nlohman)
+{
+    QString rawStr = QString::fromStdString(nlohman.dump());
+    return QJsonDocument::fromJson(rawStr.toLocal8Bit());
 }
 
 LSPClient::~LSPClient()
@@ -0,0 +1,1603 @@
+#include <LSPClientCore.hpp>
+#include <LSPEdits.hpp>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+using RequestID = std::string;
+
+namespace
+{
+unsigned int currentProcessId()
+{
+#ifdef _WIN32
+    return static_cast<unsigned int>(_getpid());
+#else
+    return static_cast<unsigned int>(getpid());
+#endif
+}
+
+bool applyContentChange(std::string &text, TextDocumentContentChangeEvent &change)
+{
+    if (!change.range.has())
+    {
+        text = change.text;
+        return true;
+    }
+    std::vector<TextEdit> edits(1);
+    edits[0].range = change.range.value();
+    edits[0].newText = change.text;
+    return applyTextEdits(text, std::move(edits));
+}
+
+uint64_t micros(std::chrono::steady_clock::duration duration)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+// Heap bytes behind a string; short ones live in its small string buffer
+size_t heapBytes(const std::string &text)
+{
+    static const size_t inlineCapacity = std::string().capacity();
+    return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+}
+
+// A hash map node holds the entry and a next pointer, plus a pointer in the bucket array
+template <typename Entry> size_t nodeBytes()
+{
+    return sizeof(Entry) + 2 * sizeof(void *);
+}
+
+std::string stringField(const json &object, const char *key)
+{
+    auto it = object.find(key);
+    return it != object.end() && it->is_string() ? it->get<std::string>() : std::string();
+}
+} // namespace
+
+LSPClientCore::LSPClientCore(LSPTransport &transport, Listener *listener)
+    : transport(transport), listener(listener != nullptr ? listener : &noListener), startupClock(Clock::now())
+{
+    methodPriorities["textDocument/documentSymbol"] = RequestPriority::Viewport;
+    methodPriorities["textDocument/foldingRange"] = RequestPriority::Viewport;
+    methodPriorities["textDocument/documentColor"] = RequestPriority::Viewport;
+    methodPriorities["textDocument/diagnostic"] = RequestPriority::Viewport;
+    methodPriorities["workspace/diagnostic"] = RequestPriority::Background;
+    // Running a command twice may apply its effect twice
+    retryOnRestart["workspace/executeCommand"] = false;
+    // They carry resultIds of the old server; the documents are due again after the restart
+    retryOnRestart["textDocument/diagnostic"] = false;
+    retryOnRestart["workspace/diagnostic"] = false;
+
+    responders["workspace/configuration"] = [this](const json &params, json &result) {
+        result = json::array();
+        if (params.is_object() && params.contains("items") && params["items"].is_array())
+        {
+            for (auto &item : params["items"])
+                result.push_back(configurationFor(item));
+        }
+        return true;
+    };
+    auto accept = [](const json &, json &result) {
+        result = nullptr;
+        return true;
+    };
+    responders["window/workDoneProgress/create"] = accept;
+    responders["client/registerCapability"] = accept;
+    responders["client/unregisterCapability"] = accept;
+    responders["workspace/diagnostic/refresh"] = [this](const json &, json &result) {
+        diagnosticPulls.refresh();
+        pullDiagnostics();
+        result = nullptr;
+        return true;
+    };
+
+    transport.setReceiver(this);
+}
+
+LSPClientCore::~LSPClientCore()
+{
+    transport.setReceiver(nullptr);
+}
+
+void LSPClientCore::setListener(Listener *newListener)
+{
+    listener = newListener != nullptr ? newListener : &noListener;
+}
+
+// transport
+
+void LSPClientCore::transportOpened()
+{
+    if (recovering)
+    {
+        replayState();
+        return;
+    }
+    timeline.processStarted = elapsed();
+
+    // Everything written before the process was running is still buffered
+    flushWriteBuffer();
+}
+
+void LSPClientCore::transportData(const char *data, size_t size)
+{
+    Clock::time_point arrived = spanTracer ? Clock::now() : Clock::time_point();
+    if (framer.buffered() == 0)
+        readStart = arrived;
+    framer.append(data, size);
+
+    std::string payload;
+    while (framer.next(payload))
+    {
+        if (trace)
+            trace->record(TraceDirection::FromServer, payload);
+        decodePeak = std::max(decodePeak, payload.size());
+        handleMessage(payload);
+        // Whatever follows in this chunk is the start of the next message
+        readStart = arrived;
+    }
+    enforceMemoryBudget();
+}
+
+void LSPClientCore::transportStderr(const char *data, size_t size)
+{
+    if (trace && trace->options().recordStderr)
+        trace->record(TraceDirection::ServerStderr, data, size);
+    listener->serverStderr(data, size);
+    stderrLines.append(data, size);
+    if (stderrLines.due())
+        deliverStderr();
+}
+
+void LSPClientCore::transportClosed(int exitCode, bool crashed)
+{
+    framer.clear();
+    // The last words of a crashing server come before the news of its exit
+    stderrLines.finish();
+    deliverStderr();
+    if (!recovering)
+        listener->serverFinished(exitCode, crashed);
+    if (scheduleRestart())
+        return;
+    recovering = false;
+    replayPending = false;
+    progressTracker.clear();
+
+    // Nothing in flight will be answered anymore
+    failPendingRequests("The server exited");
+    scheduler.clear();
+    updateCongestion();
+}
+
+void LSPClientCore::transportDrained()
+{
+    updateCongestion();
+}
+
+void LSPClientCore::handleMessage(const std::string &payload)
+{
+    auto decodeStart = Clock::now();
+    json message = json::parse(payload, nullptr, false);
+    auto decodeEnd = Clock::now();
+    metricsRecorder.messageIn(payload.size(), micros(decodeEnd - decodeStart));
+    if (!message.is_object())
+    {
+        // Some JSON Parse Error
+        return;
+    }
+    static const json null;
+    auto field = [&message](const char *key) -> const json & {
+        auto it = message.find(key);
+        return it != message.end() ? *it : null;
+    };
+
+    auto id = message.find("id");
+    auto method = message.find("method");
+    if (id != message.end())
+    {
+        if (method != message.end())
+        {
+            std::string name = method->is_string() ? method->get<std::string>() : std::string();
+            if (spanTracer)
+                spanTracer->complete("decode", name, decodeStart, decodeEnd);
+            if (name == "client/registerCapability" || name == "client/unregisterCapability")
+                handleRegistrations(field("params"), name == "client/registerCapability");
+            auto responder = responders.find(name);
+            json result;
+            if (responder != responders.end() && responder->second(field("params"), result))
+                sendResponse(*id, std::move(result));
+            else
+                listener->request(name, field("params"), *id);
+            if (spanTracer)
+                spanTracer->complete("dispatch", name, decodeEnd, Clock::now());
+        }
+        else if (message.contains("result"))
+        {
+            std::string key = id->is_string() ? id->get<std::string>() : id->dump();
+            if (key == initializeId && timeline.initializeReplied < 0)
+                timeline.initializeReplied = elapsed();
+            if (key == initializeId)
+                readServerCapabilities(message["result"]);
+            if (spanTracer)
+                replySpans(key, decodeStart, decodeEnd);
+            if (recovering && key == initializeId)
+            {
+                recovering = false;
+                recoveredAt = Clock::now();
+                recovery.lastRecoveryMsec =
+                    std::chrono::duration_cast<std::chrono::milliseconds>(recoveredAt - crashedAt).count();
+                requestFinished(key, false);
+                listener->serverRecovered(recovery);
+            }
+            else
+            {
+                auto pending = pendingRequests.find(key);
+                if (symbolCache && pending != pendingRequests.end())
+                    storeSymbols(pending->second, message["result"]);
+                ResponseCallback callback = requestFinished(key, false);
+                listener->response(*id, message["result"]);
+                if (callback)
+                    callback(message["result"], nullptr);
+            }
+            if (spanTracer)
+            {
+                auto now = Clock::now();
+                spanTracer->stage(key, "dispatch", decodeEnd, now);
+                spanTracer->end(key, now, "answered");
+            }
+        }
+        else if (message.contains("error"))
+        {
+            std::string key = id->is_string() ? id->get<std::string>() : id->dump();
+            if (spanTracer)
+                replySpans(key, decodeStart, decodeEnd);
+            ResponseCallback callback = requestFinished(key, true);
+            listener->error(*id, message["error"]);
+            if (callback)
+                callback(json(), &message["error"]);
+            if (spanTracer)
+            {
+                auto now = Clock::now();
+                spanTracer->stage(key, "dispatch", decodeEnd, now);
+                spanTracer->end(key, now, "error");
+            }
+        }
+    }
+    else if (method != message.end() && method->is_string())
+    {
+        // notification
+        const std::string &name = method->get_ref<const std::string &>();
+        if (timeline.firstDiagnostics < 0 && name == "textDocument/publishDiagnostics")
+        {
+            timeline.firstDiagnostics = elapsed();
+            listener->startupComplete();
+        }
+        else if (name == "$/progress")
+        {
+            progressTracker.handle(field("params"));
+        }
+        if (message.contains("params"))
+            listener->notification(name, message["params"]);
+        if (spanTracer)
+        {
+            spanTracer->complete("decode", name, decodeStart, decodeEnd);
+            spanTracer->complete("dispatch", name, decodeEnd, Clock::now());
+        }
+    }
+}
+
+// Protocol methods
+RequestID LSPClientCore::initialize(option<DocumentUri> rootUri)
+{
+    if (hasInitialized)
+        return "[Didn't send request because the server is already initialized]";
+    hasInitialized = true;
+    InitializeParams params;
+    params.processId = currentProcessId();
+    params.rootUri = rootUri;
+    params.capabilities.DidChangeWatchedFiles = fileWatcher != nullptr;
+    initializeParams = params;
+    if (pullDiagnosticsEnabled)
+    {
+        initializeParams["capabilities"]["textDocument"]["diagnostic"] = {{"dynamicRegistration", false}};
+        initializeParams["capabilities"]["workspace"]["diagnostics"] = {{"refreshSupport", true}};
+    }
+    initializeId = sendRequest("initialize", initializeParams);
+    timeline.initializeSent = elapsed();
+    return initializeId;
+}
+RequestID LSPClientCore::prewarm(option<DocumentUri> rootUri)
+{
+    if (hasInitialized)
+        return "[Didn't send request because the server is already initialized]";
+    RequestID id = initialize(rootUri);
+    initialized();
+    return id;
+}
+RequestID LSPClientCore::shutdown()
+{
+    stopRequested = true;
+    return sendRequest("shutdown", json());
+}
+RequestID LSPClientCore::sync()
+{
+    return sendRequest("sync", json());
+}
+void LSPClientCore::exit()
+{
+    stopRequested = true;
+    sendNotification("exit", json());
+}
+void LSPClientCore::initialized()
+{
+    sendNotification("initialized", json());
+}
+RequestID LSPClientCore::registerCapability()
+{
+    return sendRequest("client/registerCapability", json());
+}
+void LSPClientCore::didOpen(DocumentUri uri, string_ref text, string_ref languageId)
+{
+    TrackedDocument &document = documents[uri.str()];
+    document.version = 0;
+    document.textKnown = restart.enabled || symbolCache != nullptr;
+    if (document.textKnown)
+    {
+        document.languageId = languageId.str();
+        document.text = text.str();
+    }
+    accountDocument(uri.str(), document);
+    enforceMemoryBudget();
+    if (pullDiagnosticsEnabled)
+        diagnosticPulls.opened(uri.str());
+
+    DidOpenTextDocumentParams params;
+    params.textDocument.uri = uri;
+    params.textDocument.text = text;
+    params.textDocument.languageId = languageId;
+    params.textDocument.version = document.version;
+    sendNotification("textDocument/didOpen", params);
+}
+void LSPClientCore::didClose(DocumentUri uri)
+{
+    auto document = documents.find(uri.str());
+    if (document != documents.end())
+    {
+        documentBytes -= document->second.accounted;
+        documents.erase(document);
+    }
+    diagnosticPulls.closed(uri.str());
+    DidCloseTextDocumentParams params;
+    params.textDocument.uri = uri;
+    sendNotification("textDocument/didClose", params);
+}
+void LSPClientCore::didChange(DocumentUri uri, std::vector<TextDocumentContentChangeEvent> &changes,
+                          option<bool> wantDiagnostics)
+{
+    TrackedDocument &document = documents[uri.str()];
+    ++document.version;
+    if (document.textKnown)
+    {
+        for (auto &change : changes)
+        {
+            // A range outside the text means we lost track of it; don't replay garbage
+            if (!applyContentChange(document.text, change))
+                document.textKnown = false;
+        }
+        accountDocument(uri.str(), document);
+        enforceMemoryBudget();
+    }
+    diagnosticPulls.edited(uri.str());
+
+    DidChangeTextDocumentParams params;
+    params.textDocument.uri = uri;
+    params.textDocument.version = document.version;
+    params.contentChanges = std::move(changes);
+    params.wantDiagnostics = wantDiagnostics;
+    sendNotification("textDocument/didChange", params);
+}
+RequestID LSPClientCore::rangeFomatting(DocumentUri uri, Range range)
+{
+    DocumentRangeFormattingParams params;
+    params.textDocument.uri = uri;
+    params.range = range;
+    return sendRequest("textDocument/rangeFormatting", params);
+}
+RequestID LSPClientCore::foldingRange(DocumentUri uri)
+{
+    FoldingRangeParams params;
+    params.textDocument.uri = uri;
+    return sendRequest("textDocument/foldingRange", params);
+}
+RequestID LSPClientCore::selectionRange(DocumentUri uri, std::vector<Position> &positions)
+{
+    SelectionRangeParams params;
+    params.textDocument.uri = uri;
+    params.positions = std::move(positions);
+    return sendRequest("textDocument/selectionRange", params);
+}
+RequestID LSPClientCore::onTypeFormatting(DocumentUri uri, Position position, string_ref ch)
+{
+    DocumentOnTypeFormattingParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    params.ch = ch;
+    return sendRequest("textDocument/onTypeFormatting", params);
+}
+RequestID LSPClientCore::formatting(DocumentUri uri)
+{
+    DocumentFormattingParams params;
+    params.textDocument.uri = uri;
+    return sendRequest("textDocument/formatting", params);
+}
+RequestID LSPClientCore::codeAction(DocumentUri uri, Range range, CodeActionContext context)
+{
+    CodeActionParams params;
+    params.textDocument.uri = uri;
+    params.range = range;
+    params.context = std::move(context);
+    return sendRequest("textDocument/codeAction", std::move(params));
+}
+RequestID LSPClientCore::completion(DocumentUri uri, Position position, option<CompletionContext> context)
+{
+    CompletionParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    params.context = context;
+    return sendRequest("textDocument/completion", params);
+}
+RequestID LSPClientCore::signatureHelp(DocumentUri uri, Position position)
+{
+    TextDocumentPositionParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    return sendRequest("textDocument/signatureHelp", params);
+}
+RequestID LSPClientCore::gotoDefinition(DocumentUri uri, Position position)
+{
+    TextDocumentPositionParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    return sendRequest("textDocument/definition", params);
+}
+RequestID LSPClientCore::gotoDeclaration(DocumentUri uri, Position position)
+{
+    TextDocumentPositionParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    return sendRequest("textDocument/declaration", params);
+}
+RequestID LSPClientCore::references(DocumentUri uri, Position position)
+{
+    ReferenceParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    return sendRequest("textDocument/references", params);
+}
+RequestID LSPClientCore::switchSourceHeader(DocumentUri uri)
+{
+    TextDocumentIdentifier params;
+    params.uri = uri;
+    return sendRequest("textDocument/references", params);
+}
+RequestID LSPClientCore::rename(DocumentUri uri, Position position, string_ref newName)
+{
+    RenameParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    params.newName = newName;
+    return sendRequest("textDocument/rename", std::move(params));
+}
+RequestID LSPClientCore::hover(DocumentUri uri, Position position)
+{
+    TextDocumentPositionParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    return sendRequest("textDocument/hover", params);
+}
+RequestID LSPClientCore::documentSymbol(DocumentUri uri)
+{
+    DocumentSymbolParams params;
+    params.textDocument.uri = uri;
+    RequestID id = sendRequest("textDocument/documentSymbol", params);
+    auto document = documents.find(uri.str());
+    if (symbolCache && document != documents.end() && document->second.textKnown)
+        cacheReply(id, uri.str(), SymbolCache::contentHash(document->second.text));
+    return id;
+}
+RequestID LSPClientCore::documentColor(DocumentUri uri)
+{
+    DocumentSymbolParams params;
+    params.textDocument.uri = uri;
+    return sendRequest("textDocument/documentColor", params);
+}
+RequestID LSPClientCore::documentHighlight(DocumentUri uri, Position position)
+{
+    TextDocumentPositionParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    return sendRequest("textDocument/documentHighlight", params);
+}
+RequestID LSPClientCore::symbolInfo(DocumentUri uri, Position position)
+{
+    TextDocumentPositionParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    return sendRequest("textDocument/symbolInfo", params);
+}
+RequestID LSPClientCore::typeHierarchy(DocumentUri uri, Position position, TypeHierarchyDirection direction,
+                                       int resolve)
+{
+    TypeHierarchyParams params;
+    params.textDocument.uri = uri;
+    params.position = position;
+    params.direction = direction;
+    params.resolve = resolve;
+    return sendRequest("textDocument/typeHierarchy", params);
+}
+RequestID LSPClientCore::workspaceSymbol(string_ref query)
+{
+    WorkspaceSymbolParams params;
+    params.query = query;
+    RequestID id = sendRequest("workspace/symbol", params);
+    if (symbolCache)
+        cacheReply(id, query.str(), 0);
+    return id;
+}
+RequestID LSPClientCore::executeCommand(string_ref cmd, option<TweakArgs> tweakArgs,
+                                        option<WorkspaceEdit> workspaceEdit)
+{
+    ExecuteCommandParams params;
+    params.tweakArgs = std::move(tweakArgs);
+    params.workspaceEdit = std::move(workspaceEdit);
+    params.command = cmd;
+    return sendRequest("workspace/executeCommand", std::move(params));
+}
+void LSPClientCore::didChangeWatchedFiles(std::vector<FileEvent> &changes)
+{
+    DidChangeWatchedFilesParams params;
+    params.changes = std::move(changes);
+    sendNotification("workspace/didChangeWatchedFiles", std::move(params));
+}
+void LSPClientCore::didChangeConfiguration(ConfigurationSettings &settings)
+{
+    // Changes are incremental, a restarted server gets all of them merged into one
+    if (!configuration.has())
+        configuration = ConfigurationSettings();
+    for (auto &change : settings.compilationDatabaseChanges)
+        configuration->compilationDatabaseChanges[change.first] = change.second;
+
+    DidChangeConfigurationParams params;
+    params.settings = std::move(settings);
+    sendNotification("workspace/didChangeConfiguration", std::move(params));
+}
+
+// general send and notify
+void LSPClientCore::sendNotification(string_ref method, json params)
+{
+    notify(method, std::move(params));
+}
+
+RequestID LSPClientCore::sendRequest(string_ref method, json params)
+{
+    RequestID id = nextRequestId(method);
+    if (request(method, std::move(params), id) == SendStatus::Rejected)
+        return RequestID();
+    return id;
+}
+
+void LSPClientCore::sendResponse(const json &id, json result)
+{
+    // The server that asked is gone, a restarted one doesn't know the id
+    if (replayPending)
+        return;
+    json payload = {{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}};
+    writeToServer(payload.dump());
+}
+
+void LSPClientCore::sendErrorResponse(const json &id, ErrorCode code, string_ref message, json data)
+{
+    if (replayPending)
+        return;
+    json error = {{"code", code}, {"message", message}};
+    if (!data.is_null())
+        error["data"] = std::move(data);
+    json payload = {{"jsonrpc", "2.0"}, {"id", id}, {"error", std::move(error)}};
+    writeToServer(payload.dump());
+}
+
+void LSPClientCore::setRequestResponder(string_ref method, RequestResponder responder)
+{
+    if (responder)
+        responders[method.str()] = std::move(responder);
+    else
+        responders.erase(method.str());
+}
+
+void LSPClientCore::setConfigurationSection(string_ref section, json value)
+{
+    json *node = &configurationSections;
+    std::string path = section.str();
+    size_t start = 0;
+    while (true)
+    {
+        size_t dot = path.find('.', start);
+        if (!node->is_object())
+            *node = json::object();
+        node = &(*node)[path.substr(start, dot - start)];
+        if (dot == std::string::npos)
+            break;
+        start = dot + 1;
+    }
+    *node = std::move(value);
+}
+
+ProgressTracker &LSPClientCore::progress()
+{
+    return progressTracker;
+}
+
+void LSPClientCore::enablePullDiagnostics(DiagnosticPullOptions options)
+{
+    pullDiagnosticsEnabled = true;
+    diagnosticPulls.setOptions(options);
+}
+
+void LSPClientCore::setDocumentVisible(DocumentUri uri, bool visible)
+{
+    diagnosticPulls.setVisible(uri.str(), visible);
+}
+
+size_t LSPClientCore::pullDiagnostics()
+{
+    if (!canPullDiagnostics())
+        return 0;
+    size_t sent = 0;
+    for (auto &uri : diagnosticPulls.due())
+    {
+        if (!documentDiagnostic(uri).empty())
+            ++sent;
+    }
+    return sent;
+}
+
+RequestID LSPClientCore::documentDiagnostic(DocumentUri uri)
+{
+    if (!canPullDiagnostics())
+        return RequestID();
+    std::string key = uri.str();
+    std::string previousResultId;
+    uint64_t change = diagnosticPulls.started(key, previousResultId);
+
+    DocumentDiagnosticParams params;
+    params.textDocument.uri = uri;
+    params.identifier = diagnosticIdentifier;
+    if (!previousResultId.empty())
+        params.previousResultId = previousResultId;
+    RequestID id = sendRequest("textDocument/diagnostic", params);
+    if (id.empty())
+    {
+        diagnosticPulls.failed(key);
+        return id;
+    }
+    setResponseCallback(id, [this, key, change](const json &result, const json *error) {
+        if (error != nullptr || !result.is_object())
+            diagnosticPulls.failed(key);
+        else
+            handleDiagnosticReport(key, result, &change);
+    });
+    return id;
+}
+
+RequestID LSPClientCore::workspaceDiagnostic()
+{
+    if (!canPullDiagnostics() || !workspaceDiagnostics)
+        return RequestID();
+    WorkspaceDiagnosticParams params;
+    params.identifier = diagnosticIdentifier;
+    params.previousResultIds = diagnosticPulls.previousResultIds();
+    RequestID id = sendRequest("workspace/diagnostic", params);
+    if (id.empty())
+        return id;
+    setResponseCallback(id, [this](const json &result, const json *error) {
+        if (error != nullptr || !result.is_object() || !result.contains("items") || !result["items"].is_array())
+            return;
+        for (auto &report : result["items"])
+        {
+            std::string uri = report.is_object() ? stringField(report, "uri") : std::string();
+            if (!uri.empty())
+                handleDiagnosticReport(uri, report, nullptr);
+        }
+    });
+    return id;
+}
+
+bool LSPClientCore::canPullDiagnostics() const
+{
+    return pullDiagnosticsEnabled && diagnosticProvider;
+}
+
+const DiagnosticPuller &LSPClientCore::diagnosticPuller() const
+{
+    return diagnosticPulls;
+}
+
+int LSPClientCore::inFlightRequests() const
+{
+    return static_cast<int>(pendingRequests.size());
+}
+
+bool LSPClientCore::setResponseCallback(const RequestID &id, ResponseCallback callback)
+{
+    auto pending = pendingRequests.find(id);
+    if (pending == pendingRequests.end())
+        return false;
+    pending->second.callback = std::move(callback);
+    return true;
+}
+
+void LSPClientCore::cancelRequest(const RequestID &id)
+{
+    auto pending = pendingRequests.find(id);
+    if (pending == pendingRequests.end())
+        return;
+    pending->second.callback = nullptr;
+    metricsRecorder.requestCancelled(pending->second.method);
+    if (scheduler.remove(id))
+    {
+        if (spanTracer)
+            spanTracer->end(id, Clock::now(), "cancelled");
+        pendingBytes -= pending->second.accounted;
+        pendingRequests.erase(pending);
+        updateCongestion();
+        return;
+    }
+    sendNotification("$/cancelRequest", {{"id", id}});
+}
+
+const StartupTimeline &LSPClientCore::startupTimeline() const
+{
+    return timeline;
+}
+
+MetricsSnapshot LSPClientCore::metrics() const
+{
+    MetricsSnapshot snapshot = metricsRecorder.snapshot();
+    snapshot.inFlight = scheduler.inFlightCount();
+    for (RequestPriority priority :
+         {RequestPriority::Interactive, RequestPriority::Viewport, RequestPriority::Background})
+    {
+        SchedulerStats stats = scheduler.stats(priority);
+        snapshot.queued += stats.queueDepth;
+        snapshot.maxQueued = std::max(snapshot.maxQueued, stats.maxQueueDepth);
+    }
+    snapshot.queuedBytes = queuedBytes();
+    return snapshot;
+}
+
+void LSPClientCore::resetMetrics()
+{
+    metricsRecorder.reset();
+}
+
+bool LSPClientCore::startTrace(const std::string &path, TraceOptions options)
+{
+    stopTrace();
+    trace.reset(new TraceRecorder(path, options));
+    if (!trace->open())
+    {
+        lastTraceError = trace->errorString();
+        trace.reset();
+        return false;
+    }
+    lastTraceError.clear();
+    return true;
+}
+
+void LSPClientCore::stopTrace()
+{
+    if (!trace)
+        return;
+    trace->close();
+    lastTraceError = trace->errorString();
+    trace.reset();
+}
+
+bool LSPClientCore::isTracing() const
+{
+    return trace && trace->isRecording();
+}
+
+std::string LSPClientCore::traceError() const
+{
+    return trace ? trace->errorString() : lastTraceError;
+}
+
+void LSPClientCore::enableSpans(size_t maxEvents)
+{
+    spanTracer.reset(new SpanTracer(maxEvents));
+}
+
+void LSPClientCore::disableSpans()
+{
+    spanTracer.reset();
+}
+
+SpanTracer *LSPClientCore::spans() const
+{
+    return spanTracer.get();
+}
+
+MemoryUsage LSPClientCore::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.receiveBuffer = framer.capacity();
+    usage.sendBuffer = static_cast<size_t>(writeBufferBytes + transport.bytesToWrite());
+    usage.scheduledRequests = scheduler.queuedBytes();
+    usage.pendingRequests = pendingBytes;
+    usage.documents = documentBytes + diagnosticPulls.memoryUsage();
+    usage.instrumentation =
+        metricsRecorder.memoryUsage() + progressTracker.memoryUsage() + stderrLines.memoryUsage();
+    if (trace)
+        usage.instrumentation += trace->memoryUsage();
+    if (spanTracer)
+        usage.caches.push_back({"spans", spanTracer->memoryUsage()});
+    for (auto &cache : memoryCaches)
+        usage.caches.push_back({cache.name, cache.usage()});
+    usage.decodePeak = decodePeak;
+    usage.budget = budget;
+    usage.evictions = evictions;
+    return usage;
+}
+
+void LSPClientCore::setMemoryBudget(size_t bytes)
+{
+    budget = bytes;
+    enforceMemoryBudget();
+}
+
+size_t LSPClientCore::memoryBudget() const
+{
+    return budget;
+}
+
+void LSPClientCore::addMemoryCache(string_ref name, std::function<size_t()> usage,
+                                   std::function<void(size_t bytes)> evict)
+{
+    memoryCaches.push_back({name.str(), std::move(usage), std::move(evict)});
+}
+
+void LSPClientCore::setSymbolCache(SymbolCache *cache)
+{
+    symbolCache = cache;
+}
+
+StderrLog &LSPClientCore::stderrLog()
+{
+    return stderrLines;
+}
+
+int LSPClientCore::stderrTimeout() const
+{
+    return static_cast<int>(stderrLines.timeUntilDue().count());
+}
+
+void LSPClientCore::flushStderr()
+{
+    if (stderrLines.due())
+        deliverStderr();
+}
+
+void LSPClientCore::setMethodPriority(string_ref method, RequestPriority priority)
+{
+    methodPriorities[method.str()] = priority;
+}
+
+void LSPClientCore::setInFlightLimit(RequestPriority priority, int limit)
+{
+    scheduler.setInFlightLimit(priority, limit);
+    writeScheduled();
+}
+
+SchedulerStats LSPClientCore::schedulerStats(RequestPriority priority) const
+{
+    return scheduler.stats(priority);
+}
+
+void LSPClientCore::setBackpressure(BackpressureLimits newLimits)
+{
+    limits = newLimits;
+    scheduler.setTotalInFlightLimit(limits.maxInFlight);
+    writeScheduled();
+    updateCongestion();
+}
+
+BackpressureLimits LSPClientCore::backpressure() const
+{
+    return limits;
+}
+
+SendStatus LSPClientCore::lastSendStatus() const
+{
+    return sendStatus;
+}
+
+bool LSPClientCore::isCongested() const
+{
+    return congested;
+}
+
+int64_t LSPClientCore::queuedBytes() const
+{
+    return static_cast<int64_t>(scheduler.queuedBytes()) + writeBufferBytes + transport.bytesToWrite();
+}
+
+void LSPClientCore::setRestartPolicy(RestartPolicy policy)
+{
+    restart = policy;
+}
+
+RestartPolicy LSPClientCore::restartPolicy() const
+{
+    return restart;
+}
+
+void LSPClientCore::setRetryOnRestart(string_ref method, bool retry)
+{
+    retryOnRestart[method.str()] = retry;
+}
+
+bool LSPClientCore::isRecovering() const
+{
+    return recovering;
+}
+
+const RecoveryStats &LSPClientCore::recoveryStats() const
+{
+    return recovery;
+}
+
+LSPClientCore::PriorityScope::PriorityScope(LSPClientCore &client, RequestPriority priority)
+    : client(client), previous(client.priorityOverride)
+{
+    client.priorityOverride = priority;
+}
+
+LSPClientCore::PriorityScope::~PriorityScope()
+{
+    client.priorityOverride = previous;
+}
+
+bool LSPClientCore::watchFiles(const std::string &rootPath, int windowMsec)
+{
+    if (!InotifyWatcher::isSupported())
+        return false;
+    std::unique_ptr<InotifyWatcher> watcher(new InotifyWatcher);
+    if (!watcher->watchTree(rootPath))
+        return false;
+    fileWatcher = std::move(watcher);
+    fileEvents.setWindow(std::chrono::milliseconds(windowMsec));
+    return true;
+}
+
+void LSPClientCore::setFileWatchers(const std::vector<FileSystemWatcher> &watchers)
+{
+    watcherRegistrations.clear();
+    watcherRegistrations[std::string()] = watchers;
+    fileWatchFilter.setWatchers(watchers);
+}
+
+int LSPClientCore::fileWatcherFd() const
+{
+    return fileWatcher ? fileWatcher->fd() : -1;
+}
+
+void LSPClientCore::readFileEvents()
+{
+    if (!fileWatcher)
+        return;
+    InotifyWatcher::Callback report = [this](const std::string &path, FileChangeType type) {
+        if (fileWatchFilter.accepts(path, type))
+            fileEvents.add(path, type);
+    };
+    // On overflow the kernel dropped events, which can't be reconstructed; every watched file
+    // the server asked for is reported changed instead, so it reloads whatever it depends on
+    if (!fileWatcher->readEvents(report))
+        fileWatcher->rescan(report);
+}
+
+int LSPClientCore::fileEventTimeout() const
+{
+    if (fileEvents.empty())
+        return -1;
+    return static_cast<int>(fileEvents.timeUntilDue().count());
+}
+
+void LSPClientCore::flushFileEvents()
+{
+    if (fileEvents.empty() || !fileEvents.due())
+        return;
+    std::vector<FileEvent> batch = fileEvents.takeBatch();
+    didChangeWatchedFiles(batch);
+}
+
+// private
+
+int64_t LSPClientCore::elapsed() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startupClock).count();
+}
+
+void LSPClientCore::handleRegistrations(const json &params, bool registering)
+{
+    // The protocol spells the unregister list "unregisterations"
+    const char *key = registering ? "registrations" : "unregisterations";
+    if (!params.is_object() || !params.contains(key) || !params[key].is_array())
+        return;
+
+    for (auto &registration : params[key])
+    {
+        if (!registration.is_object() || stringField(registration, "method") != "workspace/didChangeWatchedFiles")
+            continue;
+        std::string id = stringField(registration, "id");
+        if (!registering)
+        {
+            watcherRegistrations.erase(id);
+            continue;
+        }
+        DidChangeWatchedFilesRegistrationOptions options;
+        auto registerOptions = registration.find("registerOptions");
+        if (registerOptions != registration.end())
+        {
+            try
+            {
+                registerOptions->get_to(options);
+            }
+            catch (const json::exception &)
+            {
+                // A malformed registration is skipped, the others still apply
+                continue;
+            }
+        }
+        watcherRegistrations[id] = std::move(options.watchers);
+    }
+
+    std::vector<FileSystemWatcher> all;
+    for (auto &registration : watcherRegistrations)
+        all.insert(all.end(), registration.second.begin(), registration.second.end());
+    fileWatchFilter.setWatchers(all);
+}
+
+void LSPClientCore::readServerCapabilities(const json &result)
+{
+    diagnosticProvider = false;
+    workspaceDiagnostics = false;
+    diagnosticIdentifier = option<std::string>();
+    if (!result.is_object() || !result.contains("capabilities") || !result["capabilities"].is_object())
+        return;
+    auto provider = result["capabilities"].find("diagnosticProvider");
+    if (provider == result["capabilities"].end() || !provider->is_object())
+        return;
+    diagnosticProvider = true;
+    auto workspace = provider->find("workspaceDiagnostics");
+    workspaceDiagnostics = workspace != provider->end() && workspace->is_boolean() && workspace->get<bool>();
+    std::string identifier = stringField(*provider, "identifier");
+    if (!identifier.empty())
+        diagnosticIdentifier = identifier;
+}
+
+// A "full" or "unchanged" report; `change` is what documentDiagnostic() asked about, null for
+// reports that arrive without being asked for a document (workspace, relatedDocuments)
+void LSPClientCore::handleDiagnosticReport(const std::string &uri, const json &report, const uint64_t *change)
+{
+    std::string kind = stringField(report, "kind");
+    std::string resultId = stringField(report, "resultId");
+    if (kind != "full" && kind != "unchanged")
+    {
+        if (change != nullptr)
+            diagnosticPulls.failed(uri);
+        return;
+    }
+    if (change != nullptr)
+        diagnosticPulls.reported(uri, resultId, *change);
+    else
+        diagnosticPulls.remember(uri, resultId);
+
+    if (kind == "full")
+    {
+        static const json none = json::array();
+        auto items = report.find("items");
+        listener->diagnosticsPulled(uri, items != report.end() && items->is_array() ? *items : none);
+    }
+
+    auto related = report.find("relatedDocuments");
+    if (related != report.end() && related->is_object())
+    {
+        for (auto entry = related->begin(); entry != related->end(); ++entry)
+        {
+            if (entry->is_object())
+                handleDiagnosticReport(entry.key(), *entry, nullptr);
+        }
+    }
+}
+
+void LSPClientCore::cacheReply(const RequestID &id, std::string key, uint64_t contentHash)
+{
+    auto pending = pendingRequests.find(id);
+    if (pending == pendingRequests.end())
+        return;
+    pending->second.cacheKey = std::move(key);
+    pending->second.contentHash = contentHash;
+    accountRequest(id, pending->second);
+}
+
+void LSPClientCore::storeSymbols(const PendingRequest &pending, const json &result)
+{
+    // null means the server had nothing to say yet, e.g. while it is still indexing
+    if (pending.cacheKey.empty() || !result.is_array())
+        return;
+    if (pending.method == "workspace/symbol")
+        symbolCache->storeWorkspaceSymbols(pending.cacheKey, result);
+    else
+        symbolCache->storeDocumentSymbols(pending.cacheKey, pending.contentHash, result);
+}
+
+json LSPClientCore::configurationFor(const json &item) const
+{
+    auto field = item.is_object() ? item.find("section") : item.end();
+    std::string section = field != item.end() && field->is_string() ? field->get<std::string>() : std::string();
+    if (section.empty())
+        return configurationSections.empty() ? json() : configurationSections;
+
+    const json *node = &configurationSections;
+    size_t start = 0;
+    while (true)
+    {
+        size_t dot = section.find('.', start);
+        auto child = node->find(section.substr(start, dot - start));
+        if (child == node->end())
+            return json();
+        node = &*child;
+        if (dot == std::string::npos)
+            return *node;
+        if (!node->is_object())
+            return json();
+        start = dot + 1;
+    }
+}
+
+RequestID LSPClientCore::nextRequestId(string_ref method)
+{
+    // Ids stay readable in logs but are unique, so every response can be matched to its request
+    return method.str() + "#" + std::to_string(++lastRequestId);
+}
+
+LSPClientCore::ResponseCallback LSPClientCore::requestFinished(const std::string &id, bool failed)
+{
+    ResponseCallback callback;
+    auto pending = pendingRequests.find(id);
+    if (pending != pendingRequests.end())
+    {
+        uint64_t latency = micros(Clock::now() - pending->second.sentAt);
+        metricsRecorder.requestAnswered(pending->second.method, latency, failed);
+        callback = std::move(pending->second.callback);
+        pendingBytes -= pending->second.accounted;
+        pendingRequests.erase(pending);
+    }
+    else
+    {
+        metricsRecorder.replyDiscarded();
+    }
+    scheduler.completed(id);
+    writeScheduled();
+    updateCongestion();
+    return callback;
+}
+
+void LSPClientCore::failPendingRequests(const std::string &message)
+{
+    std::vector<ResponseCallback> callbacks;
+    for (auto &pending : pendingRequests)
+    {
+        if (pending.second.callback)
+            callbacks.push_back(std::move(pending.second.callback));
+        if (spanTracer)
+            spanTracer->end(pending.first, Clock::now(), "failed");
+    }
+    pendingRequests.clear();
+    pendingBytes = 0;
+
+    json error = {{"code", ErrorCode::RequestCancelled}, {"message", message}};
+    for (auto &callback : callbacks)
+        callback(json(), &error);
+}
+
+bool LSPClientCore::isOverLimit() const
+{
+    if (limits.maxInFlight > 0 && static_cast<int>(scheduler.inFlightCount()) >= limits.maxInFlight)
+        return true;
+    return limits.maxQueuedBytes > 0 && queuedBytes() >= limits.maxQueuedBytes;
+}
+
+void LSPClientCore::updateCongestion()
+{
+    if (!congested && isOverLimit())
+    {
+        congested = true;
+        listener->congestionChanged(true);
+    }
+    else if (congested)
+    {
+        // Hysteresis, so the UI doesn't flicker between the two states on every reply
+        int inFlight = static_cast<int>(scheduler.inFlightCount());
+        bool inFlightLow = limits.maxInFlight <= 0 || inFlight <= limits.maxInFlight / 2;
+        bool bytesLow = limits.maxQueuedBytes <= 0 || queuedBytes() <= limits.maxQueuedBytes / 2;
+        if (inFlightLow && bytesLow)
+        {
+            congested = false;
+            listener->congestionChanged(false);
+        }
+    }
+}
+
+void LSPClientCore::writeScheduled()
+{
+    if (!scheduler.hasQueued())
+        return;
+    std::vector<RequestScheduler::Message> ready;
+    scheduler.takeReady(ready);
+    for (auto &message : ready)
+    {
+        if (spanTracer)
+            spanTracer->stage(message.id, "queue", message.enqueued, Clock::now());
+        writeRequest(message.id, message.payload);
+    }
+}
+
+void LSPClientCore::writeToServer(const std::string &content)
+{
+    metricsRecorder.messageOut(content.size());
+    if (trace)
+        trace->record(TraceDirection::ToServer, content);
+    if (transport.isOpen() && writeToServerBuffer.empty())
+    {
+        transport.write(MessageFramer::frame(content));
+        return;
+    }
+    writeToServerBuffer.push_back(MessageFramer::frame(content));
+    writeBufferBytes += static_cast<int64_t>(writeToServerBuffer.back().size());
+}
+
+void LSPClientCore::writeRequest(const RequestID &id, const std::string &content)
+{
+    if (!spanTracer)
+    {
+        writeToServer(content);
+        return;
+    }
+    auto start = Clock::now();
+    writeToServer(content);
+    auto written = Clock::now();
+    spanTracer->stage(id, "write", start, written);
+    auto pending = pendingRequests.find(id);
+    if (pending != pendingRequests.end())
+        pending->second.writtenAt = written;
+}
+
+void LSPClientCore::replySpans(const std::string &id, Clock::time_point decodeStart, Clock::time_point decodeEnd)
+{
+    auto pending = pendingRequests.find(id);
+    if (pending == pendingRequests.end() || pending->second.writtenAt == Clock::time_point())
+        return;
+    // Written before the server was running, or spans were enabled in the middle of the reply
+    Clock::time_point firstByte = std::max(readStart, pending->second.writtenAt);
+    spanTracer->stage(id, "server", pending->second.writtenAt, firstByte);
+    spanTracer->stage(id, "read", firstByte, decodeStart);
+    spanTracer->stage(id, "decode", decodeStart, decodeEnd);
+}
+
+void LSPClientCore::flushWriteBuffer()
+{
+    for (auto &s : writeToServerBuffer)
+        transport.write(s);
+    writeToServerBuffer.clear();
+    writeBufferBytes = 0;
+}
+
+void LSPClientCore::deliverStderr()
+{
+    if (!stderrLines.hasPending())
+        return;
+    uint64_t skipped = stderrLines.takeBatch(stderrBatch);
+    listener->serverLog(stderrBatch, skipped);
+}
+
+void LSPClientCore::accountRequest(const RequestID &id, PendingRequest &pending)
+{
+    size_t bytes = nodeBytes<std::pair<const RequestID, PendingRequest>>() + heapBytes(id) +
+                   heapBytes(pending.method) + heapBytes(pending.payload) + heapBytes(pending.cacheKey);
+    pendingBytes += bytes - pending.accounted;
+    pending.accounted = bytes;
+}
+
+void LSPClientCore::accountDocument(const std::string &uri, TrackedDocument &document)
+{
+    size_t bytes = nodeBytes<std::pair<const std::string, TrackedDocument>>() + heapBytes(uri) +
+                   heapBytes(document.languageId) + heapBytes(document.text);
+    documentBytes += bytes - document.accounted;
+    document.accounted = bytes;
+}
+
+void LSPClientCore::enforceMemoryBudget()
+{
+    if (budget == 0)
+        return;
+    MemoryUsage usage = memoryUsage();
+    size_t total = usage.total();
+    if (total <= budget)
+        return;
+
+    // Largest first, the fewest caches lose their contents
+    std::vector<size_t> order;
+    for (size_t index = 0; index < usage.caches.size(); ++index)
+        order.push_back(index);
+    std::sort(order.begin(), order.end(),
+              [&usage](size_t lhs, size_t rhs) { return usage.caches[lhs].bytes > usage.caches[rhs].bytes; });
+
+    size_t firstCache = spanTracer ? 1 : 0;
+    for (size_t index : order)
+    {
+        size_t held = usage.caches[index].bytes;
+        if (total <= budget || held == 0)
+            break;
+        size_t wanted = std::min(held, total - budget);
+        size_t freed = 0;
+        if (index < firstCache)
+        {
+            freed = spanTracer->evict(wanted);
+        }
+        else
+        {
+            MemoryCache &cache = memoryCaches[index - firstCache];
+            cache.evict(wanted);
+            freed = held - std::min(held, cache.usage());
+        }
+        if (freed > 0)
+            ++evictions;
+        total -= std::min(total, freed);
+    }
+}
+
+void LSPClientCore::notify(string_ref method, json value)
+{
+    // Document state is tracked and replayed as a whole once the new server is up; changes made
+    // after the replay was written go to the new server like any other
+    if (replayPending && (method == "textDocument/didOpen" || method == "textDocument/didChange" ||
+                       method == "textDocument/didClose" || method == "workspace/didChangeConfiguration"))
+        return;
+    json payload = {{"jsonrpc", "2.0"}, {"method", method}, {"params", value}};
+    std::string content = payload.dump();
+    writeToServer(content);
+}
+
+SendStatus LSPClientCore::request(string_ref method, json param, RequestID id)
+{
+    PendingRequest &pending = pendingRequests[id];
+    pending.method = method.str();
+    pending.sentAt = Clock::now();
+    metricsRecorder.requestSent(pending.method);
+    json rpc = {{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", param}};
+    std::string content = rpc.dump();
+    if (spanTracer)
+    {
+        spanTracer->begin(id, pending.method, pending.sentAt);
+        spanTracer->stage(id, "serialize", pending.sentAt, Clock::now());
+    }
+    if (restart.enabled)
+        pending.payload = content;
+    accountRequest(id, pending);
+    if (method == "initialize" || method == "shutdown")
+    {
+        // Lifecycle requests are never held back
+        writeRequest(id, content);
+        return sendStatus = SendStatus::Sent;
+    }
+
+    if (isOverLimit())
+    {
+        if (limits.policy == OverflowPolicy::Reject)
+        {
+            pendingBytes -= pending.accounted;
+            pendingRequests.erase(id);
+            metricsRecorder.requestRejected(method.str());
+            if (spanTracer)
+                spanTracer->end(id, Clock::now(), "rejected");
+            updateCongestion();
+            return sendStatus = SendStatus::Rejected;
+        }
+        if (limits.policy == OverflowPolicy::DropOldestSuperseded)
+        {
+            std::string dropped = scheduler.dropOldest(method.str());
+            if (!dropped.empty())
+            {
+                PendingRequest &superseded = pendingRequests[dropped];
+                ResponseCallback callback = std::move(superseded.callback);
+                pendingBytes -= superseded.accounted;
+                pendingRequests.erase(dropped);
+                metricsRecorder.requestSuperseded(method.str());
+                if (spanTracer)
+                    spanTracer->end(dropped, Clock::now(), "superseded");
+                if (callback)
+                {
+                    json error = {{"code", ErrorCode::RequestCancelled}, {"message", "Superseded by a newer request"}};
+                    callback(json(), &error);
+                }
+                listener->requestDropped(dropped, method.str());
+            }
+        }
+    }
+
+    RequestPriority priority = RequestPriority::Interactive;
+    auto configured = methodPriorities.find(method.str());
+    if (priorityOverride.has())
+        priority = priorityOverride.value();
+    else if (configured != methodPriorities.end())
+        priority = configured->second;
+    pending.priority = priority;
+    scheduler.submit(priority, id, method.str(), std::move(content));
+    writeScheduled();
+    updateCongestion();
+    enforceMemoryBudget();
+    return sendStatus = scheduler.isInFlight(id) ? SendStatus::Sent : SendStatus::Queued;
+}
+
+bool LSPClientCore::scheduleRestart()
+{
+    if (!restart.enabled || stopRequested || !hasInitialized)
+        return false;
+    auto now = Clock::now();
+    if (!recovering)
+    {
+        crashedAt = now;
+        // A server that ran fine for a while starts over with the shortest delay
+        if (recovery.restarts > 0 && now - recoveredAt >= std::chrono::milliseconds(restart.stableMsec))
+            restartAttempts = 0;
+    }
+    if (restartAttempts >= restart.maxAttempts)
+        return false;
+
+    int delay = restart.initialDelayMsec;
+    for (int i = 0; i < restartAttempts && delay < restart.maxDelayMsec; ++i)
+        delay *= 2;
+    delay = std::min(delay, restart.maxDelayMsec);
+    if (!transport.restart(delay))
+        return false;
+
+    // Requests without a reply either go to the new server or fail now. A server that dies
+    // while recovering leaves retried requests, requests sent since the replay and the
+    // replay's own initialize, which nobody waits for.
+    if (recovering)
+    {
+        auto stale = pendingRequests.find(initializeId);
+        if (stale != pendingRequests.end())
+        {
+            pendingBytes -= stale->second.accounted;
+            pendingRequests.erase(stale);
+        }
+    }
+    std::vector<std::pair<RequestID, RequestPriority>> retry;
+    std::vector<ResponseCallback> failed;
+    for (auto it = pendingRequests.begin(); it != pendingRequests.end();)
+    {
+        if (!it->second.payload.empty() && shouldRetry(it->second.method))
+        {
+            retry.emplace_back(it->first, it->second.priority);
+            ++it;
+            continue;
+        }
+        if (it->second.callback)
+            failed.push_back(std::move(it->second.callback));
+        if (spanTracer)
+            spanTracer->end(it->first, now, "failed");
+        ++recovery.requestsFailed;
+        pendingBytes -= it->second.accounted;
+        it = pendingRequests.erase(it);
+    }
+    // Oldest first, ids count up
+    std::sort(retry.begin(), retry.end(), [](const std::pair<RequestID, RequestPriority> &lhs,
+                                             const std::pair<RequestID, RequestPriority> &rhs) {
+        auto number = [](const RequestID &id) { return std::stoull(id.substr(id.rfind('#') + 1)); };
+        return number(lhs.first) < number(rhs.first);
+    });
+    retryRequests.clear();
+    for (auto &request : retry)
+        retryRequests.push_back(request.first);
+    scheduler.clear();
+    writeToServerBuffer.clear();
+    writeBufferBytes = 0;
+    recovering = true;
+    replayPending = true;
+
+    json error = {{"code", ErrorCode::RequestCancelled}, {"message", "The server crashed"}};
+    for (auto &callback : failed)
+        callback(json(), &error);
+    ++restartAttempts;
+    listener->serverRestarting(restartAttempts, delay);
+    return true;
+}
+
+void LSPClientCore::replayState()
+{
+    replayPending = false;
+    ++recovery.restarts;
+    diagnosticPulls.forgetResults();
+
+    // One write for everything, the server processes it in order without a round trip in between
+    std::string burst;
+    auto append = [this, &burst](const json &message) {
+        std::string content = message.dump();
+        metricsRecorder.messageOut(content.size());
+        if (trace)
+            trace->record(TraceDirection::ToServer, content);
+        burst += MessageFramer::frame(content);
+    };
+
+    initializeId = nextRequestId("initialize");
+    PendingRequest &initializeRequest = pendingRequests[initializeId];
+    initializeRequest.method = "initialize";
+    initializeRequest.sentAt = Clock::now();
+    accountRequest(initializeId, initializeRequest);
+    append({{"jsonrpc", "2.0"}, {"id", initializeId}, {"method", "initialize"}, {"params", initializeParams}});
+    append({{"jsonrpc", "2.0"}, {"method", "initialized"}, {"params", json()}});
+    if (configuration.has())
+    {
+        DidChangeConfigurationParams params;
+        params.settings = configuration.value();
+        append({{"jsonrpc", "2.0"}, {"method", "workspace/didChangeConfiguration"}, {"params", params}});
+    }
+
+    recovery.documentsReplayed = 0;
+    for (auto &entry : documents)
+    {
+        const TrackedDocument &document = entry.second;
+        if (!document.textKnown)
+            continue;
+        DidOpenTextDocumentParams params;
+        params.textDocument.uri = entry.first;
+        params.textDocument.languageId = document.languageId;
+        params.textDocument.version = document.version;
+        params.textDocument.text = document.text;
+        append({{"jsonrpc", "2.0"}, {"method", "textDocument/didOpen"}, {"params", params}});
+        ++recovery.documentsReplayed;
+    }
+    recovery.lastReplayBytes = burst.size();
+    transport.write(burst);
+
+    // Retried requests go through the scheduler again, behind the replayed state
+    for (auto &id : retryRequests)
+    {
+        auto pending = pendingRequests.find(id);
+        if (pending == pendingRequests.end())
+            continue;
+        scheduler.submit(pending->second.priority, id, pending->second.method, pending->second.payload);
+        ++recovery.requestsRetried;
+    }
+    retryRequests.clear();
+    writeScheduled();
+    // Requests sent while the server was down
+    flushWriteBuffer();
+    updateCongestion();
+}
+
+bool LSPClientCore::shouldRetry(const std::string &method) const
+{
+    if (method == "initialize" || method == "shutdown")
+        return false;
+    auto configured = retryOnRestart.find(method);
+    return configured == retryOnRestart.end() || configured->second;
+}
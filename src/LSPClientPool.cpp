@@ -0,0 +1,247 @@
+#include <LSPClientPool.hpp>
+#include <QPointer>
+#include <algorithm>
+
+namespace
+{
+// Time a server gets to answer shutdown/exit before it is killed
+const int killTimeout = 3000;
+} // namespace
+
+LSPClientPool::LSPClientPool(QObject *parent) : QObject(parent)
+{
+    clock.start();
+    connect(&idleTimer, &QTimer::timeout, this, &LSPClientPool::onIdleCheck);
+    setIdleTimeout(idleTimeout);
+}
+
+LSPClientPool::~LSPClientPool() = default;
+
+void LSPClientPool::setServer(const std::string &languageId, LanguageServerConfig config)
+{
+    servers[languageId] = std::move(config);
+    prewarm(languageId);
+}
+
+void LSPClientPool::setShardKey(ShardKeyFunction function)
+{
+    shardKey = std::move(function);
+}
+
+void LSPClientPool::setIdleTimeout(int msec)
+{
+    idleTimeout = msec;
+    if (idleTimeout < 0)
+    {
+        idleTimer.stop();
+        return;
+    }
+    idleTimer.start(std::max(1000, idleTimeout / 4));
+}
+
+LSPClient *LSPClientPool::didOpen(DocumentUri uri, string_ref code, string_ref languageId)
+{
+    std::string key = uri.str();
+    auto open = documents.find(key);
+    if (open != documents.end())
+        return open->second->client.get();
+
+    Instance *instance = route(key, languageId.str());
+    if (instance == nullptr)
+        return nullptr;
+    documents[key] = instance;
+    ++instance->openDocuments;
+    instance->client->didOpen(uri, code, languageId);
+    return instance->client.get();
+}
+
+void LSPClientPool::didClose(DocumentUri uri)
+{
+    auto open = documents.find(uri.str());
+    if (open == documents.end())
+        return;
+    Instance *instance = open->second;
+    documents.erase(open);
+    instance->client->didClose(uri);
+    if (--instance->openDocuments == 0)
+        instance->idleSince = clock.elapsed();
+}
+
+LSPClient *LSPClientPool::clientFor(const std::string &uri) const
+{
+    auto open = documents.find(uri);
+    return open == documents.end() ? nullptr : open->second->client.get();
+}
+
+int LSPClientPool::instanceCount(const std::string &languageId) const
+{
+    return static_cast<int>(std::count_if(instances.begin(), instances.end(), [&](const std::unique_ptr<Instance> &i) {
+        return !i->stopping && (languageId.empty() || i->languageId == languageId);
+    }));
+}
+
+void LSPClientPool::shutdownIdle()
+{
+    std::vector<Instance *> idle;
+    for (auto &instance : instances)
+    {
+        if (!instance->stopping && !instance->standby && instance->openDocuments == 0)
+            idle.push_back(instance.get());
+    }
+    stop(idle);
+}
+
+void LSPClientPool::shutdownAll()
+{
+    std::vector<Instance *> all;
+    for (auto &instance : instances)
+    {
+        if (!instance->stopping)
+            all.push_back(instance.get());
+    }
+    documents.clear();
+    stop(all);
+}
+
+// slots
+
+void LSPClientPool::onIdleCheck()
+{
+    if (idleTimeout < 0)
+        return;
+    qint64 now = clock.elapsed();
+    std::vector<Instance *> idle;
+    for (auto &instance : instances)
+    {
+        if (!instance->stopping && !instance->standby && instance->openDocuments == 0 &&
+            now - instance->idleSince >= idleTimeout)
+            idle.push_back(instance.get());
+    }
+    stop(idle);
+}
+
+// private
+
+LSPClientPool::Instance *LSPClientPool::route(const std::string &uri, const std::string &languageId)
+{
+    auto server = servers.find(languageId);
+    if (server == servers.end())
+        return nullptr;
+
+    std::string key = shardKey ? shardKey(uri) : std::string();
+    auto lessLoaded = [](const Instance *lhs, const Instance *rhs) {
+        int lhsLoad = lhs->client->inFlightRequests(), rhsLoad = rhs->client->inFlightRequests();
+        return lhsLoad != rhsLoad ? lhsLoad < rhsLoad : lhs->openDocuments < rhs->openDocuments;
+    };
+
+    Instance *sameShard = nullptr, *leastLoaded = nullptr, *standby = nullptr;
+    int running = 0;
+    for (auto &instance : instances)
+    {
+        if (instance->stopping || instance->languageId != languageId)
+            continue;
+        ++running;
+        if (instance->standby)
+        {
+            standby = instance.get();
+            continue;
+        }
+        if (instance->shardKey == key && (sameShard == nullptr || lessLoaded(instance.get(), sameShard)))
+            sameShard = instance.get();
+        if (leastLoaded == nullptr || lessLoaded(instance.get(), leastLoaded))
+            leastLoaded = instance.get();
+    }
+    if (sameShard != nullptr)
+        return sameShard;
+    if (standby != nullptr)
+    {
+        // The standby has been spawned and initialized already, it only has to take the shard over
+        standby->standby = false;
+        standby->shardKey = key;
+        prewarm(languageId);
+        return standby;
+    }
+    if (running < std::max(1, server->second.maxInstances))
+        return start(languageId, key);
+    return leastLoaded;
+}
+
+void LSPClientPool::prewarm(const std::string &languageId)
+{
+    auto server = servers.find(languageId);
+    if (server == servers.end() || !server->second.prewarm)
+        return;
+    int running = 0;
+    for (auto &instance : instances)
+    {
+        if (instance->stopping || instance->languageId != languageId)
+            continue;
+        if (instance->standby)
+            return;
+        ++running;
+    }
+    if (running < std::max(1, server->second.maxInstances))
+        start(languageId, std::string(), true);
+}
+
+LSPClientPool::Instance *LSPClientPool::start(const std::string &languageId, const std::string &key, bool standby)
+{
+    const LanguageServerConfig &config = servers[languageId];
+    std::unique_ptr<Instance> instance(new Instance);
+    instance->languageId = languageId;
+    instance->shardKey = key;
+    instance->standby = standby;
+    instance->idleSince = clock.elapsed();
+    instance->client.reset(new LSPClient(config.program, config.arguments));
+
+    LSPClient *client = instance->client.get();
+    connect(client, &LSPClient::onServerFinished, this, [this, client] { release(client); });
+
+    // The first didOpen is pipelined right behind initialize/initialized
+    option<DocumentUri> rootUri;
+    if (instance->shardKey.compare(0, 7, "file://") == 0)
+        rootUri = DocumentUri(instance->shardKey);
+    client->prewarm(rootUri);
+
+    instances.push_back(std::move(instance));
+    emit clientStarted(client, QString::fromStdString(languageId), QString::fromStdString(key));
+    return instances.back().get();
+}
+
+void LSPClientPool::stop(const std::vector<Instance *> &stopping)
+{
+    // Every server gets its shutdown/exit before we wait on any of them
+    for (auto instance : stopping)
+    {
+        instance->stopping = true;
+        instance->client->shutdown();
+        instance->client->exit();
+    }
+    for (auto instance : stopping)
+    {
+        // The client may be released and deleted before the timer fires, and a new one allocated at its address
+        QPointer<LSPClient> client = instance->client.get();
+        QTimer::singleShot(killTimeout, this, [this, client] {
+            if (client)
+                release(client);
+        });
+    }
+}
+
+void LSPClientPool::release(LSPClient *client)
+{
+    auto it = std::find_if(instances.begin(), instances.end(),
+                           [client](const std::unique_ptr<Instance> &i) { return i->client.get() == client; });
+    if (it == instances.end())
+        return;
+
+    for (auto doc = documents.begin(); doc != documents.end();)
+        doc = doc->second == it->get() ? documents.erase(doc) : std::next(doc);
+
+    std::unique_ptr<Instance> instance = std::move(*it);
+    instances.erase(it);
+    emit clientStopped(client, QString::fromStdString(instance->languageId),
+                       QString::fromStdString(instance->shardKey));
+    // May be called from one of the client's own signals, so don't delete it right away
+    instance->client.release()->deleteLater();
+}
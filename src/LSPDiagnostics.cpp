@@ -0,0 +1,170 @@
+#include <LSPDiagnostics.hpp>
+#include <algorithm>
+
+DiagnosticPuller::DiagnosticPuller(DiagnosticPullOptions options) : settings(options)
+{
+}
+
+void DiagnosticPuller::setOptions(DiagnosticPullOptions options)
+{
+    settings = options;
+}
+
+void DiagnosticPuller::opened(const std::string &uri, Clock::time_point now)
+{
+    Document &document = documents[uri];
+    document.open = true;
+    ++document.change;
+    document.editedAt = now;
+}
+
+void DiagnosticPuller::edited(const std::string &uri, Clock::time_point now)
+{
+    auto document = documents.find(uri);
+    if (document == documents.end() || !document->second.open)
+        return;
+    ++document->second.change;
+    document->second.editedAt = now;
+}
+
+void DiagnosticPuller::closed(const std::string &uri)
+{
+    auto document = documents.find(uri);
+    if (document == documents.end())
+        return;
+    if (document->second.resultId.empty() && document->second.pulling == 0)
+    {
+        documents.erase(document);
+        return;
+    }
+    document->second.open = false;
+    document->second.visible = false;
+}
+
+void DiagnosticPuller::setVisible(const std::string &uri, bool visible)
+{
+    auto document = documents.find(uri);
+    if (document != documents.end() && document->second.open)
+        document->second.visible = visible;
+}
+
+bool DiagnosticPuller::isVisible(const std::string &uri) const
+{
+    auto document = documents.find(uri);
+    return document != documents.end() && document->second.visible;
+}
+
+std::vector<std::string> DiagnosticPuller::due(Clock::time_point now) const
+{
+    std::vector<std::pair<const std::string *, const Document *>> candidates;
+    auto recent = std::chrono::milliseconds(settings.recentEditMsec);
+    for (auto &entry : documents)
+    {
+        const Document &document = entry.second;
+        if (!document.open || document.pulling > 0 || document.reportedChange >= document.change)
+            continue;
+        if (document.visible || now - document.editedAt < recent)
+            candidates.emplace_back(&entry.first, &document);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::pair<const std::string *, const Document *> &lhs,
+                 const std::pair<const std::string *, const Document *> &rhs) {
+                  if (lhs.second->visible != rhs.second->visible)
+                      return lhs.second->visible;
+                  return lhs.second->editedAt > rhs.second->editedAt;
+              });
+
+    std::vector<std::string> uris;
+    uris.reserve(candidates.size());
+    for (auto &candidate : candidates)
+        uris.push_back(*candidate.first);
+    return uris;
+}
+
+uint64_t DiagnosticPuller::started(const std::string &uri, std::string &previousResultId)
+{
+    Document &document = documents[uri];
+    ++document.pulling;
+    previousResultId = document.resultId;
+    return document.change;
+}
+
+void DiagnosticPuller::reported(const std::string &uri, const std::string &resultId, uint64_t change)
+{
+    auto document = documents.find(uri);
+    if (document == documents.end())
+        return;
+    document->second.pulling = std::max(document->second.pulling - 1, 0);
+    document->second.resultId = resultId;
+    document->second.reportedChange = std::max(document->second.reportedChange, change);
+}
+
+void DiagnosticPuller::failed(const std::string &uri)
+{
+    auto document = documents.find(uri);
+    if (document != documents.end())
+        document->second.pulling = std::max(document->second.pulling - 1, 0);
+}
+
+void DiagnosticPuller::remember(const std::string &uri, const std::string &resultId)
+{
+    // Not counted as up to date: the report may be older than the last edit
+    documents[uri].resultId = resultId;
+}
+
+void DiagnosticPuller::refresh()
+{
+    for (auto &entry : documents)
+        ++entry.second.change;
+}
+
+void DiagnosticPuller::forgetResults()
+{
+    for (auto it = documents.begin(); it != documents.end();)
+    {
+        Document &document = it->second;
+        if (!document.open)
+        {
+            it = documents.erase(it);
+            continue;
+        }
+        document.resultId.clear();
+        ++document.change;
+        ++it;
+    }
+}
+
+void DiagnosticPuller::clear()
+{
+    documents.clear();
+}
+
+std::string DiagnosticPuller::resultId(const std::string &uri) const
+{
+    auto document = documents.find(uri);
+    return document != documents.end() ? document->second.resultId : std::string();
+}
+
+std::vector<PreviousResultId> DiagnosticPuller::previousResultIds() const
+{
+    std::vector<PreviousResultId> results;
+    for (auto &entry : documents)
+    {
+        if (entry.second.resultId.empty())
+            continue;
+        PreviousResultId previous;
+        previous.uri = entry.first;
+        previous.value = entry.second.resultId;
+        results.push_back(std::move(previous));
+    }
+    return results;
+}
+
+size_t DiagnosticPuller::memoryUsage() const
+{
+    // A node holds the entry and a next pointer, plus a pointer in the bucket array
+    size_t bytes = documents.bucket_count() * sizeof(void *);
+    for (auto &entry : documents)
+        bytes += sizeof(entry) + sizeof(void *) + entry.first.capacity() + entry.second.resultId.capacity();
+    return bytes;
+}
@@ -0,0 +1,271 @@
+#include <LSPEdits.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "MappedFile.hpp"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+
+struct ResolvedEdit
+{
+    size_t begin = 0;
+    size_t end = 0;
+    const std::string *newText = nullptr;
+};
+
+// Walks the document forward line by line, so resolving sorted positions is linear in the document size.
+class LineCursor
+{
+  public:
+    LineCursor(const char *data, size_t size) : data(data), size(size)
+    {
+    }
+
+    size_t offsetOf(Position pos, OffsetEncoding encoding)
+    {
+        if (pos.line < line)
+            rewind();
+        while (line < pos.line && lineStart < size)
+        {
+            const void *newline = memchr(data + lineStart, '\n', size - lineStart);
+            lineStart = newline == nullptr ? size : static_cast<const char *>(newline) - data + 1;
+            ++line;
+        }
+        if (line < pos.line)
+            return size;
+
+        size_t lineEnd = lineStart;
+        const void *newline = memchr(data + lineStart, '\n', size - lineStart);
+        lineEnd = newline == nullptr ? size : static_cast<const char *>(newline) - data;
+        if (lineEnd > lineStart && data[lineEnd - 1] == '\r')
+            --lineEnd;
+
+        size_t character = pos.character < 0 ? 0 : static_cast<size_t>(pos.character);
+        if (encoding == OffsetEncoding::UTF8)
+            return lineStart + std::min(character, lineEnd - lineStart);
+
+        size_t offset = lineStart;
+        while (offset < lineEnd && character > 0)
+        {
+            auto lead = static_cast<unsigned char>(data[offset]);
+            size_t length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+            size_t units = (length == 4 && encoding == OffsetEncoding::UTF16) ? 2 : 1;
+            if (units > character)
+                break;
+            character -= units;
+            offset = std::min(offset + length, lineEnd);
+        }
+        return offset;
+    }
+
+  private:
+    const char *data;
+    size_t size;
+    int line = 0;
+    size_t lineStart = 0;
+
+    void rewind()
+    {
+        line = 0;
+        lineStart = 0;
+    }
+};
+
+bool resolveEdits(const char *data, size_t size, const std::vector<TextEdit> &edits, OffsetEncoding encoding,
+                  std::vector<ResolvedEdit> &resolved, std::string &error)
+{
+    std::vector<const TextEdit *> sorted;
+    sorted.reserve(edits.size());
+    for (auto &edit : edits)
+    {
+        if (edit.range.end < edit.range.start)
+        {
+            error = "Edit range end is before its start";
+            return false;
+        }
+        sorted.push_back(&edit);
+    }
+    // Inserts at the same position must keep the order the server sent them in.
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const TextEdit *lhs, const TextEdit *rhs) { return lhs->range.start < rhs->range.start; });
+
+    LineCursor starts(data, size);
+    resolved.clear();
+    resolved.reserve(sorted.size());
+    for (auto edit : sorted)
+    {
+        ResolvedEdit r;
+        r.begin = starts.offsetOf(edit->range.start, encoding);
+        LineCursor ends = starts;
+        r.end = ends.offsetOf(edit->range.end, encoding);
+        r.newText = &edit->newText;
+        if (!resolved.empty() && r.begin < resolved.back().end)
+        {
+            error = "Overlapping edits at line " + std::to_string(edit->range.start.line);
+            return false;
+        }
+        resolved.push_back(r);
+    }
+    return true;
+}
+
+template <typename Sink> void rebuild(const char *data, size_t size, const std::vector<ResolvedEdit> &edits, Sink &&sink)
+{
+    size_t copied = 0;
+    for (auto &edit : edits)
+    {
+        sink(data + copied, edit.begin - copied);
+        sink(edit.newText->data(), edit.newText->size());
+        copied = edit.end;
+    }
+    sink(data + copied, size - copied);
+}
+
+struct PendingDocument
+{
+    DocumentEditResult *result = nullptr;
+    OpenDocument *document = nullptr;
+    std::string newText;
+    std::string path;
+    std::string tempPath;
+};
+
+} // namespace
+
+bool applyTextEdits(std::string &text, std::vector<TextEdit> edits, std::string *error, OffsetEncoding encoding)
+{
+    std::vector<ResolvedEdit> resolved;
+    std::string reason;
+    if (!resolveEdits(text.data(), text.size(), edits, encoding, resolved, reason))
+    {
+        if (error != nullptr)
+            *error = reason;
+        return false;
+    }
+    size_t newSize = text.size();
+    for (auto &edit : resolved)
+        newSize = newSize - (edit.end - edit.begin) + edit.newText->size();
+
+    std::string result;
+    result.reserve(newSize);
+    rebuild(text.data(), text.size(), resolved, [&result](const char *data, size_t size) { result.append(data, size); });
+    text.swap(result);
+    return true;
+}
+
+WorkspaceEditApplier::WorkspaceEditApplier(DocumentLookup lookup, OffsetEncoding encoding)
+    : lookup(std::move(lookup)), encoding(encoding)
+{
+}
+
+WorkspaceEditResult WorkspaceEditApplier::apply(const WorkspaceEdit &edit)
+{
+    if (!edit.changes.has())
+    {
+        WorkspaceEditResult result;
+        result.applied = true;
+        return result;
+    }
+    return apply(edit.changes.value());
+}
+
+WorkspaceEditResult WorkspaceEditApplier::apply(const std::map<std::string, std::vector<TextEdit>> &changes)
+{
+    WorkspaceEditResult result;
+    result.documents.resize(changes.size());
+    std::vector<PendingDocument> pending(changes.size());
+    std::vector<ResolvedEdit> resolved;
+
+    auto fail = [&](DocumentEditResult &document, std::string reason) {
+        for (auto &p : pending)
+        {
+            if (!p.tempPath.empty())
+                std::remove(p.tempPath.c_str());
+        }
+        result.failureReason = document.uri + ": " + reason;
+        document.failureReason = std::move(reason);
+        return result;
+    };
+
+    // Validate and build every document first, so a bad edit leaves the workspace untouched.
+    size_t index = 0;
+    for (auto &change : changes)
+    {
+        auto &document = result.documents[index];
+        auto &p = pending[index++];
+        document.uri = change.first;
+        p.result = &document;
+        p.document = lookup ? lookup(change.first) : nullptr;
+
+        std::string reason;
+        if (p.document != nullptr)
+        {
+            p.newText = p.document->text;
+            if (!applyTextEdits(p.newText, change.second, &reason, encoding))
+                return fail(document, reason);
+            document.oldVersion = p.document->version;
+            document.newVersion = p.document->version + 1;
+            continue;
+        }
+
+        p.path = URIForFile::UriToPath(change.first);
+        if (p.path.empty())
+            return fail(document, "Only file:// uris can be edited on disk");
+        MappedFile file(p.path);
+        if (!file.ok)
+            return fail(document, "Cannot read " + p.path);
+        if (!resolveEdits(file.data, file.size, change.second, encoding, resolved, reason))
+            return fail(document, reason);
+
+        p.tempPath = p.path + ".lspedit.tmp";
+        FILE *out = std::fopen(p.tempPath.c_str(), "wb");
+        if (out == nullptr)
+        {
+            p.tempPath.clear();
+            return fail(document, "Cannot write next to " + p.path);
+        }
+        bool written = true;
+        rebuild(file.data, file.size, resolved, [out, &written](const char *data, size_t size) {
+            if (size > 0 && std::fwrite(data, 1, size, out) != size)
+                written = false;
+        });
+        written = std::fclose(out) == 0 && written;
+#ifndef _WIN32
+        ::chmod(p.tempPath.c_str(), file.mode);
+#endif
+        if (!written)
+            return fail(document, "Cannot write next to " + p.path);
+    }
+
+    // Commit
+    for (auto &p : pending)
+    {
+        if (p.document != nullptr)
+        {
+            p.document->text.swap(p.newText);
+            p.document->version = p.result->newVersion;
+        }
+        else
+        {
+#ifdef _WIN32
+            std::remove(p.path.c_str());
+#endif
+            if (std::rename(p.tempPath.c_str(), p.path.c_str()) != 0)
+            {
+                std::remove(p.tempPath.c_str());
+                p.result->failureReason = "Cannot replace " + p.path;
+                result.failureReason = p.result->uri + ": " + p.result->failureReason;
+                continue;
+            }
+        }
+        p.result->applied = true;
+    }
+    result.applied = result.failureReason.empty();
+    return result;
+}
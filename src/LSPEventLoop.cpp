@@ -0,0 +1,165 @@
+#include <LSPEventLoop.hpp>
+#include <algorithm>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace
+{
+uint64_t packEvent(int fd, uint32_t generation)
+{
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+} // namespace
+
+LSPEventLoop::LSPEventLoop()
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd >= 0 && wakeFd >= 0)
+    {
+        watch(wakeFd, EPOLLIN, [this](uint32_t) {
+            uint64_t count;
+            while (::read(wakeFd, &count, sizeof(count)) > 0)
+            {
+            }
+            runPosted();
+        });
+    }
+}
+
+LSPEventLoop::~LSPEventLoop()
+{
+    if (wakeFd >= 0)
+        ::close(wakeFd);
+    if (epollFd >= 0)
+        ::close(epollFd);
+}
+
+bool LSPEventLoop::watch(int fd, uint32_t events, IOCallback callback)
+{
+    uint32_t generation = ++nextGeneration;
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = packEvent(fd, generation);
+    bool known = watches.count(fd) != 0;
+    if (epoll_ctl(epollFd, known ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) != 0)
+        return false;
+    watches[fd] = Watch{generation, std::move(callback)};
+    return true;
+}
+
+bool LSPEventLoop::modify(int fd, uint32_t events)
+{
+    auto it = watches.find(fd);
+    if (it == watches.end())
+        return false;
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = packEvent(fd, it->second.generation);
+    return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void LSPEventLoop::unwatch(int fd)
+{
+    if (watches.erase(fd) != 0)
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+LSPEventLoop::TimerID LSPEventLoop::startTimer(int msec, Task task)
+{
+    TimerID id = ++lastTimerId;
+    auto due = Clock::now() + std::chrono::milliseconds(std::max(0, msec));
+    timerIndex[id] = timers.emplace(due, Timer{id, std::move(task)});
+    return id;
+}
+
+void LSPEventLoop::cancelTimer(TimerID id)
+{
+    auto it = timerIndex.find(id);
+    if (it == timerIndex.end())
+        return;
+    timers.erase(it->second);
+    timerIndex.erase(it);
+}
+
+void LSPEventLoop::post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        posted.push_back(std::move(task));
+    }
+    uint64_t one = 1;
+    ssize_t written = ::write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+int LSPEventLoop::run()
+{
+    running = true;
+    exitCode = 0;
+    while (running)
+        processEvents(-1);
+    return exitCode;
+}
+
+void LSPEventLoop::quit(int code)
+{
+    exitCode = code;
+    running = false;
+}
+
+void LSPEventLoop::processEvents(int timeoutMsec)
+{
+    epoll_event events[64];
+    int count = epoll_wait(epollFd, events, 64, nextTimeout(timeoutMsec));
+    for (int i = 0; i < count; ++i)
+    {
+        int fd = static_cast<int>(static_cast<uint32_t>(events[i].data.u64));
+        auto generation = static_cast<uint32_t>(events[i].data.u64 >> 32);
+        auto it = watches.find(fd);
+        // Unwatched (or closed and reused) by an earlier callback of this batch
+        if (it == watches.end() || it->second.generation != generation)
+            continue;
+        // The callback may unwatch itself, so it must not run out of the map
+        IOCallback callback = it->second.callback;
+        callback(events[i].events);
+    }
+    runTimers();
+}
+
+// private
+
+int LSPEventLoop::nextTimeout(int timeoutMsec) const
+{
+    if (timers.empty())
+        return timeoutMsec;
+    auto untilDue = std::chrono::duration_cast<std::chrono::milliseconds>(timers.begin()->first - Clock::now());
+    // Round up, so the loop doesn't spin for the last fraction of a millisecond
+    int msec = static_cast<int>(std::max<int64_t>(0, untilDue.count() + 1));
+    return timeoutMsec < 0 ? msec : std::min(msec, timeoutMsec);
+}
+
+void LSPEventLoop::runTimers()
+{
+    auto now = Clock::now();
+    while (!timers.empty() && timers.begin()->first <= now)
+    {
+        Task task = std::move(timers.begin()->second.task);
+        timerIndex.erase(timers.begin()->second.id);
+        timers.erase(timers.begin());
+        task();
+    }
+}
+
+void LSPEventLoop::runPosted()
+{
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        tasks.swap(posted);
+    }
+    for (auto &task : tasks)
+        task();
+}
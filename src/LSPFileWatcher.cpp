@@ -0,0 +1,422 @@
+#include <LSPFileWatcher.hpp>
+#include <algorithm>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <errno.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+// Expands the first {a,b} group of `pattern` and recurses into the result
+void expandBraces(const std::string &pattern, std::vector<std::string> &out)
+{
+    size_t open = pattern.find('{');
+    if (open == std::string::npos)
+    {
+        out.push_back(pattern);
+        return;
+    }
+    int depth = 0;
+    size_t close = open;
+    std::vector<size_t> commas;
+    for (size_t i = open; i < pattern.size(); ++i)
+    {
+        if (pattern[i] == '{')
+            ++depth;
+        else if (pattern[i] == '}' && --depth == 0)
+        {
+            close = i;
+            break;
+        }
+        else if (pattern[i] == ',' && depth == 1)
+            commas.push_back(i);
+    }
+    if (close == open)
+    {
+        // Unbalanced, match the brace literally
+        out.push_back(pattern);
+        return;
+    }
+    std::string prefix = pattern.substr(0, open), suffix = pattern.substr(close + 1);
+    size_t start = open + 1;
+    commas.push_back(close);
+    for (size_t comma : commas)
+    {
+        expandBraces(prefix + pattern.substr(start, comma - start) + suffix, out);
+        start = comma + 1;
+    }
+}
+
+bool matchClass(const char *&p, const char *pe, char ch)
+{
+    // p points just after '['
+    bool negate = p < pe && (*p == '!' || *p == '^');
+    if (negate)
+        ++p;
+    bool matched = false;
+    bool firstChar = true;
+    while (p < pe && (*p != ']' || firstChar))
+    {
+        char low = *p++;
+        char high = low;
+        if (p + 1 < pe && *p == '-' && p[1] != ']')
+        {
+            high = p[1];
+            p += 2;
+        }
+        if (low <= ch && ch <= high)
+            matched = true;
+        firstChar = false;
+    }
+    if (p < pe)
+        ++p; // ']'
+    return matched != negate;
+}
+
+bool matchGlob(const char *p, const char *pe, const char *s, const char *se)
+{
+    while (p < pe)
+    {
+        if (*p == '*')
+        {
+            if (p + 1 < pe && p[1] == '*')
+            {
+                // "**" matches any number of whole segments
+                while (p < pe && *p == '*')
+                    ++p;
+                if (p == pe)
+                    return true;
+                if (*p == '/')
+                {
+                    ++p;
+                    for (const char *t = s; t <= se; ++t)
+                    {
+                        if ((t == s || t[-1] == '/') && matchGlob(p, pe, t, se))
+                            return true;
+                    }
+                    return false;
+                }
+                for (const char *t = s; t <= se; ++t)
+                {
+                    if (matchGlob(p, pe, t, se))
+                        return true;
+                }
+                return false;
+            }
+            ++p;
+            for (const char *t = s;; ++t)
+            {
+                if (matchGlob(p, pe, t, se))
+                    return true;
+                if (t == se || *t == '/')
+                    return false;
+            }
+        }
+        if (s == se)
+            return false;
+        if (*p == '?')
+        {
+            if (*s == '/')
+                return false;
+            ++p;
+        }
+        else if (*p == '[')
+        {
+            ++p;
+            if (*s == '/' || !matchClass(p, pe, *s))
+                return false;
+        }
+        else
+        {
+            if (*p != *s)
+                return false;
+            ++p;
+        }
+        ++s;
+    }
+    return s == se;
+}
+
+} // namespace
+
+// GlobPattern
+
+GlobPattern::GlobPattern(const std::string &pattern)
+{
+    expandBraces(pattern, alternatives);
+}
+
+bool GlobPattern::matches(const std::string &path) const
+{
+    const char *s = path.data(), *se = path.data() + path.size();
+    for (auto &alternative : alternatives)
+    {
+        if (matchGlob(alternative.data(), alternative.data() + alternative.size(), s, se))
+            return true;
+    }
+    return false;
+}
+
+// FileEventCoalescer
+
+FileEventCoalescer::FileEventCoalescer(std::chrono::milliseconds window) : quietWindow(window)
+{
+}
+
+void FileEventCoalescer::setWindow(std::chrono::milliseconds window)
+{
+    quietWindow = window;
+}
+
+void FileEventCoalescer::add(const std::string &path, FileChangeType type, Clock::time_point now)
+{
+    if (pending.empty())
+        first = now;
+    last = now;
+
+    auto it = pending.find(path);
+    if (it == pending.end())
+    {
+        pending.emplace(path, type);
+        order.push_back(path);
+        return;
+    }
+
+    FileChangeType previous = it->second;
+    if (previous == FileChangeType::Created && type == FileChangeType::Deleted)
+    {
+        // Never existed as far as the server is concerned; the stale entry in order is skipped later
+        pending.erase(it);
+        return;
+    }
+    if (previous == FileChangeType::Created)
+        return;
+    if (previous == FileChangeType::Deleted && type == FileChangeType::Created)
+        it->second = FileChangeType::Changed;
+    else
+        it->second = type;
+}
+
+bool FileEventCoalescer::due(Clock::time_point now) const
+{
+    return !pending.empty() && (now - last >= quietWindow || now - first >= 4 * quietWindow);
+}
+
+std::chrono::milliseconds FileEventCoalescer::timeUntilDue(Clock::time_point now) const
+{
+    if (pending.empty() || due(now))
+        return std::chrono::milliseconds(0);
+    auto quiet = last + quietWindow - now;
+    auto latest = first + 4 * quietWindow - now;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::min(quiet, latest)) +
+           std::chrono::milliseconds(1);
+}
+
+std::vector<FileEvent> FileEventCoalescer::takeBatch()
+{
+    std::vector<FileEvent> batch;
+    batch.reserve(pending.size());
+    for (auto &path : order)
+    {
+        auto it = pending.find(path);
+        if (it == pending.end())
+            continue;
+        FileEvent event;
+        event.uri.from(path);
+        event.type = it->second;
+        batch.push_back(std::move(event));
+        pending.erase(it);
+    }
+    order.clear();
+    pending.clear();
+    return batch;
+}
+
+// InotifyWatcher
+
+InotifyWatcher::InotifyWatcher()
+{
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+InotifyWatcher::~InotifyWatcher()
+{
+#ifdef __linux__
+    if (inotifyFd >= 0)
+        ::close(inotifyFd);
+#endif
+}
+
+bool InotifyWatcher::isSupported()
+{
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+void InotifyWatcher::setExcludedDirectories(std::vector<std::string> names)
+{
+    excluded = std::move(names);
+}
+
+bool InotifyWatcher::watchTree(const std::string &root)
+{
+    if (inotifyFd < 0)
+        return false;
+    size_t before = directories.size();
+    addDirectory(root, nullptr);
+    if (directories.size() == before)
+        return false;
+    roots.push_back(root);
+    return true;
+}
+
+void InotifyWatcher::rescan(const Callback &callback)
+{
+    Callback changed = [&callback](const std::string &path, FileChangeType) {
+        callback(path, FileChangeType::Changed);
+    };
+    for (auto &root : roots)
+        addDirectory(root, &changed);
+}
+
+void InotifyWatcher::addDirectory(const std::string &path, const Callback *created)
+{
+#ifdef __linux__
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF |
+                          IN_MOVE_SELF | IN_ONLYDIR;
+    int wd = inotify_add_watch(inotifyFd, path.c_str(), mask);
+    if (wd < 0)
+        return;
+    directories[wd] = path;
+
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr)
+        return;
+    while (dirent *entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..")
+            continue;
+        std::string child = path + "/" + name;
+        bool isDirectory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN)
+        {
+            struct stat st
+            {
+            };
+            isDirectory = ::lstat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        if (isDirectory)
+        {
+            if (std::find(excluded.begin(), excluded.end(), name) == excluded.end())
+                addDirectory(child, created);
+        }
+        else if (created != nullptr)
+        {
+            // Files that appeared in a new directory before its watch was in place
+            (*created)(child, FileChangeType::Created);
+        }
+    }
+    closedir(dir);
+#endif
+}
+
+bool InotifyWatcher::readEvents(const Callback &callback)
+{
+    bool complete = true;
+#ifdef __linux__
+    alignas(inotify_event) char buffer[64 * 1024];
+    for (;;)
+    {
+        ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+        for (char *p = buffer; p < buffer + length;)
+        {
+            auto *event = reinterpret_cast<inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                complete = false;
+                continue;
+            }
+            if (event->mask & IN_IGNORED)
+            {
+                directories.erase(event->wd);
+                continue;
+            }
+            auto dir = directories.find(event->wd);
+            if (dir == directories.end() || event->len == 0)
+                continue;
+
+            std::string path = dir->second + "/" + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                bool isExcluded = std::find(excluded.begin(), excluded.end(), event->name) != excluded.end();
+                if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && !isExcluded)
+                    addDirectory(path, &callback);
+                continue;
+            }
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                callback(path, FileChangeType::Created);
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                callback(path, FileChangeType::Deleted);
+            else if (event->mask & IN_CLOSE_WRITE)
+                callback(path, FileChangeType::Changed);
+        }
+    }
+#endif
+    return complete;
+}
+
+// FileWatchFilter
+
+void FileWatchFilter::setWatchers(const std::vector<FileSystemWatcher> &list)
+{
+    watchers.clear();
+    for (auto &watcher : list)
+    {
+        CompiledWatcher compiled;
+        if (!watcher.baseUri.empty())
+        {
+            compiled.base = URIForFile::UriToPath(watcher.baseUri);
+            while (!compiled.base.empty() && compiled.base.back() == '/')
+                compiled.base.pop_back();
+        }
+        compiled.glob = GlobPattern(watcher.globPattern);
+        compiled.kind = watcher.kind;
+        watchers.push_back(std::move(compiled));
+    }
+}
+
+bool FileWatchFilter::accepts(const std::string &path, FileChangeType type) const
+{
+    int bit = type == FileChangeType::Created ? 1 : type == FileChangeType::Changed ? 2 : 4;
+    for (auto &watcher : watchers)
+    {
+        if ((watcher.kind & bit) == 0)
+            continue;
+        if (watcher.base.empty())
+        {
+            if (watcher.glob.matches(path))
+                return true;
+        }
+        else if (path.size() > watcher.base.size() && path.compare(0, watcher.base.size(), watcher.base) == 0 &&
+                 path[watcher.base.size()] == '/' && watcher.glob.matches(path.substr(watcher.base.size() + 1)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
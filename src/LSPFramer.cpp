@@ -0,0 +1,90 @@
+#include <LSPFramer.hpp>
+#include <cctype>
+#include <cstring>
+
+void MessageFramer::append(const char *data, size_t size)
+{
+    // Drop what has been handed out already before growing the buffer
+    if (consumed > 0 && consumed >= buffer.size() / 2)
+    {
+        buffer.erase(0, consumed);
+        consumed = 0;
+    }
+    buffer.append(data, size);
+}
+
+bool MessageFramer::parseHeader()
+{
+    size_t end = buffer.find("\r\n\r\n", consumed);
+    if (end == std::string::npos)
+        return false;
+
+    // Header fields are case insensitive, Content-Type is ignored.
+    static const char field[] = "content-length:";
+    const size_t fieldLength = sizeof(field) - 1;
+    bool found = false;
+    size_t line = consumed;
+    while (line < end)
+    {
+        size_t lineEnd = buffer.find("\r\n", line);
+        if (lineEnd - line > fieldLength)
+        {
+            size_t i = 0;
+            while (i < fieldLength && std::tolower(static_cast<unsigned char>(buffer[line + i])) == field[i])
+                ++i;
+            if (i == fieldLength)
+            {
+                size_t pos = line + fieldLength;
+                while (pos < lineEnd && buffer[pos] == ' ')
+                    ++pos;
+                contentLength = 0;
+                while (pos < lineEnd && std::isdigit(static_cast<unsigned char>(buffer[pos])))
+                    contentLength = contentLength * 10 + (buffer[pos++] - '0');
+                found = true;
+            }
+        }
+        line = lineEnd + 2;
+    }
+
+    consumed = end + 4;
+    // A header without a length can't be framed, skip it and resync on the next one.
+    inBody = found;
+    return true;
+}
+
+bool MessageFramer::next(std::string &payload)
+{
+    while (!inBody)
+    {
+        if (!parseHeader())
+            return false;
+    }
+    if (buffer.size() - consumed < contentLength)
+        return false;
+
+    payload.assign(buffer, consumed, contentLength);
+    consumed += contentLength;
+    inBody = false;
+    if (consumed == buffer.size())
+    {
+        buffer.clear();
+        consumed = 0;
+    }
+    return true;
+}
+
+void MessageFramer::clear()
+{
+    buffer.clear();
+    consumed = 0;
+    contentLength = 0;
+    inBody = false;
+}
+
+std::string MessageFramer::frame(const std::string &payload)
+{
+    std::string framed = "Content-Length: " + std::to_string(payload.size()) + "\r\n\r\n";
+    framed.reserve(framed.size() + payload.size());
+    framed += payload;
+    return framed;
+}
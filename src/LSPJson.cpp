@@ -0,0 +1,3 @@
+#include <LSPJson.hpp>
+
+template class nlohmann::basic_json<>;
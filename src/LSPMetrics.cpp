@@ -0,0 +1,262 @@
+#include <LSPMetrics.hpp>
+#include <LSPJson.hpp>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+int highestBit(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1)
+        ++bit;
+    return bit;
+#endif
+}
+
+int64_t nowMsec()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+LatencySummary summarize(const LatencyHistogram &histogram)
+{
+    static const double fractions[] = {0.5, 0.9, 0.99};
+    uint64_t values[3] = {};
+    histogram.percentiles(fractions, values, 3);
+
+    LatencySummary summary;
+    summary.count = histogram.count();
+    summary.meanMsec = histogram.mean() / 1000;
+    summary.p50Msec = static_cast<double>(values[0]) / 1000;
+    summary.p90Msec = static_cast<double>(values[1]) / 1000;
+    summary.p99Msec = static_cast<double>(values[2]) / 1000;
+    summary.maxMsec = static_cast<double>(histogram.max()) / 1000;
+    return summary;
+}
+
+json summaryJson(const LatencySummary &summary)
+{
+    return {{"count", summary.count}, {"meanMsec", summary.meanMsec}, {"p50Msec", summary.p50Msec},
+            {"p90Msec", summary.p90Msec}, {"p99Msec", summary.p99Msec}, {"maxMsec", summary.maxMsec}};
+}
+} // namespace
+
+// LatencyHistogram
+
+size_t LatencyHistogram::bucketFor(uint64_t micros)
+{
+    if (micros < 64)
+        return static_cast<size_t>(micros);
+    int bit = highestBit(micros);
+    if (bit > 40)
+        return bucketCount - 1;
+    int shift = bit - 5;
+    return 64 + static_cast<size_t>(shift - 1) * 32 + static_cast<size_t>((micros >> shift) - 32);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t bucket)
+{
+    if (bucket < 64)
+        return bucket;
+    int shift = static_cast<int>((bucket - 64) / 32) + 1;
+    uint64_t sub = (bucket - 64) % 32 + 32;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t micros)
+{
+    ++counts[bucketFor(micros)];
+    ++total;
+    sum += micros;
+    minimum = std::min(minimum, micros);
+    maximum = std::max(maximum, micros);
+}
+
+void LatencyHistogram::clear()
+{
+    counts.fill(0);
+    total = 0;
+    sum = 0;
+    minimum = UINT64_MAX;
+    maximum = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+    uint64_t value = 0;
+    percentiles(&fraction, &value, 1);
+    return value;
+}
+
+void LatencyHistogram::percentiles(const double *fractions, uint64_t *values, size_t count) const
+{
+    size_t next = 0;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < bucketCount && next < count && total > 0; ++bucket)
+    {
+        seen += counts[bucket];
+        // The rank is rounded up, so p50 of two values is the lower one
+        while (next < count && static_cast<double>(seen) >= fractions[next] * static_cast<double>(total))
+        {
+            // The last bucket's bound can be far above what was actually recorded
+            values[next++] = std::min(bucketUpperBound(bucket), maximum);
+        }
+    }
+    for (; next < count; ++next)
+        values[next] = maximum;
+}
+
+// MetricsSnapshot
+
+json MetricsSnapshot::toJson() const
+{
+    json perMethod = json::object();
+    for (auto &entry : methods)
+    {
+        perMethod[entry.method] = {{"sent", entry.sent},
+                                   {"answered", entry.answered},
+                                   {"errors", entry.errors},
+                                   {"cancelled", entry.cancelled},
+                                   {"superseded", entry.superseded},
+                                   {"rejected", entry.rejected},
+                                   {"latency", summaryJson(entry.latency)}};
+    }
+    return {{"intervalMsec", intervalMsec},
+            {"messagesIn", messagesIn},
+            {"messagesOut", messagesOut},
+            {"bytesIn", bytesIn},
+            {"bytesOut", bytesOut},
+            {"repliesDiscarded", repliesDiscarded},
+            {"decode", summaryJson(decode)},
+            {"inFlight", inFlight},
+            {"queued", queued},
+            {"maxQueued", maxQueued},
+            {"queuedBytes", queuedBytes},
+            {"methods", perMethod}};
+}
+
+// MemoryUsage
+
+size_t MemoryUsage::total() const
+{
+    size_t sum = receiveBuffer + sendBuffer + scheduledRequests + pendingRequests + documents + instrumentation;
+    for (auto &cache : caches)
+        sum += cache.bytes;
+    return sum;
+}
+
+json MemoryUsage::toJson() const
+{
+    json perCache = json::object();
+    for (auto &cache : caches)
+        perCache[cache.name] = cache.bytes;
+    return {{"total", total()},
+            {"receiveBuffer", receiveBuffer},
+            {"sendBuffer", sendBuffer},
+            {"scheduledRequests", scheduledRequests},
+            {"pendingRequests", pendingRequests},
+            {"documents", documents},
+            {"instrumentation", instrumentation},
+            {"caches", perCache},
+            {"decodePeak", decodePeak},
+            {"budget", budget},
+            {"evictions", evictions}};
+}
+
+// MetricsRecorder
+
+MetricsRecorder::MetricsRecorder() : startedMsec(nowMsec())
+{
+}
+
+void MetricsRecorder::messageIn(size_t bytes, uint64_t decodeMicros)
+{
+    ++messagesIn;
+    bytesIn += bytes;
+    decode.record(decodeMicros);
+}
+
+void MetricsRecorder::messageOut(size_t bytes)
+{
+    ++messagesOut;
+    bytesOut += bytes;
+}
+
+void MetricsRecorder::requestSent(const std::string &name)
+{
+    ++method(name).counters.sent;
+}
+
+void MetricsRecorder::requestAnswered(const std::string &name, uint64_t micros, bool error)
+{
+    Method &entry = method(name);
+    ++entry.counters.answered;
+    if (error)
+        ++entry.counters.errors;
+    entry.latency.record(micros);
+}
+
+void MetricsRecorder::requestCancelled(const std::string &name)
+{
+    ++method(name).counters.cancelled;
+}
+
+void MetricsRecorder::requestSuperseded(const std::string &name)
+{
+    ++method(name).counters.superseded;
+}
+
+void MetricsRecorder::requestRejected(const std::string &name)
+{
+    ++method(name).counters.rejected;
+}
+
+void MetricsRecorder::replyDiscarded()
+{
+    ++repliesDiscarded;
+}
+
+MetricsSnapshot MetricsRecorder::snapshot() const
+{
+    MetricsSnapshot snapshot;
+    snapshot.intervalMsec = nowMsec() - startedMsec;
+    snapshot.messagesIn = messagesIn;
+    snapshot.messagesOut = messagesOut;
+    snapshot.bytesIn = bytesIn;
+    snapshot.bytesOut = bytesOut;
+    snapshot.repliesDiscarded = repliesDiscarded;
+    snapshot.decode = summarize(decode);
+    for (auto &entry : methods)
+    {
+        snapshot.methods.push_back(entry.second.counters);
+        snapshot.methods.back().method = entry.first;
+        snapshot.methods.back().latency = summarize(entry.second.latency);
+    }
+    std::sort(snapshot.methods.begin(), snapshot.methods.end(),
+              [](const MethodMetrics &lhs, const MethodMetrics &rhs) { return lhs.method < rhs.method; });
+    return snapshot;
+}
+
+void MetricsRecorder::reset()
+{
+    *this = MetricsRecorder();
+}
+
+size_t MetricsRecorder::memoryUsage() const
+{
+    // A hash node is the entry plus its key and a next pointer, the bucket array one pointer per bucket
+    return sizeof(*this) + methods.size() * (sizeof(Method) + sizeof(std::string) + sizeof(void *)) +
+           methods.bucket_count() * sizeof(void *);
+}
+
+// private
+
+MetricsRecorder::Method &MetricsRecorder::method(const std::string &name)
+{
+    return methods[name];
+}
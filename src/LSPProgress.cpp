@@ -0,0 +1,201 @@
+#include <LSPProgress.hpp>
+#include <LSPJson.hpp>
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+std::string tokenKey(const json &token)
+{
+    return token.is_string() ? token.get<std::string>() : token.dump();
+}
+
+// Finds the first "N/M" in a message like "indexing 12/345 (foo.cpp)"
+bool parseCounter(const std::string &message, int64_t &done, int64_t &total)
+{
+    for (size_t slash = message.find('/'); slash != std::string::npos; slash = message.find('/', slash + 1))
+    {
+        size_t begin = slash;
+        while (begin > 0 && std::isdigit(static_cast<unsigned char>(message[begin - 1])))
+            --begin;
+        size_t end = slash + 1;
+        while (end < message.size() && std::isdigit(static_cast<unsigned char>(message[end])))
+            ++end;
+        // Too long for int64_t, not a counter anyway
+        if (begin == slash || end == slash + 1 || slash - begin > 18 || end - slash > 19)
+            continue;
+        done = std::stoll(message.substr(begin, slash - begin));
+        total = std::stoll(message.substr(slash + 1, end - slash - 1));
+        return true;
+    }
+    return false;
+}
+
+int64_t milliseconds(ProgressTracker::Clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+} // namespace
+
+bool ProgressTracker::handle(const json &params, Clock::time_point now)
+{
+    if (!params.is_object() || !params.contains("token") || !params.contains("value"))
+        return false;
+    const json &value = params["value"];
+    if (!value.is_object() || !value.contains("kind") || !value["kind"].is_string())
+        return false;
+
+    std::string key = tokenKey(params["token"]);
+    const std::string &kind = value["kind"].get_ref<const std::string &>();
+    if (kind == "begin")
+    {
+        Token &token = running[key];
+        token = Token();
+        token.info.token = key;
+        token.order = nextOrder++;
+        token.begun = now;
+        update(token, value, now);
+        publish(token.info, true, now);
+        return true;
+    }
+
+    auto it = running.find(key);
+    if (it == running.end())
+        return kind == "report" || kind == "end";
+    Token &token = it->second;
+    update(token, value, now);
+    if (kind != "end")
+    {
+        publish(token.info, false, now);
+        return true;
+    }
+
+    token.info.finished = true;
+    token.info.remainingMsec = 0;
+    if (token.info.itemsTotal >= 0)
+        token.info.itemsDone = token.info.itemsTotal;
+    ProgressInfo info = std::move(token.info);
+    running.erase(it);
+    history.push_back(info);
+    while (history.size() > maxHistory)
+        history.pop_front();
+    publish(info, true, now);
+    for (auto &subscription : subscriptions)
+        subscription.second.lastDelivered.erase(key);
+    return true;
+}
+
+std::vector<ProgressInfo> ProgressTracker::active() const
+{
+    std::vector<const Token *> tokens;
+    for (auto &entry : running)
+        tokens.push_back(&entry.second);
+    std::sort(tokens.begin(), tokens.end(), [](const Token *lhs, const Token *rhs) { return lhs->order < rhs->order; });
+
+    std::vector<ProgressInfo> result;
+    auto now = Clock::now();
+    for (auto *token : tokens)
+    {
+        result.push_back(token->info);
+        result.back().elapsedMsec = milliseconds(now - token->begun);
+    }
+    return result;
+}
+
+void ProgressTracker::setHistorySize(size_t size)
+{
+    maxHistory = size;
+    while (history.size() > maxHistory)
+        history.pop_front();
+}
+
+ProgressTracker::SubscriptionID ProgressTracker::subscribe(Callback callback, int intervalMsec)
+{
+    Subscription &subscription = subscriptions[++lastSubscription];
+    subscription.callback = std::move(callback);
+    subscription.interval = std::chrono::milliseconds(intervalMsec);
+    return lastSubscription;
+}
+
+void ProgressTracker::unsubscribe(SubscriptionID id)
+{
+    subscriptions.erase(id);
+}
+
+size_t ProgressTracker::memoryUsage() const
+{
+    // A map node carries three pointers and a color besides its key and value
+    return running.size() * (sizeof(Token) + sizeof(std::string) + 4 * sizeof(void *)) +
+           history.size() * sizeof(ProgressInfo);
+}
+
+void ProgressTracker::clear()
+{
+    running.clear();
+    for (auto &subscription : subscriptions)
+        subscription.second.lastDelivered.clear();
+}
+
+// private
+
+void ProgressTracker::update(Token &token, const json &value, Clock::time_point now)
+{
+    ProgressInfo &info = token.info;
+    if (value.contains("title") && value["title"].is_string())
+        info.title = value["title"].get<std::string>();
+    if (value.contains("message") && value["message"].is_string())
+        info.message = value["message"].get<std::string>();
+    if (value.contains("percentage") && value["percentage"].is_number())
+        info.percentage = std::min(100, std::max(0, value["percentage"].get<int>()));
+    if (value.contains("cancellable") && value["cancellable"].is_boolean())
+        info.cancellable = value["cancellable"].get<bool>();
+    info.elapsedMsec = milliseconds(now - token.begun);
+
+    int64_t done = 0, total = 0;
+    if (parseCounter(info.message, done, total))
+    {
+        info.itemsDone = done;
+        info.itemsTotal = total;
+        if (token.firstItems < 0 || done < token.firstItems)
+        {
+            // A counter going backwards means the server started a new batch
+            token.firstItems = done;
+            token.firstItemsAt = now;
+        }
+    }
+
+    info.itemsPerSecond = 0;
+    info.remainingMsec = -1;
+    int64_t counted = milliseconds(now - token.firstItemsAt);
+    if (token.firstItems >= 0 && info.itemsDone > token.firstItems && counted > 0)
+    {
+        info.itemsPerSecond = static_cast<double>(info.itemsDone - token.firstItems) * 1000.0 / counted;
+        int64_t left = std::max<int64_t>(0, info.itemsTotal - info.itemsDone);
+        info.remainingMsec = static_cast<int64_t>(static_cast<double>(left) * 1000.0 / info.itemsPerSecond);
+    }
+    else if (info.percentage > 0)
+    {
+        info.remainingMsec = info.elapsedMsec * (100 - info.percentage) / info.percentage;
+    }
+}
+
+void ProgressTracker::publish(const ProgressInfo &info, bool always, Clock::time_point now)
+{
+    // Callbacks may unsubscribe, so look every subscription up again
+    std::vector<SubscriptionID> ids;
+    for (auto &subscription : subscriptions)
+        ids.push_back(subscription.first);
+    for (SubscriptionID id : ids)
+    {
+        auto it = subscriptions.find(id);
+        if (it == subscriptions.end())
+            continue;
+        Subscription &subscription = it->second;
+        auto last = subscription.lastDelivered.find(info.token);
+        if (!always && last != subscription.lastDelivered.end() && now - last->second < subscription.interval)
+            continue;
+        subscription.lastDelivered[info.token] = now;
+        Callback callback = subscription.callback;
+        callback(info);
+    }
+}
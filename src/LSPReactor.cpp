@@ -0,0 +1,113 @@
+#include <LSPReactor.hpp>
+#include <algorithm>
+
+LSPReactor::Connection::Connection(LSPEventLoop &loop, std::string program, std::vector<std::string> arguments,
+                                   LSPClientCore::Listener *listener)
+    : process(loop, std::move(program), std::move(arguments)), client(process, listener)
+{
+}
+
+LSPReactor::LSPReactor(size_t readBudget) : budget(std::max<size_t>(1, readBudget))
+{
+}
+
+LSPReactor::~LSPReactor()
+{
+    ready.clear();
+    retired.clear();
+    connections.clear();
+}
+
+void LSPReactor::setReadBudget(size_t bytes)
+{
+    budget = std::max<size_t>(1, bytes);
+}
+
+LSPReactor::Connection *LSPReactor::addServer(std::string program, std::vector<std::string> arguments,
+                                              LSPClientCore::Listener *listener)
+{
+    std::unique_ptr<Connection> connection(
+        new Connection(eventLoop, std::move(program), std::move(arguments), listener));
+    connection->process.reactor = this;
+    if (!connection->process.start())
+        return nullptr;
+    connections.push_back(std::move(connection));
+    return connections.back().get();
+}
+
+void LSPReactor::removeServer(Connection *connection)
+{
+    auto it = std::find_if(connections.begin(), connections.end(),
+                           [connection](const std::unique_ptr<Connection> &c) { return c.get() == connection; });
+    if (it == connections.end())
+        return;
+    LSPServerProcess *process = &connection->process;
+    if (process->queued)
+        std::replace(ready.begin(), ready.end(), process, static_cast<LSPServerProcess *>(nullptr));
+    process->queued = false;
+    process->kill();
+    retired.push_back(std::move(*it));
+    connections.erase(it);
+}
+
+int LSPReactor::run()
+{
+    running = true;
+    exitCode = 0;
+    while (running)
+        processEvents(-1);
+    return exitCode;
+}
+
+void LSPReactor::quit(int code)
+{
+    exitCode = code;
+    running = false;
+    eventLoop.quit(code);
+}
+
+void LSPReactor::processEvents(int timeoutMsec)
+{
+    eventLoop.processEvents(ready.empty() ? timeoutMsec : 0);
+    serviceReady();
+    retired.clear();
+}
+
+// private
+
+void LSPReactor::markReadable(LSPServerProcess *process, bool isStdout)
+{
+    if (isStdout)
+        process->stdoutReadable = true;
+    else
+        process->stderrReadable = true;
+    if (!process->queued)
+    {
+        process->queued = true;
+        ready.push_back(process);
+    }
+}
+
+void LSPReactor::serviceReady()
+{
+    // Only the connections that were ready when the round started; anything re-queued
+    // during it waits for the next round, after epoll had a chance to report the others
+    for (size_t count = ready.size(); count > 0; --count)
+    {
+        LSPServerProcess *process = ready.front();
+        ready.pop_front();
+        if (process == nullptr)
+            continue;
+        if (process->stdoutReadable)
+            process->stdoutReadable = process->readStdout(budget);
+        if (process->stderrReadable)
+            process->stderrReadable = process->readStderr(budget);
+        // The read callbacks may have removed the connection, which clears `queued`
+        if (!process->queued)
+            continue;
+        if (process->stdoutReadable || process->stderrReadable)
+            ready.push_back(process);
+        else
+            process->queued = false;
+    }
+}
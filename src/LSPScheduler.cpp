@@ -0,0 +1,128 @@
+#include <LSPScheduler.hpp>
+#include <algorithm>
+
+RequestScheduler::RequestScheduler()
+{
+    // Interactive requests are never held back unless asked for explicitly.
+    classes[static_cast<int>(RequestPriority::Viewport)].limit = 8;
+    classes[static_cast<int>(RequestPriority::Background)].limit = 2;
+}
+
+void RequestScheduler::setInFlightLimit(RequestPriority priority, int limit)
+{
+    classes[static_cast<int>(priority)].limit = std::max(0, limit);
+}
+
+int RequestScheduler::inFlightLimit(RequestPriority priority) const
+{
+    return classes[static_cast<int>(priority)].limit;
+}
+
+void RequestScheduler::setTotalInFlightLimit(int limit)
+{
+    totalLimit = std::max(0, limit);
+}
+
+void RequestScheduler::submit(RequestPriority priority, std::string id, std::string method, std::string payload)
+{
+    PriorityClass &c = classes[static_cast<int>(priority)];
+    Message message;
+    message.id = std::move(id);
+    message.method = std::move(method);
+    message.payload = std::move(payload);
+    message.priority = priority;
+    message.enqueued = Clock::now();
+    bytesQueued += message.payload.size();
+    c.queue.push_back(std::move(message));
+    c.stats.queueDepth = c.queue.size();
+    c.stats.maxQueueDepth = std::max(c.stats.maxQueueDepth, c.stats.queueDepth);
+}
+
+void RequestScheduler::takeReady(std::vector<Message> &ready)
+{
+    auto now = Clock::now();
+    for (auto &c : classes)
+    {
+        while (!c.queue.empty() && (c.limit == 0 || static_cast<int>(c.stats.inFlight) < c.limit))
+        {
+            if (totalLimit != 0 && static_cast<int>(inFlight.size()) >= totalLimit)
+                break;
+            Message &message = c.queue.front();
+            auto wait = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - message.enqueued).count());
+            c.stats.totalWaitMicros += wait;
+            c.stats.maxWaitMicros = std::max(c.stats.maxWaitMicros, wait);
+            ++c.stats.sent;
+            ++c.stats.inFlight;
+            inFlight[message.id] = message.priority;
+            bytesQueued -= message.payload.size();
+            ready.push_back(std::move(message));
+            c.queue.pop_front();
+        }
+        c.stats.queueDepth = c.queue.size();
+    }
+}
+
+void RequestScheduler::completed(const std::string &id)
+{
+    auto it = inFlight.find(id);
+    if (it == inFlight.end())
+        return;
+    --classes[static_cast<int>(it->second)].stats.inFlight;
+    inFlight.erase(it);
+}
+
+bool RequestScheduler::remove(const std::string &id)
+{
+    for (auto &c : classes)
+    {
+        auto it = std::find_if(c.queue.begin(), c.queue.end(), [&id](const Message &m) { return m.id == id; });
+        if (it == c.queue.end())
+            continue;
+        bytesQueued -= it->payload.size();
+        c.queue.erase(it);
+        c.stats.queueDepth = c.queue.size();
+        return true;
+    }
+    return false;
+}
+
+std::string RequestScheduler::dropOldest(const std::string &method)
+{
+    // Lowest priority first: a superseded background request is the cheapest to lose
+    for (int i = classCount - 1; i >= 0; --i)
+    {
+        auto &queue = classes[i].queue;
+        auto it = std::find_if(queue.begin(), queue.end(), [&method](const Message &m) { return m.method == method; });
+        if (it == queue.end())
+            continue;
+        std::string id = std::move(it->id);
+        bytesQueued -= it->payload.size();
+        queue.erase(it);
+        classes[i].stats.queueDepth = queue.size();
+        return id;
+    }
+    return std::string();
+}
+
+void RequestScheduler::clear()
+{
+    bytesQueued = 0;
+    for (auto &c : classes)
+    {
+        c.queue.clear();
+        c.stats.queueDepth = 0;
+        c.stats.inFlight = 0;
+    }
+    inFlight.clear();
+}
+
+bool RequestScheduler::hasQueued() const
+{
+    return std::any_of(std::begin(classes), std::end(classes), [](const PriorityClass &c) { return !c.queue.empty(); });
+}
+
+SchedulerStats RequestScheduler::stats(RequestPriority priority) const
+{
+    return classes[static_cast<int>(priority)].stats;
+}
@@ -0,0 +1,332 @@
+#include <LSPReactor.hpp>
+#include <LSPServerProcess.hpp>
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace
+{
+// Upper bound for one readable callback, so a chatty server can't monopolize the loop
+const size_t readBudget = 256 * 1024;
+
+bool makePipe(int fds[2])
+{
+    return ::pipe2(fds, O_CLOEXEC) == 0;
+}
+
+void setNonBlocking(int fd)
+{
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+void ignoreSigpipe()
+{
+    struct sigaction current
+    {
+    };
+    if (::sigaction(SIGPIPE, nullptr, &current) == 0 && current.sa_handler == SIG_DFL)
+        ::signal(SIGPIPE, SIG_IGN);
+}
+} // namespace
+
+LSPServerProcess::LSPServerProcess(LSPEventLoop &loop, std::string program, std::vector<std::string> arguments)
+    : loop(loop), program(std::move(program)), arguments(std::move(arguments))
+{
+}
+
+LSPServerProcess::~LSPServerProcess()
+{
+    if (reapTimer != 0)
+        loop.cancelTimer(reapTimer);
+    if (restartTimer != 0)
+        loop.cancelTimer(restartTimer);
+    closeFd(stdinFd);
+    closeFd(stdoutFd);
+    closeFd(stderrFd);
+    if (processId > 0 && !exited)
+    {
+        ::kill(processId, SIGKILL);
+        ::waitpid(processId, nullptr, 0);
+    }
+}
+
+bool LSPServerProcess::start()
+{
+    if (processId > 0)
+    {
+        error = "The server is already running";
+        return false;
+    }
+    ignoreSigpipe();
+
+    int in[2], out[2], err[2];
+    if (!makePipe(in))
+    {
+        error = strerror(errno);
+        return false;
+    }
+    if (!makePipe(out))
+    {
+        error = strerror(errno);
+        ::close(in[0]);
+        ::close(in[1]);
+        return false;
+    }
+    if (!makePipe(err))
+    {
+        error = strerror(errno);
+        for (int fd : {in[0], in[1], out[0], out[1]})
+            ::close(fd);
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    // dup2 clears O_CLOEXEC on the target, every other pipe end is closed on exec
+    posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err[1], STDERR_FILENO);
+
+    std::vector<char *> argv;
+    argv.push_back(const_cast<char *>(program.c_str()));
+    for (auto &argument : arguments)
+        argv.push_back(const_cast<char *>(argument.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid = -1;
+    int result = posix_spawnp(&pid, program.c_str(), &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(in[0]);
+    ::close(out[1]);
+    ::close(err[1]);
+    if (result != 0)
+    {
+        error = strerror(result);
+        ::close(in[1]);
+        ::close(out[0]);
+        ::close(err[0]);
+        return false;
+    }
+
+    processId = pid;
+    exited = false;
+    stdinFd = in[1];
+    stdoutFd = out[0];
+    stderrFd = err[0];
+    for (int fd : {stdinFd, stdoutFd, stderrFd})
+        setNonBlocking(fd);
+
+    if (reactor != nullptr)
+    {
+        // Edge-triggered: the reactor keeps track of what is still readable
+        loop.watch(stdoutFd, EPOLLIN | EPOLLET, [this](uint32_t) { reactor->markReadable(this, true); });
+        loop.watch(stderrFd, EPOLLIN | EPOLLET, [this](uint32_t) { reactor->markReadable(this, false); });
+    }
+    else
+    {
+        loop.watch(stdoutFd, EPOLLIN, [this](uint32_t) { readStdout(readBudget); });
+        loop.watch(stderrFd, EPOLLIN, [this](uint32_t) { readStderr(readBudget); });
+    }
+    if (receiver != nullptr)
+        receiver->transportOpened();
+    return true;
+}
+
+void LSPServerProcess::closeWrite()
+{
+    flushOutgoing();
+    outgoing.clear();
+    outgoingOffset = 0;
+    closeFd(stdinFd);
+}
+
+void LSPServerProcess::terminate()
+{
+    if (processId > 0 && !exited)
+        ::kill(processId, SIGTERM);
+}
+
+void LSPServerProcess::kill()
+{
+    if (processId > 0 && !exited)
+        ::kill(processId, SIGKILL);
+}
+
+bool LSPServerProcess::isOpen() const
+{
+    return stdinFd >= 0;
+}
+
+void LSPServerProcess::write(const std::string &data)
+{
+    if (stdinFd < 0)
+        return;
+    if (outgoingOffset == outgoing.size())
+    {
+        outgoing.clear();
+        outgoingOffset = 0;
+    }
+    bool wasIdle = outgoing.empty();
+    outgoing += data;
+    if (!wasIdle)
+        return;
+    flushOutgoing();
+    if (outgoingOffset < outgoing.size() && stdinFd >= 0)
+    {
+        uint32_t events = reactor != nullptr ? EPOLLOUT | EPOLLET : EPOLLOUT;
+        loop.watch(stdinFd, events, [this](uint32_t) { onStdinWritable(); });
+    }
+}
+
+int64_t LSPServerProcess::bytesToWrite() const
+{
+    return static_cast<int64_t>(outgoing.size() - outgoingOffset);
+}
+
+bool LSPServerProcess::restart(int delayMsec)
+{
+    if (restartTimer != 0)
+        loop.cancelTimer(restartTimer);
+    restartTimer = loop.startTimer(delayMsec, [this]() {
+        restartTimer = 0;
+        if (!start() && receiver != nullptr)
+            receiver->transportClosed(-1, false);
+    });
+    return true;
+}
+
+// private
+
+void LSPServerProcess::flushOutgoing()
+{
+    while (stdinFd >= 0 && outgoingOffset < outgoing.size())
+    {
+        ssize_t written = ::write(stdinFd, outgoing.data() + outgoingOffset, outgoing.size() - outgoingOffset);
+        if (written > 0)
+        {
+            outgoingOffset += static_cast<size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0 && errno != EAGAIN)
+        {
+            // EPIPE: the server is gone, stdout EOF will report it
+            outgoing.clear();
+            outgoingOffset = 0;
+            closeFd(stdinFd);
+        }
+        return;
+    }
+}
+
+void LSPServerProcess::onStdinWritable()
+{
+    flushOutgoing();
+    if (outgoingOffset < outgoing.size())
+        return;
+    outgoing.clear();
+    outgoingOffset = 0;
+    if (stdinFd >= 0)
+        loop.unwatch(stdinFd);
+    if (receiver != nullptr)
+        receiver->transportDrained();
+}
+
+bool LSPServerProcess::readStdout(size_t budget)
+{
+    char buffer[64 * 1024];
+    size_t total = 0;
+    while (stdoutFd >= 0)
+    {
+        if (total >= budget)
+            return true;
+        ssize_t length = ::read(stdoutFd, buffer, std::min(sizeof(buffer), budget - total));
+        if (length > 0)
+        {
+            total += static_cast<size_t>(length);
+            if (receiver != nullptr)
+                receiver->transportData(buffer, static_cast<size_t>(length));
+            continue;
+        }
+        if (length < 0 && errno == EINTR)
+            continue;
+        if (length == 0 || errno != EAGAIN)
+        {
+            closeFd(stdoutFd);
+            reap();
+        }
+        break;
+    }
+    return false;
+}
+
+bool LSPServerProcess::readStderr(size_t budget)
+{
+    char buffer[16 * 1024];
+    size_t total = 0;
+    while (stderrFd >= 0)
+    {
+        if (total >= budget)
+            return true;
+        ssize_t length = ::read(stderrFd, buffer, std::min(sizeof(buffer), budget - total));
+        if (length > 0)
+        {
+            total += static_cast<size_t>(length);
+            if (receiver != nullptr)
+                receiver->transportStderr(buffer, static_cast<size_t>(length));
+            continue;
+        }
+        if (length < 0 && errno == EINTR)
+            continue;
+        if (length == 0 || errno != EAGAIN)
+            closeFd(stderrFd);
+        break;
+    }
+    return false;
+}
+
+void LSPServerProcess::closeFd(int &fd)
+{
+    if (fd < 0)
+        return;
+    loop.unwatch(fd);
+    ::close(fd);
+    fd = -1;
+}
+
+void LSPServerProcess::reap()
+{
+    reapTimer = 0;
+    int status = 0;
+    pid_t result = ::waitpid(processId, &status, WNOHANG);
+    if (result == 0)
+    {
+        // stdout closed before the process finished exiting, check back shortly
+        reapTimer = loop.startTimer(10, [this]() { reap(); });
+        return;
+    }
+    exited = true;
+    if (stderrFd >= 0)
+        readStderr(SIZE_MAX);
+    closeFd(stderrFd);
+    closeFd(stdinFd);
+    outgoing.clear();
+    outgoingOffset = 0;
+
+    bool crashed = result > 0 && WIFSIGNALED(status);
+    int exitCode = result > 0 && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    processId = -1;
+    if (receiver != nullptr)
+        receiver->transportClosed(exitCode, crashed);
+}
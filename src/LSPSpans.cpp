@@ -0,0 +1,166 @@
+#include <LSPSpans.hpp>
+#include <LSPJson.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+const int requestsThread = 1;
+const int messagesThread = 2;
+} // namespace
+
+SpanTracer::SpanTracer(size_t maxEvents) : maxEvents(std::max<size_t>(maxEvents, 1)), origin(Clock::now())
+{
+}
+
+void SpanTracer::begin(const std::string &id, const std::string &method, Clock::time_point at)
+{
+    // Requests that never end (e.g. forgotten ids of a dropped server) must not pile up
+    if (open.size() >= maxEvents)
+        open.clear();
+    open[id] = {method, at};
+}
+
+void SpanTracer::stage(const std::string &id, const char *name, Clock::time_point start, Clock::time_point end)
+{
+    auto request = open.find(id);
+    if (request == open.end())
+        return;
+    add({Kind::Stage, name, id, request->second.method, nullptr, start, std::max(start, end)});
+}
+
+void SpanTracer::end(const std::string &id, Clock::time_point at, const char *outcome)
+{
+    auto request = open.find(id);
+    if (request == open.end())
+        return;
+    add({Kind::Request, nullptr, id, std::move(request->second.method), outcome, request->second.start,
+         std::max(request->second.start, at)});
+    open.erase(request);
+}
+
+void SpanTracer::complete(const char *name, const std::string &method, Clock::time_point start, Clock::time_point end)
+{
+    add({Kind::Complete, name, std::string(), method, nullptr, start, std::max(start, end)});
+}
+
+json SpanTracer::toJson() const
+{
+    auto micros = [this](Clock::time_point at) {
+        return std::chrono::duration<double, std::micro>(at - origin).count();
+    };
+
+    // Sorted by time; a request's own begin comes before its stages and its end after them
+    std::vector<std::tuple<double, int, json>> sorted;
+    sorted.reserve(events.size() * 2);
+    for (auto &event : events)
+    {
+        if (event.kind == Kind::Complete)
+        {
+            sorted.emplace_back(micros(event.start), 1,
+                                json{{"name", event.name},
+                                     {"cat", "message"},
+                                     {"ph", "X"},
+                                     {"ts", micros(event.start)},
+                                     {"dur", micros(event.end) - micros(event.start)},
+                                     {"pid", 1},
+                                     {"tid", messagesThread},
+                                     {"args", {{"method", event.method}}}});
+            continue;
+        }
+        bool isRequest = event.kind == Kind::Request;
+        json args = {{"id", event.id}, {"method", event.method}};
+        if (isRequest)
+            args["outcome"] = event.outcome;
+        json begin = {{"name", isRequest ? event.method : std::string(event.name)},
+                      {"cat", "request"},
+                      {"ph", "b"},
+                      {"id", event.id},
+                      {"ts", micros(event.start)},
+                      {"pid", 1},
+                      {"tid", requestsThread},
+                      {"args", std::move(args)}};
+        json end = begin;
+        end["ph"] = "e";
+        end["ts"] = micros(event.end);
+        end.erase("args");
+        sorted.emplace_back(micros(event.start), isRequest ? 0 : 1, std::move(begin));
+        sorted.emplace_back(micros(event.end), isRequest ? 2 : 1, std::move(end));
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const std::tuple<double, int, json> &lhs, const std::tuple<double, int, json> &rhs) {
+                         return std::get<0>(lhs) != std::get<0>(rhs) ? std::get<0>(lhs) < std::get<0>(rhs)
+                                                                     : std::get<1>(lhs) < std::get<1>(rhs);
+                     });
+
+    json traceEvents = json::array();
+    traceEvents.push_back({{"name", "process_name"}, {"ph", "M"}, {"pid", 1}, {"args", {{"name", "LSPClient"}}}});
+    traceEvents.push_back({{"name", "thread_name"},
+                           {"ph", "M"},
+                           {"pid", 1},
+                           {"tid", requestsThread},
+                           {"args", {{"name", "requests"}}}});
+    traceEvents.push_back({{"name", "thread_name"},
+                           {"ph", "M"},
+                           {"pid", 1},
+                           {"tid", messagesThread},
+                           {"args", {{"name", "incoming messages"}}}});
+    for (auto &event : sorted)
+        traceEvents.push_back(std::move(std::get<2>(event)));
+    return {{"traceEvents", std::move(traceEvents)},
+            {"displayTimeUnit", "ms"},
+            {"otherData", {{"droppedEvents", dropped}}}};
+}
+
+bool SpanTracer::writeFile(const std::string &path) const
+{
+    std::string text = toJson().dump();
+    FILE *out = std::fopen(path.c_str(), "wb");
+    if (out == nullptr)
+        return false;
+    bool ok = text.empty() || std::fwrite(text.data(), text.size(), 1, out) == 1;
+    return std::fclose(out) == 0 && ok;
+}
+
+void SpanTracer::clear()
+{
+    events.clear();
+    open.clear();
+    dropped = 0;
+    bytes = 0;
+}
+
+size_t SpanTracer::evict(size_t wanted)
+{
+    size_t before = bytes;
+    while (!events.empty() && before - bytes < wanted)
+        dropOldest();
+    return before - bytes;
+}
+
+// private
+
+void SpanTracer::add(Event event)
+{
+    if (events.size() >= maxEvents)
+        dropOldest();
+    bytes += sizeOf(event);
+    events.push_back(std::move(event));
+}
+
+void SpanTracer::dropOldest()
+{
+    bytes -= sizeOf(events.front());
+    events.pop_front();
+    ++dropped;
+}
+
+size_t SpanTracer::sizeOf(const Event &event)
+{
+    // Strings short enough for the small string buffer live inside the event
+    static const size_t inlineCapacity = std::string().capacity();
+    auto heap = [](const std::string &text) { return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0; };
+    return sizeof(Event) + heap(event.id) + heap(event.method);
+}
@@ -0,0 +1,243 @@
+#include <LSPStderr.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+const size_t headerSize = sizeof(uint32_t);
+// Room for the header and a little text, whatever the options say
+const size_t minimumRingBytes = 64;
+// "I[" plus the longest timestamp clangd writes and then some
+const size_t maxPrefixBytes = 40;
+} // namespace
+
+StderrLog::StderrLog(StderrOptions options) : settings(options)
+{
+    settings.ringBytes = std::max(settings.ringBytes, minimumRingBytes);
+    ring.assign(settings.ringBytes, '\0');
+}
+
+void StderrLog::setOptions(StderrOptions options)
+{
+    options.ringBytes = std::max(options.ringBytes, minimumRingBytes);
+    bool resize = options.ringBytes != settings.ringBytes;
+    settings = options;
+    if (!resize)
+        return;
+    clear();
+    ring.assign(settings.ringBytes, '\0');
+    ring.shrink_to_fit();
+}
+
+void StderrLog::append(const char *data, size_t size)
+{
+    const char *end = data + size;
+    while (data < end)
+    {
+        auto newline = static_cast<const char *>(memchr(data, '\n', static_cast<size_t>(end - data)));
+        if (newline == nullptr)
+        {
+            partial.append(data, static_cast<size_t>(end - data));
+            // A line longer than the ring would be truncated anyway, don't let it grow without bound
+            if (partial.size() >= ring.size())
+                finish();
+            return;
+        }
+        if (partial.empty())
+        {
+            push(data, static_cast<size_t>(newline - data));
+        }
+        else
+        {
+            partial.append(data, static_cast<size_t>(newline - data));
+            finish();
+        }
+        data = newline + 1;
+    }
+}
+
+void StderrLog::finish()
+{
+    if (partial.empty())
+        return;
+    push(partial.data(), partial.size());
+    partial.clear();
+}
+
+void StderrLog::clear()
+{
+    start = 0;
+    used = 0;
+    deliverOffset = 0;
+    firstSequence = 0;
+    nextSequence = 0;
+    delivered = 0;
+    skipped = 0;
+    skippedBefore = 0;
+    lastBatch = Clock::time_point();
+    partial.clear();
+}
+
+bool StderrLog::due(Clock::time_point now) const
+{
+    return hasPending() && now - lastBatch >= std::chrono::milliseconds(settings.batchMsec);
+}
+
+std::chrono::milliseconds StderrLog::timeUntilDue(Clock::time_point now) const
+{
+    if (!hasPending())
+        return std::chrono::milliseconds(-1);
+    if (due(now))
+        return std::chrono::milliseconds(0);
+    auto left = lastBatch + std::chrono::milliseconds(settings.batchMsec) - now;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(left) + std::chrono::milliseconds(1);
+}
+
+uint64_t StderrLog::takeBatch(std::vector<LogLine> &lines, Clock::time_point now)
+{
+    lines.clear();
+    lastBatch = now;
+
+    uint64_t pending = nextSequence - delivered;
+    if (settings.maxBatchLines > 0 && pending > settings.maxBatchLines)
+    {
+        for (uint64_t skip = pending - settings.maxBatchLines; skip > 0; --skip)
+        {
+            deliverOffset = (deliverOffset + headerSize + recordSize(deliverOffset)) % ring.size();
+            ++delivered;
+            ++skipped;
+        }
+    }
+
+    lines.reserve(static_cast<size_t>(nextSequence - delivered));
+    for (; delivered < nextSequence; ++delivered)
+    {
+        uint32_t size = recordSize(deliverOffset);
+        size_t text = (deliverOffset + headerSize) % ring.size();
+        const char *data = ring.data() + text;
+        // Everything taken fits in the ring, so only one record can wrap around its end
+        if (text + size > ring.size())
+        {
+            scratch.resize(size);
+            copyOut(text, &scratch[0], size);
+            data = scratch.data();
+        }
+        lines.push_back(parse(data, size));
+        deliverOffset = (text + size) % ring.size();
+    }
+
+    uint64_t skippedNow = skipped - skippedBefore;
+    skippedBefore = skipped;
+    return skippedNow;
+}
+
+std::string StderrLog::tail() const
+{
+    std::string text;
+    text.reserve(used);
+    size_t offset = start;
+    for (uint64_t sequence = firstSequence; sequence < nextSequence; ++sequence)
+    {
+        uint32_t size = recordSize(offset);
+        size_t line = (offset + headerSize) % ring.size();
+        text.resize(text.size() + size);
+        copyOut(line, &text[text.size() - size], size);
+        text += '\n';
+        offset = (line + size) % ring.size();
+    }
+    return text;
+}
+
+// private
+
+void StderrLog::push(const char *data, size_t size)
+{
+    if (size > 0 && data[size - 1] == '\r')
+        --size;
+    size = std::min(size, ring.size() - headerSize);
+    while (used + headerSize + size > ring.size())
+        dropOldest();
+
+    auto length = static_cast<uint32_t>(size);
+    size_t offset = (start + used) % ring.size();
+    copyIn(offset, reinterpret_cast<const char *>(&length), headerSize);
+    copyIn((offset + headerSize) % ring.size(), data, size);
+    used += headerSize + size;
+    ++nextSequence;
+}
+
+void StderrLog::dropOldest()
+{
+    size_t record = headerSize + recordSize(start);
+    size_t next = (start + record) % ring.size();
+    // Overwritten before the consumer took it
+    if (delivered == firstSequence)
+    {
+        deliverOffset = next;
+        ++delivered;
+        ++skipped;
+    }
+    used -= record;
+    start = next;
+    ++firstSequence;
+}
+
+void StderrLog::copyIn(size_t offset, const char *data, size_t size)
+{
+    size_t first = std::min(size, ring.size() - offset);
+    memcpy(&ring[offset], data, first);
+    memcpy(&ring[0], data + first, size - first);
+}
+
+void StderrLog::copyOut(size_t offset, char *out, size_t size) const
+{
+    size_t first = std::min(size, ring.size() - offset);
+    memcpy(out, ring.data() + offset, first);
+    memcpy(out + first, ring.data(), size - first);
+}
+
+uint32_t StderrLog::recordSize(size_t offset) const
+{
+    uint32_t size = 0;
+    copyOut(offset, reinterpret_cast<char *>(&size), headerSize);
+    return size;
+}
+
+LogLine StderrLog::parse(const char *data, size_t size) const
+{
+    LogLine line;
+    line.line = string_ref(data, size);
+    line.text = line.line;
+    if (!settings.parseLevels || size < 3 || data[1] != '[')
+        return line;
+
+    LogLevel level;
+    switch (data[0])
+    {
+    case 'E':
+        level = LogLevel::Error;
+        break;
+    case 'I':
+        level = LogLevel::Info;
+        break;
+    case 'V':
+        level = LogLevel::Verbose;
+        break;
+    case 'D':
+        level = LogLevel::Debug;
+        break;
+    default:
+        return line;
+    }
+    auto close = static_cast<const char *>(memchr(data + 2, ']', std::min(size, maxPrefixBytes) - 2));
+    if (close == nullptr)
+        return line;
+
+    const char *text = close + 1;
+    if (text < data + size && *text == ' ')
+        ++text;
+    line.level = level;
+    line.time = string_ref(data + 2, static_cast<size_t>(close - data - 2));
+    line.text = string_ref(text, static_cast<size_t>(data + size - text));
+    return line;
+}
@@ -0,0 +1,354 @@
+#include <LSPSymbolCache.hpp>
+#include <LSPJson.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <set>
+
+#include "MappedFile.hpp"
+
+#include <sys/stat.h>
+
+namespace
+{
+
+const char magic[8] = {'L', 'S', 'P', 'S', 'Y', 'M', 'C', '1'};
+const uint32_t formatVersion = 1;
+const size_t headerSize = sizeof(magic) + 2 * sizeof(uint32_t);
+const size_t indexEntrySize = 4 * sizeof(uint64_t);
+
+enum EntryKind : char
+{
+    DocumentSymbols = 'd',
+    WorkspaceSymbols = 'w',
+};
+
+uint64_t keyOf(EntryKind kind, const std::string &name)
+{
+    char prefix = kind;
+    uint64_t hash = SymbolCache::contentHash(&prefix, 1);
+    for (unsigned char ch : name)
+    {
+        hash ^= ch;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t read64(const char *data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+struct FileStamp
+{
+    int64_t size = -1;
+    int64_t mtime = 0;
+};
+
+FileStamp stampOf(const std::string &path)
+{
+    FileStamp stamp;
+    struct stat st
+    {
+    };
+    if (::stat(path.c_str(), &st) == 0)
+    {
+        stamp.size = static_cast<int64_t>(st.st_size);
+        stamp.mtime = static_cast<int64_t>(st.st_mtime);
+    }
+    return stamp;
+}
+
+bool hashFile(const std::string &path, uint64_t &hash)
+{
+    MappedFile file(path);
+    if (!file.ok)
+        return false;
+    hash = SymbolCache::contentHash(file.data, file.size);
+    return true;
+}
+
+} // namespace
+
+SymbolCache::SymbolCache(std::string path) : path(std::move(path))
+{
+    load();
+}
+
+SymbolCache::~SymbolCache() = default;
+
+uint64_t SymbolCache::contentHash(const char *data, size_t size)
+{
+    // FNV-1a, stable across runs and platforms
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void SymbolCache::load()
+{
+    index = nullptr;
+    mappedCount = 0;
+    mapped.reset(new MappedFile(path));
+    if (!mapped->ok || mapped->size < headerSize || memcmp(mapped->data, magic, sizeof(magic)) != 0)
+    {
+        mapped.reset();
+        return;
+    }
+    uint32_t version, count;
+    memcpy(&version, mapped->data + sizeof(magic), sizeof(version));
+    memcpy(&count, mapped->data + sizeof(magic) + sizeof(version), sizeof(count));
+    if (version != formatVersion || mapped->size < headerSize + count * indexEntrySize)
+    {
+        mapped.reset();
+        return;
+    }
+    index = mapped->data + headerSize;
+    mappedCount = count;
+}
+
+bool SymbolCache::find(uint64_t key, uint64_t &hash, const uint8_t *&blob, size_t &blobSize) const
+{
+    size_t low = 0, high = mappedCount;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        uint64_t midKey = read64(index + mid * indexEntrySize);
+        if (midKey < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low == mappedCount || read64(index + low * indexEntrySize) != key)
+        return false;
+
+    const char *entry = index + low * indexEntrySize;
+    hash = read64(entry + 8);
+    uint64_t offset = read64(entry + 16);
+    uint64_t size = read64(entry + 24);
+    if (offset > mapped->size || size > mapped->size - offset)
+        return false;
+    blob = reinterpret_cast<const uint8_t *>(mapped->data + offset);
+    blobSize = static_cast<size_t>(size);
+    return true;
+}
+
+bool SymbolCache::lookup(uint64_t key, const std::string &name, const uint64_t *expectedHash, json &entry)
+{
+    uint64_t hash = 0;
+    const uint8_t *blob = nullptr;
+    size_t blobSize = 0;
+
+    auto it = updated.find(key);
+    if (it != updated.end())
+    {
+        hash = it->second.contentHash;
+        blob = it->second.blob.data();
+        blobSize = it->second.blob.size();
+    }
+    else if (removed.count(key) != 0 || !find(key, hash, blob, blobSize))
+    {
+        return false;
+    }
+
+    if (expectedHash != nullptr && *expectedHash != hash)
+        return false;
+    entry = json::from_cbor(blob, blob + blobSize, true, false);
+    if (entry.is_discarded() || !entry.is_object() || entry.value("name", std::string()) != name)
+        return false;
+    return true;
+}
+
+void SymbolCache::store(uint64_t key, uint64_t hash, json entry)
+{
+    auto inserted = updated.emplace(key, Entry());
+    Entry &e = inserted.first->second;
+    if (inserted.second)
+        updatedBytes += sizeof(Entry) + sizeof(key) + sizeof(void *);
+    updatedBytes -= e.blob.size();
+    e.contentHash = hash;
+    e.blob = json::to_cbor(entry);
+    updatedBytes += e.blob.size();
+    removed.erase(key);
+}
+
+void SymbolCache::remove(uint64_t key)
+{
+    auto it = updated.find(key);
+    if (it != updated.end())
+    {
+        updatedBytes -= sizeof(Entry) + sizeof(key) + sizeof(void *) + it->second.blob.size();
+        updated.erase(it);
+    }
+    removed.insert(key);
+}
+
+bool SymbolCache::lookupDocumentSymbols(const std::string &uri, uint64_t hash, json &result)
+{
+    json entry;
+    if (!lookup(keyOf(DocumentSymbols, uri), uri, &hash, entry))
+        return false;
+    result = std::move(entry["result"]);
+    return true;
+}
+
+void SymbolCache::storeDocumentSymbols(const std::string &uri, uint64_t hash, const json &result)
+{
+    store(keyOf(DocumentSymbols, uri), hash, {{"name", uri}, {"result", result}});
+}
+
+bool SymbolCache::lookupWorkspaceSymbols(const std::string &query, json &result)
+{
+    uint64_t key = keyOf(WorkspaceSymbols, query);
+    json entry;
+    if (!lookup(key, query, nullptr, entry))
+        return false;
+
+    // Lazy validation: a cheap stat per file, hashing only those whose size or mtime moved.
+    bool restamped = false;
+    for (auto &stamp : entry["stamps"])
+    {
+        std::string file = URIForFile::UriToPath(stamp.value("uri", std::string()));
+        FileStamp now = stampOf(file);
+        if (now.size == stamp.value("size", int64_t(-1)) && now.mtime == stamp.value("mtime", int64_t(0)))
+            continue;
+        uint64_t hash = 0;
+        if (now.size < 0 || !hashFile(file, hash) || hash != stamp.value("hash", uint64_t(0)))
+        {
+            remove(key);
+            return false;
+        }
+        stamp["size"] = now.size;
+        stamp["mtime"] = now.mtime;
+        restamped = true;
+    }
+    result = entry["result"];
+    if (restamped)
+        store(key, 0, std::move(entry));
+    return true;
+}
+
+void SymbolCache::storeWorkspaceSymbols(const std::string &query, const json &result)
+{
+    std::set<std::string> uris;
+    if (result.is_array())
+    {
+        for (auto &symbol : result)
+        {
+            auto location = symbol.find("location");
+            if (location != symbol.end() && location->contains("uri"))
+                uris.insert(location->at("uri").get<std::string>());
+        }
+    }
+
+    json stamps = json::array();
+    for (auto &uri : uris)
+    {
+        std::string file = URIForFile::UriToPath(uri);
+        FileStamp stamp = stampOf(file);
+        uint64_t hash = 0;
+        if (stamp.size < 0 || !hashFile(file, hash))
+            return; // Can't validate this entry later, so don't keep it.
+        stamps.push_back({{"uri", uri}, {"size", stamp.size}, {"mtime", stamp.mtime}, {"hash", hash}});
+    }
+    store(keyOf(WorkspaceSymbols, query), 0, {{"name", query}, {"stamps", std::move(stamps)}, {"result", result}});
+}
+
+void SymbolCache::invalidate(const std::string &uri)
+{
+    remove(keyOf(DocumentSymbols, uri));
+}
+
+void SymbolCache::clear()
+{
+    updated.clear();
+    updatedBytes = 0;
+    removed.clear();
+    for (uint32_t i = 0; i < mappedCount; ++i)
+        removed.insert(read64(index + i * indexEntrySize));
+}
+
+size_t SymbolCache::size() const
+{
+    size_t count = updated.size();
+    for (uint32_t i = 0; i < mappedCount; ++i)
+    {
+        uint64_t key = read64(index + i * indexEntrySize);
+        if (updated.count(key) == 0 && removed.count(key) == 0)
+            ++count;
+    }
+    return count;
+}
+
+bool SymbolCache::flush()
+{
+    struct Item
+    {
+        uint64_t key;
+        uint64_t contentHash;
+        const uint8_t *blob;
+        size_t blobSize;
+    };
+    std::vector<Item> items;
+    items.reserve(updated.size() + mappedCount);
+    for (auto &e : updated)
+        items.push_back({e.first, e.second.contentHash, e.second.blob.data(), e.second.blob.size()});
+    for (uint32_t i = 0; i < mappedCount; ++i)
+    {
+        const char *entry = index + i * indexEntrySize;
+        uint64_t key = read64(entry);
+        uint64_t offset = read64(entry + 16), size = read64(entry + 24);
+        if (updated.count(key) != 0 || removed.count(key) != 0 || offset > mapped->size ||
+            size > mapped->size - offset)
+            continue;
+        items.push_back({key, read64(entry + 8), reinterpret_cast<const uint8_t *>(mapped->data + offset),
+                         static_cast<size_t>(size)});
+    }
+    std::sort(items.begin(), items.end(), [](const Item &lhs, const Item &rhs) { return lhs.key < rhs.key; });
+
+    std::string tempPath = path + ".tmp";
+    FILE *out = std::fopen(tempPath.c_str(), "wb");
+    if (out == nullptr)
+        return false;
+
+    auto count = static_cast<uint32_t>(items.size());
+    bool ok = std::fwrite(magic, sizeof(magic), 1, out) == 1 &&
+              std::fwrite(&formatVersion, sizeof(formatVersion), 1, out) == 1 &&
+              std::fwrite(&count, sizeof(count), 1, out) == 1;
+    uint64_t offset = headerSize + items.size() * indexEntrySize;
+    for (auto &item : items)
+    {
+        uint64_t entry[4] = {item.key, item.contentHash, offset, item.blobSize};
+        ok = ok && std::fwrite(entry, sizeof(entry), 1, out) == 1;
+        offset += item.blobSize;
+    }
+    for (auto &item : items)
+        ok = ok && (item.blobSize == 0 || std::fwrite(item.blob, item.blobSize, 1, out) == 1);
+    ok = std::fclose(out) == 0 && ok;
+
+    // The old mapping must be gone before the file can be replaced on Windows.
+    mapped.reset();
+    index = nullptr;
+    mappedCount = 0;
+#ifdef _WIN32
+    if (ok)
+        std::remove(path.c_str());
+#endif
+    if (!ok || std::rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tempPath.c_str());
+        load();
+        return false;
+    }
+    updated.clear();
+    updatedBytes = 0;
+    removed.clear();
+    load();
+    return true;
+}
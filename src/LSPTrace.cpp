@@ -0,0 +1,274 @@
+#include <LSPTrace.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "MappedFile.hpp"
+
+namespace
+{
+
+const char magic[8] = {'L', 'S', 'P', 'T', 'R', 'A', 'C', '1'};
+const uint32_t formatVersion = 1;
+const size_t headerSize = sizeof(magic) + 2 * sizeof(uint32_t) + sizeof(int64_t);
+const size_t recordHeaderSize = sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+template <typename T> void appendValue(std::string &out, T value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> T readValue(const char *data)
+{
+    T value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Checks the header of a segment and returns its sequence number and start time
+bool readHeader(const char *data, size_t size, uint32_t &sequence, int64_t &startedWall)
+{
+    if (size < headerSize || memcmp(data, magic, sizeof(magic)) != 0 ||
+        readValue<uint32_t>(data + sizeof(magic)) != formatVersion)
+        return false;
+    sequence = readValue<uint32_t>(data + sizeof(magic) + sizeof(uint32_t));
+    startedWall = readValue<int64_t>(data + sizeof(magic) + 2 * sizeof(uint32_t));
+    return true;
+}
+
+bool readHeader(const std::string &path, uint32_t &sequence)
+{
+    FILE *in = std::fopen(path.c_str(), "rb");
+    if (in == nullptr)
+        return false;
+    char header[headerSize];
+    int64_t startedWall = 0;
+    bool ok =
+        std::fread(header, sizeof(header), 1, in) == 1 && readHeader(header, sizeof(header), sequence, startedWall);
+    std::fclose(in);
+    return ok;
+}
+
+bool fileExists(const std::string &path)
+{
+    FILE *in = std::fopen(path.c_str(), "rb");
+    if (in == nullptr)
+        return false;
+    std::fclose(in);
+    return true;
+}
+
+} // namespace
+
+// TraceRecorder
+
+TraceRecorder::TraceRecorder(std::string path, TraceOptions options) : path(std::move(path)), settings(options)
+{
+    settings.segmentCount = std::max(settings.segmentCount, 1u);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    close();
+}
+
+std::string TraceRecorder::segmentPath(const std::string &path, const TraceOptions &options, uint32_t sequence)
+{
+    if (options.segmentBytes == 0)
+        return path;
+    return path + "." + std::to_string(sequence % std::max(options.segmentCount, 1u));
+}
+
+bool TraceRecorder::open()
+{
+    close();
+    error.clear();
+
+    // Segments of an earlier recording would be mistaken for part of this one
+    if (settings.segmentBytes > 0)
+    {
+        for (uint32_t index = 0; fileExists(path + "." + std::to_string(index)); ++index)
+            std::remove((path + "." + std::to_string(index)).c_str());
+    }
+
+    sequence = 0;
+    records = 0;
+    totalBytes = 0;
+    startedAt = std::chrono::steady_clock::now();
+    startedWallMsec = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+    buffer.clear();
+    buffer.reserve(settings.bufferBytes + recordHeaderSize);
+    return startSegment();
+}
+
+void TraceRecorder::record(TraceDirection direction, const char *data, size_t size)
+{
+    if (file == nullptr || size > UINT32_MAX)
+        return;
+    uint64_t recordSize = recordHeaderSize + size;
+    if (settings.segmentBytes > 0 && segmentSize > headerSize && segmentSize + recordSize > settings.segmentBytes)
+    {
+        if (!writeBuffer())
+            return;
+        std::fclose(file);
+        file = nullptr;
+        ++sequence;
+        if (!startSegment())
+            return;
+    }
+
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startedAt);
+    appendValue(buffer, static_cast<uint8_t>(direction));
+    appendValue(buffer, static_cast<uint64_t>(micros.count()));
+    appendValue(buffer, static_cast<uint32_t>(size));
+    buffer.append(data, size);
+    segmentSize += recordSize;
+    totalBytes += recordSize;
+    ++records;
+
+    if (buffer.size() >= settings.bufferBytes)
+        writeBuffer();
+}
+
+void TraceRecorder::flush()
+{
+    if (file != nullptr && writeBuffer())
+        std::fflush(file);
+}
+
+void TraceRecorder::close()
+{
+    if (file == nullptr || !writeBuffer())
+        return;
+    if (std::fclose(file) != 0)
+        error = "cannot write " + path + ": " + std::strerror(errno);
+    file = nullptr;
+}
+
+// private
+
+bool TraceRecorder::startSegment()
+{
+    std::string segment = segmentPath(path, settings, sequence);
+    file = std::fopen(segment.c_str(), "wb");
+    if (file == nullptr)
+    {
+        fail("cannot create " + segment + ": " + std::strerror(errno));
+        return false;
+    }
+    buffer.append(magic, sizeof(magic));
+    appendValue(buffer, formatVersion);
+    appendValue(buffer, sequence);
+    appendValue(buffer, startedWallMsec);
+    segmentSize = headerSize;
+    return true;
+}
+
+bool TraceRecorder::writeBuffer()
+{
+    if (buffer.empty())
+        return true;
+    if (std::fwrite(buffer.data(), buffer.size(), 1, file) != 1)
+    {
+        fail("cannot write " + segmentPath(path, settings, sequence) + ": " + std::strerror(errno));
+        return false;
+    }
+    buffer.clear();
+    return true;
+}
+
+void TraceRecorder::fail(const std::string &message)
+{
+    error = message;
+    if (file != nullptr)
+        std::fclose(file);
+    file = nullptr;
+    buffer.clear();
+}
+
+// TraceReader
+
+TraceReader::TraceReader() = default;
+
+TraceReader::~TraceReader() = default;
+
+bool TraceReader::open(const std::string &path)
+{
+    segments.clear();
+    mapped.reset();
+    error.clear();
+
+    uint32_t sequence = 0;
+    if (readHeader(path, sequence))
+    {
+        segments.push_back(path);
+    }
+    else
+    {
+        std::vector<std::pair<uint32_t, std::string>> found;
+        for (uint32_t index = 0; fileExists(path + "." + std::to_string(index)); ++index)
+        {
+            std::string segment = path + "." + std::to_string(index);
+            if (readHeader(segment, sequence))
+                found.emplace_back(sequence, segment);
+        }
+        std::sort(found.begin(), found.end());
+        for (auto &segment : found)
+            segments.push_back(segment.second);
+    }
+
+    if (segments.empty())
+    {
+        error = "no trace at " + path;
+        return false;
+    }
+    return openSegment(0);
+}
+
+bool TraceReader::next(TraceRecord &record)
+{
+    while (mapped)
+    {
+        if (offset + recordHeaderSize <= mapped->size)
+        {
+            const char *data = mapped->data + offset;
+            auto size = readValue<uint32_t>(data + sizeof(uint8_t) + sizeof(uint64_t));
+            if (offset + recordHeaderSize + size <= mapped->size)
+            {
+                record.direction = static_cast<TraceDirection>(readValue<uint8_t>(data));
+                record.micros = readValue<uint64_t>(data + sizeof(uint8_t));
+                record.data.assign(data + recordHeaderSize, size);
+                offset += recordHeaderSize + size;
+                return true;
+            }
+        }
+        if (segmentIndex + 1 >= segments.size())
+        {
+            mapped.reset();
+            return false;
+        }
+        if (!openSegment(segmentIndex + 1))
+            return false;
+    }
+    return false;
+}
+
+// private
+
+bool TraceReader::openSegment(size_t index)
+{
+    segmentIndex = index;
+    offset = headerSize;
+    mapped.reset(new MappedFile(segments[index]));
+    uint32_t sequence = 0;
+    if (!mapped->ok || !readHeader(mapped->data, mapped->size, sequence, startedWall))
+    {
+        error = "cannot read " + segments[index];
+        mapped.reset();
+        return false;
+    }
+    return true;
+}
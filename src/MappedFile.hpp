@@ -0,0 +1,82 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <sstream>
+#endif
+
+// Read-only view over a whole file, memory mapped where the platform allows it.
+class MappedFile
+{
+  public:
+    explicit MappedFile(const std::string &path)
+    {
+#ifndef _WIN32
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st
+        {
+        };
+        if (::fstat(fd, &st) != 0)
+            return;
+        mode = st.st_mode & 07777;
+        size = static_cast<size_t>(st.st_size);
+        if (size > 0)
+        {
+            void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED)
+                return;
+            data = static_cast<const char *>(mapped);
+            isMapped = true;
+        }
+        ok = true;
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return;
+        std::ostringstream content;
+        content << in.rdbuf();
+        buffer = content.str();
+        data = buffer.data();
+        size = buffer.size();
+        ok = true;
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifndef _WIN32
+        if (isMapped)
+            ::munmap(const_cast<char *>(data), size);
+        if (fd >= 0)
+            ::close(fd);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool ok = false;
+    const char *data = "";
+    size_t size = 0;
+    unsigned mode = 0644;
+
+  private:
+#ifndef _WIN32
+    int fd = -1;
+    bool isMapped = false;
+#else
+    std::string buffer;
+#endif
+};
+
+#endif